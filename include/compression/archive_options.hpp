@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+namespace gesa::concurrency {
+class MemoryBudget;
+}
+
+namespace gesa::compression {
+
+inline constexpr std::uint64_t kDefaultSolidFileThreshold = 64U * 1024U;
+inline constexpr std::uint64_t kDefaultSolidBlockSize = 4U * 1024U * 1024U;
+
+struct DirectoryOptions {
+    std::size_t threadCount {0};
+    bool solid {false};
+    std::uint64_t solidFileThreshold {kDefaultSolidFileThreshold};
+    std::uint64_t solidBlockSize {kDefaultSolidBlockSize};
+    std::filesystem::path previousArchive;
+    bool adaptiveCodec {true};
+    // Budget for codec jobs and the outputs they keep until the archive is written;
+    // null uses the shared budget.
+    gesa::concurrency::MemoryBudget* memoryBudget {nullptr};
+};
+
+} // namespace gesa::compression
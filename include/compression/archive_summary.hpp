@@ -0,0 +1,33 @@
+#pragma once
+
+#include "compression/archive_types.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace gesa::compression {
+
+struct EntrySummary {
+    std::filesystem::path relativePath;
+    EntryKind kind {EntryKind::Payload};
+    CodecId codec {CodecId::Stored};
+    std::uint64_t originalSize {0};
+    std::uint64_t compressedSize {0};
+    std::uint32_t reference {0};
+};
+
+struct BlockSummary {
+    std::uint64_t originalSize {0};
+    std::uint64_t compressedSize {0};
+};
+
+struct ArchiveSummary {
+    std::string codec;
+    std::uint64_t archiveSize {0};
+    std::vector<BlockSummary> blocks;
+    std::vector<EntrySummary> entries;
+};
+
+} // namespace gesa::compression
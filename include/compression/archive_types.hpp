@@ -0,0 +1,26 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+
+namespace gesa::compression {
+
+enum class EntryKind : std::uint8_t {
+    Payload = 0,
+    Duplicate = 1,
+    Solid = 2
+};
+
+enum class CodecId : std::uint8_t {
+    Stored = 0,
+    Huffman = 1,
+    LZW = 2
+};
+
+inline std::int64_t toArchiveTime(std::filesystem::file_time_type time)
+{
+    return static_cast<std::int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count());
+}
+
+} // namespace gesa::compression
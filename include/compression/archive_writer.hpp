@@ -0,0 +1,48 @@
+#pragma once
+
+#include "concurrency/thread_pool.hpp"
+#include "utils/byte_view.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+namespace gesa::filesystem {
+class SourceFile;
+}
+
+namespace gesa::compression {
+
+inline constexpr std::uint64_t kArchiveWriteChunkSize = 1U << 20;
+
+// Payload bytes left in another file, such as an unchanged entry of the archive being
+// updated, and copied file to file when the archive is written.
+struct PayloadCopy {
+    const gesa::filesystem::SourceFile* source {nullptr};
+    std::uint64_t offset {0};
+    std::uint64_t size {0};
+};
+
+// One serialized block or entry: its encoded header followed by a payload that
+// stays owned by the caller until the archive is written, or by a copied one.
+struct ArchiveRecord {
+    std::vector<std::uint8_t> header;
+    gesa::utils::ByteView payload;
+    PayloadCopy copy;
+};
+
+// Groups consecutive records into write runs. offsets holds every record's start plus
+// the archive's end; a run grows while it is below kArchiveWriteChunkSize, so only its
+// last record can push it over. Returns each run's first record, then records.size().
+// Runs that fit the chunk size go out as one pwrite, longer ones record by record.
+std::vector<std::size_t> planArchiveRuns(const std::vector<std::uint64_t>& offsets);
+
+// Preallocates the archive, lets pool workers pwrite runs of records at their
+// precomputed offsets and writes the archive header last.
+void writeArchiveFile(const std::filesystem::path& destination,
+                      const std::vector<std::uint8_t>& header,
+                      const std::vector<ArchiveRecord>& records,
+                      gesa::concurrency::ThreadPool& pool);
+
+} // namespace gesa::compression
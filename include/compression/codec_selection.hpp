@@ -0,0 +1,20 @@
+#pragma once
+
+#include "utils/byte_view.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gesa::compression {
+
+inline constexpr std::size_t kSelectionWindowSize = 16U * 1024U;
+inline constexpr std::size_t kSelectionSampleLimit = 3U * kSelectionWindowSize;
+
+// Order-0 Shannon entropy in bits per byte.
+double estimateEntropyBits(const std::uint8_t* data, std::size_t size);
+
+// Head, middle and tail windows of buffers larger than kSelectionSampleLimit.
+std::vector<std::uint8_t> selectionSample(gesa::utils::ByteView data);
+
+} // namespace gesa::compression
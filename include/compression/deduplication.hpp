@@ -0,0 +1,22 @@
+#pragma once
+
+#include "concurrency/thread_pool.hpp"
+#include "filesystem/resource_context.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+namespace gesa::compression {
+
+std::uint64_t hashFileContents(const std::filesystem::path& path);
+bool fileContentsEqual(const std::filesystem::path& lhs, const std::filesystem::path& rhs);
+
+// Returns, for every descriptor, the index of the first descriptor with identical
+// contents. Unique and excluded files map to their own index.
+std::vector<std::size_t> findDuplicateSources(const std::vector<gesa::filesystem::FileDescriptor>& descriptors,
+                                              gesa::concurrency::ThreadPool& pool,
+                                              const std::vector<bool>& excluded = {});
+
+} // namespace gesa::compression
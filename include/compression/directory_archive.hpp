@@ -0,0 +1,153 @@
+#pragma once
+
+#include "compression/archive_options.hpp"
+#include "compression/archive_types.hpp"
+#include "compression/archive_writer.hpp"
+#include "compression/update.hpp"
+#include "concurrency/async.hpp"
+#include "concurrency/cancellation.hpp"
+#include "concurrency/thread_pool.hpp"
+#include "filesystem/resource_context.hpp"
+#include "utils/byte_view.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <vector>
+
+namespace gesa::filesystem {
+class SourceFile;
+}
+
+namespace gesa::compression {
+
+// The archive an update starts from, as far as reuse planning needs it.
+struct PreviousArchive {
+    std::vector<PreviousEntry> entries;
+    std::size_t blockCount {0};
+};
+
+// Where one file ends up in the new archive, decided before anything is encoded.
+struct EntryLayout {
+    EntryKind kind {EntryKind::Payload};
+    // Source entry of a duplicate.
+    std::uint32_t sourceIndex {0};
+    // Block and offset of a solid member.
+    std::uint32_t blockIndex {0};
+    std::uint64_t blockOffset {0};
+    // Previous entry whose payload is copied over, or ReusePlan::kNotReused.
+    std::size_t previous {ReusePlan::kNotReused};
+};
+
+// What compressDirectoryArchive needs from a codec. Entries and solid blocks stay in the
+// codec's own types and are addressed by position: entry i is the i-th listed file.
+// encodeBlock, encodeEntry and encodeSplit run on pool workers, at most once per
+// position; everything else runs on the calling thread.
+class DirectoryCodec {
+public:
+    static constexpr std::uint64_t kNoSplit = std::numeric_limits<std::uint64_t>::max();
+
+    virtual ~DirectoryCodec() = default;
+
+    // Reads the index of the archive being updated; reused payloads are copied out of file.
+    virtual PreviousArchive readPrevious(const std::filesystem::path& archive, const gesa::filesystem::SourceFile& file) = 0;
+    virtual void resize(std::size_t entryCount, std::size_t blockCount) = 0;
+    // New block block is previous solid block previous, carried over unchanged.
+    virtual void carryBlock(std::size_t block, std::size_t previous) = 0;
+    virtual void layoutEntry(std::size_t index, const gesa::filesystem::FileDescriptor& descriptor,
+                             const EntryLayout& layout) = 0;
+
+    virtual void encodeBlock(std::size_t block, gesa::utils::ByteView data) = 0;
+    virtual void encodeEntry(std::size_t index, gesa::utils::ByteView data) = 0;
+
+    // Payload files of at least splitThreshold() bytes go to encodeSplit instead, which
+    // encodes them block-parallel on pool and must not block on the result.
+    virtual std::uint64_t splitThreshold() const { return kNoSplit; }
+    virtual gesa::concurrency::Async<void> encodeSplit(std::size_t index, gesa::utils::ByteView data,
+                                                       gesa::concurrency::ThreadPool& pool,
+                                                       const gesa::concurrency::CancellationToken& token);
+
+    // The payload of a record stays owned by the codec until the archive is written,
+    // unless the driver moved it to a scratch file and released it early.
+    virtual ArchiveRecord blockRecord(std::size_t block) const = 0;
+    virtual ArchiveRecord entryRecord(std::size_t index) const = 0;
+    virtual void releaseBlock(std::size_t block) = 0;
+    virtual void releaseEntry(std::size_t index) = 0;
+    virtual std::vector<std::uint8_t> archiveHeader(std::size_t entryCount, std::size_t blockCount) const = 0;
+};
+
+// Lists sourceDirectory and writes it to destinationArchive through codec: reuse of an
+// unchanged previous archive, duplicate detection, solid blocks, largest-first jobs
+// admitted against the memory budget and records encoded in completion order. Finished
+// payloads keep their share of the budget until the archive is written; when the budget
+// runs out with nothing left in flight, they move to a scratch file next to the archive.
+void compressDirectoryArchive(const std::filesystem::path& sourceDirectory,
+                              const std::filesystem::path& destinationArchive,
+                              const DirectoryOptions& options, DirectoryCodec& codec);
+
+// An archive as extractDirectoryArchive needs it, in the codec's block and entry order.
+struct ExtractedBlock {
+    std::uint64_t originalSize {0};
+    std::uint64_t payloadOffset {0};
+    std::uint64_t payloadSize {0};
+};
+
+struct ExtractedEntry {
+    std::filesystem::path relativePath;
+    EntryKind kind {EntryKind::Payload};
+    // Source entry of a duplicate, block of a solid member.
+    std::uint32_t reference {0};
+    // Offset of a solid member inside its block.
+    std::uint64_t blockOffset {0};
+    std::uint64_t originalSize {0};
+    // Where a payload entry's bytes are in the archive.
+    std::uint64_t payloadOffset {0};
+    std::uint64_t payloadSize {0};
+};
+
+struct ArchiveContents {
+    std::vector<ExtractedBlock> blocks;
+    std::vector<ExtractedEntry> entries;
+};
+
+template <class Index>
+ArchiveContents describeContents(const Index& index)
+{
+    ArchiveContents contents;
+    contents.blocks.reserve(index.blocks.size());
+    for (const auto& block : index.blocks) {
+        contents.blocks.push_back({block.metadata.originalSize, block.payloadOffset, block.payloadSize});
+    }
+    contents.entries.reserve(index.entries.size());
+    for (const auto& entry : index.entries) {
+        contents.entries.push_back({entry.relativePath, entry.kind,
+                                    entry.kind == EntryKind::Duplicate ? entry.sourceIndex : entry.blockIndex,
+                                    entry.blockOffset, entry.metadata.originalSize, entry.payloadOffset,
+                                    entry.payloadSize});
+    }
+    return contents;
+}
+
+// What extractDirectoryArchive needs from a codec: the decoded bytes of a solid block or
+// payload entry, given the payload read out of the archive. Both run on pool workers, at
+// most once per position.
+class DirectoryDecoder {
+public:
+    virtual ~DirectoryDecoder() = default;
+
+    virtual std::vector<std::uint8_t> decodeBlock(std::size_t block, std::vector<std::uint8_t> payload) const = 0;
+    virtual std::vector<std::uint8_t> decodeEntry(std::size_t index, std::vector<std::uint8_t> payload) const = 0;
+};
+
+// Extracts the files of sourceArchive, described by contents, under destinationDirectory.
+// Every live solid block and payload entry is one chain: its payload is read by offset,
+// decoded on the pool, then written to every path that holds its bytes. Reads and writes
+// each run in a Stage of their own, so one job is read while others are decoded and
+// written, and no thread waits on another stage. Jobs are admitted against the shared
+// memory budget for their payload plus their decoded size.
+void extractDirectoryArchive(const std::filesystem::path& sourceArchive,
+                             const std::filesystem::path& destinationDirectory, std::size_t threadCount,
+                             const ArchiveContents& contents, const DirectoryDecoder& decoder);
+
+} // namespace gesa::compression
@@ -1,5 +1,9 @@
 #pragma once
 
+#include "compression/archive_options.hpp"
+#include "compression/archive_summary.hpp"
+#include "utils/byte_view.hpp"
+
 #include <cstddef>
 #include <cstdint>
 #include <filesystem>
@@ -15,12 +19,22 @@ struct FileInfo {
 void compressFile(const std::filesystem::path& source, const std::filesystem::path& destination);
 void decompressFile(const std::filesystem::path& source, const std::filesystem::path& destination);
 
+// The same single-file format held in memory, so chained operations need no temporary files.
+std::vector<std::uint8_t> compressToImage(gesa::utils::ByteView input);
+std::vector<std::uint8_t> decompressImage(gesa::utils::ByteView image);
+
 void compressDirectory(const std::filesystem::path& sourceDirectory,
                        const std::filesystem::path& destinationArchive,
                        std::size_t threadCount = 0);
 
+void compressDirectory(const std::filesystem::path& sourceDirectory,
+                       const std::filesystem::path& destinationArchive,
+                       const gesa::compression::DirectoryOptions& options);
+
 void decompressDirectory(const std::filesystem::path& sourceArchive,
                          const std::filesystem::path& destinationDirectory,
                          std::size_t threadCount = 0);
 
+gesa::compression::ArchiveSummary summarizeArchive(const std::filesystem::path& sourceArchive);
+
 } // namespace gesa::compression::huffman
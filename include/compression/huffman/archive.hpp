@@ -1,6 +1,8 @@
 #pragma once
 
+#include "compression/archive_writer.hpp"
 #include "compression/huffman/types.hpp"
+#include "utils/binary_io.hpp"
 
 #include <cstdint>
 #include <iosfwd>
@@ -9,11 +11,15 @@
 namespace gesa::compression::huffman {
 
 ParsedFileHeader readFileHeader(std::istream& input);
+ParsedFileHeader parseFileHeader(gesa::utils::ByteReader& reader);
 void writeFileHeader(std::ostream& output, const HuffmanMetadata& metadata, std::uint64_t compressedSize);
+std::vector<std::uint8_t> encodeFileHeader(const HuffmanMetadata& metadata, std::uint64_t compressedSize);
 
-void writeArchiveHeader(std::ostream& output, std::uint32_t fileCount);
-void writeArchiveEntry(std::ostream& output, const ArchiveEntry& entry);
-std::vector<PendingArchiveEntry> readArchive(std::istream& input);
+std::vector<std::uint8_t> encodeArchiveHeader(std::uint32_t fileCount, std::uint32_t blockCount);
+// With copy set, the payload is not in block or entry but copied from the given range.
+ArchiveRecord encodeSolidBlock(const CompressionResult& block, const PayloadCopy& copy = {});
+ArchiveRecord encodeArchiveEntry(const ArchiveEntry& entry, const PayloadCopy& copy = {});
+ArchiveIndex readArchiveIndex(std::istream& input);
 
 std::string readMagic(const std::filesystem::path& path);
 
@@ -1,13 +1,48 @@
 #pragma once
 
 #include "compression/huffman/types.hpp"
+#include "concurrency/async.hpp"
+#include "concurrency/cancellation.hpp"
+#include "concurrency/thread_pool.hpp"
+#include "utils/byte_view.hpp"
 
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
 namespace gesa::compression::huffman {
 
-CompressionResult encodeBuffer(const std::vector<std::uint8_t>& input);
+inline constexpr std::size_t kParallelBlockSize = 4U * 1024U * 1024U;
+
+CompressionResult encodeBuffer(gesa::utils::ByteView input);
+
+// Encodes one large buffer in blockSize pieces on a pool without blocking any thread:
+// the block frequency counts, the code build and the block emission are chained as
+// continuations. The output is bit-identical to encodeBuffer's and the input must
+// outlive the result. With a token, every block checks it first, so a cancelled batch
+// stops within one block per worker.
+gesa::concurrency::Async<CompressionResult> encodeAsync(gesa::utils::ByteView input, gesa::concurrency::ThreadPool& pool,
+                                                        std::size_t blockSize = kParallelBlockSize,
+                                                        const gesa::concurrency::CancellationToken* token = nullptr);
+
+// Blocking front end to encodeAsync: the constructor starts the encode and finish()
+// waits for it.
+class ParallelEncoder {
+public:
+    ParallelEncoder(gesa::utils::ByteView input, gesa::concurrency::ThreadPool& pool,
+                    std::size_t blockSize = kParallelBlockSize,
+                    const gesa::concurrency::CancellationToken* token = nullptr);
+    ~ParallelEncoder();
+
+    ParallelEncoder(const ParallelEncoder&) = delete;
+    ParallelEncoder& operator=(const ParallelEncoder&) = delete;
+
+    CompressionResult finish();
+
+private:
+    gesa::concurrency::Async<CompressionResult> pending_;
+};
+
 std::vector<std::uint8_t> decodeBuffer(const HuffmanMetadata& metadata, const std::vector<std::uint8_t>& compressed);
 
 } // namespace gesa::compression::huffman
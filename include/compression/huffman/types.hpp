@@ -1,5 +1,7 @@
 #pragma once
 
+#include "compression/archive_types.hpp"
+
 #include <array>
 #include <cstdint>
 #include <filesystem>
@@ -9,7 +11,10 @@ namespace gesa::compression::huffman {
 
 inline constexpr char kFileMagic[4] = {'G', 'H', 'U', 'F'};
 inline constexpr char kArchiveMagic[4] = {'G', 'H', 'A', 'R'};
+inline constexpr char kStreamMagic[4] = {'G', 'H', 'S', 'T'};
 inline constexpr std::uint8_t kFormatVersion = 1;
+inline constexpr std::uint8_t kArchiveFormatVersion = 5;
+inline constexpr std::uint8_t kLegacyArchiveFormatVersion = 1;
 
 using FrequencyTable = std::array<std::uint32_t, 256>;
 
@@ -31,12 +36,36 @@ struct ParsedFileHeader {
 struct ArchiveEntry {
     std::filesystem::path relativePath;
     CompressionResult result;
+    EntryKind kind {EntryKind::Payload};
+    std::uint32_t sourceIndex {0};
+    std::uint32_t blockIndex {0};
+    std::uint64_t blockOffset {0};
+    std::int64_t lastWriteTime {0};
+    CodecId codec {CodecId::Huffman};
+};
+
+struct BlockIndexEntry {
+    HuffmanMetadata metadata;
+    std::uint64_t payloadOffset {0};
+    std::uint64_t payloadSize {0};
 };
 
-struct PendingArchiveEntry {
+struct ArchiveIndexEntry {
     std::filesystem::path relativePath;
     HuffmanMetadata metadata;
-    std::vector<std::uint8_t> compressed;
+    EntryKind kind {EntryKind::Payload};
+    std::uint32_t sourceIndex {0};
+    std::uint32_t blockIndex {0};
+    std::uint64_t blockOffset {0};
+    std::int64_t lastWriteTime {0};
+    CodecId codec {CodecId::Huffman};
+    std::uint64_t payloadOffset {0};
+    std::uint64_t payloadSize {0};
+};
+
+struct ArchiveIndex {
+    std::vector<BlockIndexEntry> blocks;
+    std::vector<ArchiveIndexEntry> entries;
 };
 
 } // namespace gesa::compression::huffman
@@ -1,6 +1,8 @@
 #pragma once
 
+#include "compression/archive_writer.hpp"
 #include "compression/lzw/types.hpp"
+#include "utils/binary_io.hpp"
 
 #include <cstdint>
 #include <iosfwd>
@@ -9,10 +11,14 @@
 namespace gesa::compression::lzw {
 
 ParsedFileHeader readFileHeader(std::istream& input);
+ParsedFileHeader parseFileHeader(gesa::utils::ByteReader& reader);
 void writeFileHeader(std::ostream& output, const LZWMetadata& metadata, std::uint64_t codeCount);
+std::vector<std::uint8_t> encodeFileHeader(const LZWMetadata& metadata, std::uint64_t codeCount);
 
-void writeArchiveHeader(std::ostream& output, std::uint32_t fileCount);
-void writeArchiveEntry(std::ostream& output, const ArchiveEntry& entry);
-std::vector<PendingArchiveEntry> readArchive(std::istream& input);
+std::vector<std::uint8_t> encodeArchiveHeader(std::uint32_t fileCount, std::uint32_t blockCount);
+// With copy set, the payload is not in block or entry but copied from the given range.
+ArchiveRecord encodeSolidBlock(const CompressionResult& block, const PayloadCopy& copy = {});
+ArchiveRecord encodeArchiveEntry(const ArchiveEntry& entry, const PayloadCopy& copy = {});
+ArchiveIndex readArchiveIndex(std::istream& input);
 
 } // namespace gesa::compression::lzw
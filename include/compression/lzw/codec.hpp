@@ -1,13 +1,14 @@
 #pragma once
 
 #include "compression/lzw/types.hpp"
+#include "utils/byte_view.hpp"
 
 #include <cstdint>
 #include <vector>
 
 namespace gesa::compression::lzw {
 
-CompressionResult encodeBuffer(const std::vector<std::uint8_t>& input);
+CompressionResult encodeBuffer(gesa::utils::ByteView input);
 std::vector<std::uint8_t> decodeBuffer(const LZWMetadata& metadata, const std::vector<std::uint16_t>& codes);
 
 } // namespace gesa::compression::lzw
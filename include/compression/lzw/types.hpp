@@ -1,5 +1,7 @@
 #pragma once
 
+#include "compression/archive_types.hpp"
+
 #include <cstdint>
 #include <filesystem>
 #include <vector>
@@ -8,7 +10,10 @@ namespace gesa::compression::lzw {
 
 inline constexpr char kFileMagic[4] = {'G', 'L', 'Z', 'W'};
 inline constexpr char kArchiveMagic[4] = {'G', 'L', 'Z', 'A'};
+inline constexpr char kStreamMagic[4] = {'G', 'L', 'S', 'T'};
 inline constexpr std::uint8_t kFormatVersion = 1;
+inline constexpr std::uint8_t kArchiveFormatVersion = 5;
+inline constexpr std::uint8_t kLegacyArchiveFormatVersion = 1;
 inline constexpr std::uint16_t kInitialDictionarySize = 256;
 inline constexpr std::uint16_t kMaxDictionarySize = 4096;
 
@@ -31,12 +36,37 @@ struct ArchiveEntry {
     std::filesystem::path relativePath;
     LZWMetadata metadata;
     std::vector<std::uint16_t> codes;
+    std::vector<std::uint8_t> stored;
+    EntryKind kind {EntryKind::Payload};
+    std::uint32_t sourceIndex {0};
+    std::uint32_t blockIndex {0};
+    std::uint64_t blockOffset {0};
+    std::int64_t lastWriteTime {0};
+    CodecId codec {CodecId::LZW};
+};
+
+struct BlockIndexEntry {
+    LZWMetadata metadata;
+    std::uint64_t payloadOffset {0};
+    std::uint64_t payloadSize {0};
 };
 
-struct PendingArchiveEntry {
+struct ArchiveIndexEntry {
     std::filesystem::path relativePath;
     LZWMetadata metadata;
-    std::vector<std::uint16_t> codes;
+    EntryKind kind {EntryKind::Payload};
+    std::uint32_t sourceIndex {0};
+    std::uint32_t blockIndex {0};
+    std::uint64_t blockOffset {0};
+    std::int64_t lastWriteTime {0};
+    CodecId codec {CodecId::LZW};
+    std::uint64_t payloadOffset {0};
+    std::uint64_t payloadSize {0};
+};
+
+struct ArchiveIndex {
+    std::vector<BlockIndexEntry> blocks;
+    std::vector<ArchiveIndexEntry> entries;
 };
 
 } // namespace gesa::compression::lzw
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "concurrency/cancellation.hpp"
+#include "concurrency/completion_queue.hpp"
+#include "concurrency/memory_budget.hpp"
+#include "concurrency/thread_pool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace gesa::compression {
+
+inline constexpr std::uint64_t kTaskGroupBytes = 1U * 1024U * 1024U;
+inline constexpr std::size_t kTaskGroupSize = 64;
+
+// Expected peak memory of compressing inputBytes: the input plus an output of similar size.
+inline constexpr std::uint64_t compressionFootprint(std::uint64_t inputBytes)
+{
+    return 2U * inputBytes;
+}
+
+// How a solid block is named in failure reports.
+std::string solidBlockName(std::size_t block);
+
+// Admission of one run's jobs against a MemoryBudget. A job's compressionFootprint is
+// reserved on the submitting thread before it touches its input; once the job finishes,
+// the whole reservation is handed over to held[key], where the consumer trims it to the
+// output it keeps until that output is written.
+class JobBudget {
+public:
+    // makeRoom runs on the submitting thread whenever a footprint does not fit. It frees
+    // some of the budget, e.g. by taking in finished jobs, and returns false once there is
+    // nothing left to free; admission then blocks like MemoryBudget::reserve.
+    JobBudget(gesa::concurrency::MemoryBudget& budget, std::vector<gesa::concurrency::MemoryReservation>& held,
+              std::function<bool()> makeRoom);
+
+    gesa::concurrency::MemoryReservation admit(std::uint64_t cost);
+    // Nothing instead of making room when the footprint does not fit right away.
+    std::optional<gesa::concurrency::MemoryReservation> tryAdmit(std::uint64_t cost);
+
+    // Called by the job itself, once per key, before it reports its completion.
+    void handOver(std::size_t key, gesa::concurrency::MemoryReservation reservation);
+
+private:
+    gesa::concurrency::MemoryBudget& budget_;
+    std::vector<gesa::concurrency::MemoryReservation>& held_;
+    std::function<bool()> makeRoom_;
+};
+
+// key is what the task reports to the completion queue once it has finished.
+struct ScheduledTask {
+    std::size_t key {0};
+    std::string name;
+    std::uint64_t cost {0};
+    std::function<void()> run;
+};
+
+// Queues tasks longest-processing-time first; equal costs keep their original order.
+// Each task is admitted through budget, so this call waits while the budget is exhausted.
+// Tasks run through token: once one fails, the rest are skipped instead of queued or run.
+// Only queued tasks report to completions.
+void enqueueLargestFirst(std::vector<ScheduledTask> tasks, gesa::concurrency::ThreadPool& pool, JobBudget& budget,
+                         gesa::concurrency::CancellationToken& token,
+                         gesa::concurrency::CompletionQueue& completions);
+
+// Gathers small tasks and queues them as one pool task once kTaskGroupBytes or
+// kTaskGroupSize is reached, so tiny files do not each pay the queueing overhead.
+// Reservations are taken per task and travel with the group.
+class TaskGroup {
+public:
+    // Runs on the worker before the group's first task, e.g. to read every member's input
+    // in one batch where it is encoded. A failure fails the first member and skips the rest.
+    using Load = std::function<void(const std::vector<ScheduledTask>& group)>;
+
+    TaskGroup(gesa::concurrency::ThreadPool& pool, JobBudget& budget, gesa::concurrency::CancellationToken& token,
+              gesa::concurrency::CompletionQueue& completions, Load load = {});
+
+    void add(ScheduledTask task);
+    void flush();
+
+private:
+    gesa::concurrency::ThreadPool& pool_;
+    JobBudget& budget_;
+    gesa::concurrency::CancellationToken& token_;
+    gesa::concurrency::CompletionQueue& completions_;
+    Load load_;
+    std::vector<ScheduledTask> pending_;
+    std::vector<gesa::concurrency::MemoryReservation> reservations_;
+    std::uint64_t pendingCost_ {0};
+};
+
+} // namespace gesa::compression
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "compression/archive_options.hpp"
+#include "filesystem/resource_context.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gesa::compression {
+
+struct SolidBlockPlan {
+    std::vector<std::size_t> members;
+    std::vector<std::uint64_t> offsets;
+    std::uint64_t size {0};
+};
+
+// Groups unique, non-excluded files no larger than the solid threshold into blocks
+// of roughly solidBlockSize bytes, keeping directory order inside every block.
+std::vector<SolidBlockPlan> planSolidBlocks(const std::vector<gesa::filesystem::FileDescriptor>& descriptors,
+                                            const std::vector<std::size_t>& duplicateSources,
+                                            const DirectoryOptions& options,
+                                            const std::vector<bool>& excluded = {});
+
+std::vector<std::uint8_t> readSolidBlock(const SolidBlockPlan& plan,
+                                         const std::vector<gesa::filesystem::FileDescriptor>& descriptors);
+
+} // namespace gesa::compression
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "utils/frame_stream.hpp"
+
+#include <cstddef>
+#include <memory>
+
+namespace gesa::compression {
+
+enum class StreamCodec {
+    Huffman,
+    LZW
+};
+
+// Compresses everything written to the returned sink into the codec's framed stream
+// format, one independently coded frame per chunkSize bytes of input.
+std::unique_ptr<gesa::utils::ByteSink> makeCompressingSink(StreamCodec codec, gesa::utils::ByteSink& output,
+                                                           std::size_t chunkSize = gesa::utils::kStreamChunkSize);
+
+std::unique_ptr<gesa::utils::ByteSink> makeDecompressingSink(StreamCodec codec, gesa::utils::ByteSink& output);
+
+} // namespace gesa::compression
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "compression/archive_types.hpp"
+#include "filesystem/resource_context.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace gesa::compression {
+
+// One entry of the archive being updated, reduced to what reuse decisions need.
+struct PreviousEntry {
+    std::string relativePath;
+    EntryKind kind {EntryKind::Payload};
+    std::uint64_t originalSize {0};
+    std::int64_t lastWriteTime {0};
+    // Source entry of a duplicate, block of a solid member.
+    std::uint32_t reference {0};
+    // Offset of a solid member inside its block.
+    std::uint64_t blockOffset {0};
+};
+
+// Which files of this run take over their unchanged entry of the previous archive.
+struct ReusePlan {
+    static constexpr std::size_t kNotReused = std::numeric_limits<std::size_t>::max();
+
+    // Per descriptor: the previous entry it takes over, or kNotReused.
+    std::vector<std::size_t> previous;
+    // Per descriptor: the new block of a reused solid member, or the descriptor a reused
+    // duplicate refers to.
+    std::vector<std::size_t> reference;
+    // Previous solid blocks carried over whole; new block i is previous block blocks[i].
+    std::vector<std::size_t> blocks;
+
+    bool reused(std::size_t index) const noexcept { return previous[index] != kNotReused; }
+    std::vector<bool> reusedMask() const;
+};
+
+// Matches files to previous entries by path, size and mtime. Payload entries are reused
+// on their own; a solid block only when reuseSolidBlocks is set and every one of its
+// members matched; a duplicate only when its source is reused as well.
+ReusePlan planReuse(const std::vector<gesa::filesystem::FileDescriptor>& descriptors,
+                    const std::vector<PreviousEntry>& previous, std::size_t previousBlockCount,
+                    bool reuseSolidBlocks);
+
+template <class Index>
+std::vector<PreviousEntry> describePrevious(const Index& index)
+{
+    std::vector<PreviousEntry> entries;
+    entries.reserve(index.entries.size());
+    for (const auto& entry : index.entries) {
+        entries.push_back({entry.relativePath.generic_string(), entry.kind, entry.metadata.originalSize, entry.lastWriteTime,
+                           entry.kind == EntryKind::Duplicate ? entry.sourceIndex : entry.blockIndex, entry.blockOffset});
+    }
+    return entries;
+}
+
+} // namespace gesa::compression
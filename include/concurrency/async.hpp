@@ -0,0 +1,357 @@
+#pragma once
+
+#include "concurrency/task.hpp"
+#include "concurrency/thread_pool.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace gesa::concurrency {
+
+template <class T>
+class Async;
+
+namespace detail {
+
+template <class T>
+using AsyncValue = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+template <class T>
+struct IsAsync : std::false_type {
+};
+
+template <class T>
+struct IsAsync<Async<T>> : std::true_type {
+};
+
+template <class Raw>
+struct Flattened {
+    using type = Raw;
+};
+
+template <class T>
+struct Flattened<Async<T>> {
+    using type = T;
+};
+
+template <class T>
+struct Joined {
+    using type = std::vector<T>;
+};
+
+template <>
+struct Joined<void> {
+    using type = void;
+};
+
+template <class Function, class T>
+struct ContinuationResult {
+    using type = std::invoke_result_t<Function&, T>;
+};
+
+template <class Function>
+struct ContinuationResult<Function, void> {
+    using type = std::invoke_result_t<Function&>;
+};
+
+// Completed once, then read by at most one continuation. The continuation runs on the
+// thread that completes the state, or at once when it is attached afterwards.
+template <class T>
+class AsyncState {
+public:
+    void setValue(AsyncValue<T> value) { complete(std::move(value), nullptr); }
+    void setError(std::exception_ptr error) { complete(std::nullopt, std::move(error)); }
+
+    void onReady(Task continuation)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!done_) {
+                continuation_ = std::move(continuation);
+                return;
+            }
+        }
+        continuation();
+    }
+
+    void wait() const
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ready_.wait(lock, [this]() { return done_; });
+    }
+
+    // Only meaningful once the state is complete.
+    const std::exception_ptr& error() const noexcept { return error_; }
+    AsyncValue<T> take() { return std::move(*value_); }
+
+private:
+    void complete(std::optional<AsyncValue<T>> value, std::exception_ptr error)
+    {
+        Task continuation;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            value_ = std::move(value);
+            error_ = std::move(error);
+            done_ = true;
+            continuation = std::move(continuation_);
+            ready_.notify_all();
+        }
+        if (continuation) {
+            continuation();
+        }
+    }
+
+    mutable std::mutex mutex_;
+    mutable std::condition_variable ready_;
+    bool done_ {false};
+    std::optional<AsyncValue<T>> value_;
+    std::exception_ptr error_;
+    Task continuation_;
+};
+
+struct AsyncAccess {
+    template <class T>
+    static const std::shared_ptr<AsyncState<T>>& state(const Async<T>& async) noexcept
+    {
+        return async.state_;
+    }
+
+    template <class T>
+    static Async<T> adopt(std::shared_ptr<AsyncState<T>> state) noexcept
+    {
+        Async<T> async;
+        async.state_ = std::move(state);
+        return async;
+    }
+
+    // Completes target with whatever source completes with. Like then(), the continuation
+    // holds the source by address only: owning it from its own continuation would keep a
+    // source that never completes alive forever.
+    template <class T>
+    static void forward(Async<T> source, std::shared_ptr<AsyncState<T>> target)
+    {
+        auto* state = source.state_.get();
+        state->onReady(Task([state, target = std::move(target)]() {
+            if (state->error()) {
+                target->setError(state->error());
+            } else {
+                target->setValue(state->take());
+            }
+        }));
+    }
+};
+
+template <class Raw, class Result, class Work, class... Args>
+void fulfil(const std::shared_ptr<AsyncState<Result>>& state, Work& work, Args&&... args) noexcept
+{
+    try {
+        if constexpr (IsAsync<Raw>::value) {
+            AsyncAccess::forward(work(std::forward<Args>(args)...), state);
+        } else if constexpr (std::is_void_v<Raw>) {
+            work(std::forward<Args>(args)...);
+            state->setValue({});
+        } else {
+            state->setValue(work(std::forward<Args>(args)...));
+        }
+    } catch (...) {
+        state->setError(std::current_exception());
+    }
+}
+
+} // namespace detail
+
+// The eventual result of a task graph node. Unlike std::future, nothing has to block on
+// it: then() attaches the next step, which is scheduled when this one completes.
+template <class T>
+class Async {
+public:
+    Async() = default;
+    Async(Async&&) noexcept = default;
+    Async& operator=(Async&&) noexcept = default;
+    Async(const Async&) = delete;
+    Async& operator=(const Async&) = delete;
+
+    template <class... Value>
+    static Async ready(Value&&... value)
+    {
+        auto state = std::make_shared<detail::AsyncState<T>>();
+        state->setValue(detail::AsyncValue<T>(std::forward<Value>(value)...));
+        return detail::AsyncAccess::adopt(std::move(state));
+    }
+
+    bool valid() const noexcept { return state_ != nullptr; }
+
+    // Consumes this node and schedules function(value) on scheduler, a ThreadPool or a
+    // Stage, once it completes. A failure skips function and passes straight through.
+    // When function returns an Async itself, the result completes along with it.
+    template <class Scheduler, class Function>
+    auto then(Scheduler& scheduler, Function&& function);
+
+    void wait() const { state_->wait(); }
+
+    // Blocks for the value and rethrows a failure; for the thread that ends the graph.
+    T get()
+    {
+        state_->wait();
+        auto state = std::move(state_);
+        if (state->error()) {
+            std::rethrow_exception(state->error());
+        }
+        if constexpr (!std::is_void_v<T>) {
+            return state->take();
+        }
+    }
+
+private:
+    friend struct detail::AsyncAccess;
+
+    std::shared_ptr<detail::AsyncState<T>> state_;
+};
+
+template <class T>
+template <class Scheduler, class Function>
+auto Async<T>::then(Scheduler& scheduler, Function&& function)
+{
+    using Work = std::decay_t<Function>;
+    using Raw = typename detail::ContinuationResult<Work, T>::type;
+    using Result = typename detail::Flattened<Raw>::type;
+
+    auto next = std::make_shared<detail::AsyncState<Result>>();
+    auto source = std::move(state_);
+    // The source completes this continuation, so it is still alive whenever it runs.
+    auto* self = source.get();
+    self->onReady(Task([self, next, &scheduler, work = Work(std::forward<Function>(function))]() mutable {
+        if (self->error()) {
+            next->setError(self->error());
+            return;
+        }
+        try {
+            if constexpr (std::is_void_v<T>) {
+                scheduler.post([next, work = std::move(work)]() mutable { detail::fulfil<Raw>(next, work); });
+            } else {
+                scheduler.post([next, work = std::move(work), value = self->take()]() mutable {
+                    detail::fulfil<Raw>(next, work, std::move(value));
+                });
+            }
+        } catch (...) {
+            next->setError(std::current_exception());
+        }
+    }));
+    return detail::AsyncAccess::adopt(std::move(next));
+}
+
+// Runs function on scheduler as the root of a graph.
+template <class Scheduler, class Function>
+auto async(Scheduler& scheduler, Function&& function)
+{
+    return Async<void>::ready().then(scheduler, std::forward<Function>(function));
+}
+
+// Completes once every input has, with their values in input order. When inputs fail,
+// it still waits for all of them and then fails with the first failure to complete.
+template <class T>
+auto whenAll(std::vector<Async<T>> inputs)
+{
+    using Result = typename detail::Joined<T>::type;
+    using Slots = std::vector<std::optional<detail::AsyncValue<T>>>;
+
+    struct Join {
+        std::mutex mutex;
+        std::size_t remaining {0};
+        std::exception_ptr error;
+        Slots values;
+        std::shared_ptr<detail::AsyncState<Result>> output = std::make_shared<detail::AsyncState<Result>>();
+
+        void finish()
+        {
+            if (error) {
+                output->setError(error);
+                return;
+            }
+            if constexpr (std::is_void_v<T>) {
+                output->setValue({});
+            } else {
+                std::vector<T> collected;
+                collected.reserve(values.size());
+                for (auto& value : values) {
+                    collected.push_back(std::move(*value));
+                }
+                output->setValue(std::move(collected));
+            }
+        }
+    };
+
+    auto join = std::make_shared<Join>();
+    join->remaining = inputs.size();
+    join->values.resize(inputs.size());
+    auto result = detail::AsyncAccess::adopt(join->output);
+    if (inputs.empty()) {
+        join->finish();
+        return result;
+    }
+
+    for (std::size_t index = 0; index < inputs.size(); ++index) {
+        auto* state = detail::AsyncAccess::state(inputs[index]).get();
+        state->onReady(Task([join, index, state]() {
+            bool last = false;
+            {
+                std::lock_guard<std::mutex> lock(join->mutex);
+                if (state->error()) {
+                    if (!join->error) {
+                        join->error = state->error();
+                    }
+                } else if constexpr (!std::is_void_v<T>) {
+                    join->values[index].emplace(state->take());
+                }
+                last = --join->remaining == 0U;
+            }
+            if (last) {
+                join->finish();
+            }
+        }));
+    }
+    return result;
+}
+
+// Caps how many jobs of one pipeline stage run at once. Jobs beyond the limit wait in the
+// stage rather than on a thread; a worker that finishes a job picks up the next waiting
+// one itself. Jobs must not throw, and the stage must outlive them.
+class Stage {
+public:
+    Stage(ThreadPool& pool, std::size_t limit);
+
+    // Waits until no job of the stage is running or waiting.
+    ~Stage();
+
+    Stage(const Stage&) = delete;
+    Stage& operator=(const Stage&) = delete;
+
+    template <class Callable>
+    void post(Callable&& job)
+    {
+        schedule(Task(std::forward<Callable>(job)));
+    }
+
+    std::size_t limit() const noexcept { return limit_; }
+
+private:
+    void schedule(Task job);
+
+    ThreadPool& pool_;
+    std::size_t limit_;
+    std::mutex mutex_;
+    std::condition_variable idle_;
+    std::deque<Task> waiting_;
+    std::size_t running_ {0};
+};
+
+} // namespace gesa::concurrency
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace gesa::concurrency {
+
+// Raised by work that noticed its batch was cancelled.
+class OperationCancelled : public std::runtime_error {
+public:
+    OperationCancelled();
+};
+
+// The first failure of a batch of jobs, plus the jobs that were skipped because of it.
+class BatchFailure : public std::runtime_error {
+public:
+    BatchFailure(std::string job, std::exception_ptr cause, std::vector<std::string> skipped);
+
+    const std::string& job() const noexcept { return job_; }
+    const std::exception_ptr& cause() const noexcept { return cause_; }
+    const std::vector<std::string>& skipped() const noexcept { return skipped_; }
+
+private:
+    std::string job_;
+    std::exception_ptr cause_;
+    std::vector<std::string> skipped_;
+};
+
+// Shared by the jobs of one batch. The first failure cancels the batch; jobs that start
+// afterwards skip their work, and long-running ones poll cancelled() between blocks.
+class CancellationToken {
+public:
+    bool cancelled() const noexcept { return cancelled_.load(std::memory_order_relaxed); }
+    void cancel() noexcept { cancelled_.store(true, std::memory_order_relaxed); }
+    void throwIfCancelled() const;
+
+    // Keeps the first failure only; later ones are usually consequences of it.
+    void fail(const std::string& job, std::exception_ptr error);
+    void skip(const std::string& job);
+
+    // Runs work unless the batch is already cancelled. Failures are recorded instead of
+    // thrown; returns whether the work ran to completion.
+    template <class Work>
+    bool run(const std::string& job, Work&& work) noexcept;
+
+    // Throws BatchFailure when a job failed, OperationCancelled after a bare cancel().
+    void rethrowIfFailed() const;
+
+private:
+    std::atomic<bool> cancelled_ {false};
+    mutable std::mutex mutex_;
+    std::string failedJob_;
+    std::exception_ptr error_;
+    std::vector<std::string> skipped_;
+};
+
+template <class Work>
+bool CancellationToken::run(const std::string& job, Work&& work) noexcept
+{
+    try {
+        if (cancelled()) {
+            skip(job);
+            return false;
+        }
+        std::forward<Work>(work)();
+        return true;
+    } catch (const OperationCancelled&) {
+        skip(job);
+    } catch (...) {
+        fail(job, std::current_exception());
+    }
+    return false;
+}
+
+} // namespace gesa::concurrency
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+
+namespace gesa::concurrency {
+
+// Shared progress of one parallel loop over [begin, end) split into grain-sized chunks.
+// Any number of threads call work() to claim chunks; wait() acts as the completion latch.
+// The body is only touched while a chunk is claimed, so once wait() returns the caller's
+// callable may go away even if late helpers still hold the loop.
+class ChunkLoop {
+public:
+    using Body = void (*)(void* context, std::size_t first, std::size_t last);
+
+    ChunkLoop(std::size_t begin, std::size_t end, std::size_t grain, Body body, void* context);
+
+    std::size_t chunkCount() const noexcept { return chunkCount_; }
+
+    // Claims and runs chunks until none are left. After a failure the remaining chunks
+    // are counted off without running.
+    void work() noexcept;
+
+    // Blocks until every chunk has completed, then rethrows the first failure.
+    void wait();
+
+private:
+    std::size_t begin_;
+    std::size_t end_;
+    std::size_t grain_;
+    std::size_t chunkCount_;
+    Body body_;
+    void* context_;
+
+    std::atomic<std::size_t> next_ {0};
+    std::atomic<std::size_t> remaining_;
+    std::atomic<bool> failed_ {false};
+    std::mutex mutex_;
+    std::condition_variable done_;
+    std::exception_ptr error_;
+};
+
+} // namespace gesa::concurrency
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+
+namespace gesa::concurrency {
+
+struct Completion {
+    std::size_t key {0};
+    std::exception_ptr error;
+
+    void rethrow() const
+    {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+};
+
+// Hands out the keys of finished jobs in the order they finish, so a consumer can act
+// on each result as soon as it exists; results themselves live in caller-owned slots
+// indexed by key, which keeps the final order deterministic. Every expect() must be
+// matched by a complete(); the destructor waits for the outstanding ones.
+class CompletionQueue {
+public:
+    CompletionQueue() = default;
+    ~CompletionQueue();
+
+    CompletionQueue(const CompletionQueue&) = delete;
+    CompletionQueue& operator=(const CompletionQueue&) = delete;
+
+    // Announces count jobs that will report through complete().
+    void expect(std::size_t count = 1);
+    void complete(std::size_t key, std::exception_ptr error = nullptr);
+
+    // The next finished job, or nothing when none has finished yet.
+    std::optional<Completion> tryNext();
+    // Blocks for the next finished job; returns nothing once every expected job was delivered.
+    std::optional<Completion> next();
+    // Blocks until every expected job has completed, without delivering them.
+    void wait();
+
+    std::size_t outstanding() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<Completion> finished_;
+    std::size_t running_ {0};
+    std::size_t undelivered_ {0};
+};
+
+} // namespace gesa::concurrency
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+
+namespace gesa::concurrency {
+
+inline constexpr const char* kMemoryLimitVariable = "GSEA_MEM_LIMIT";
+
+class MemoryBudget;
+
+// Bytes held against a MemoryBudget until release() or destruction.
+class MemoryReservation {
+public:
+    MemoryReservation() = default;
+    ~MemoryReservation();
+
+    MemoryReservation(MemoryReservation&& other) noexcept;
+    MemoryReservation& operator=(MemoryReservation&& other) noexcept;
+    MemoryReservation(const MemoryReservation&) = delete;
+    MemoryReservation& operator=(const MemoryReservation&) = delete;
+
+    std::uint64_t bytes() const noexcept { return bytes_; }
+    // Folds other into this reservation; both must belong to the same budget.
+    void merge(MemoryReservation&& other);
+    // Returns everything above bytes to the budget, e.g. once a job's input is gone and
+    // only its output stays behind.
+    void shrinkTo(std::uint64_t bytes) noexcept;
+    void release() noexcept;
+
+private:
+    friend class MemoryBudget;
+    MemoryReservation(MemoryBudget* budget, std::uint64_t bytes) noexcept;
+
+    MemoryBudget* budget_ {nullptr};
+    std::uint64_t bytes_ {0};
+};
+
+// Byte-counting semaphore for admitting memory-hungry jobs. Reserve on the thread that
+// submits work, never inside a pool task: a blocked worker could be the one that would
+// run the job holding the bytes it waits for.
+class MemoryBudget {
+public:
+    // A capacity of 0 admits everything.
+    explicit MemoryBudget(std::uint64_t capacity);
+
+    MemoryBudget(const MemoryBudget&) = delete;
+    MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+    std::uint64_t capacity() const noexcept { return capacity_; }
+    std::uint64_t inUse() const;
+
+    // Blocks until the bytes fit. Requests above the capacity are clamped to it, so an
+    // oversized job runs once it is alone instead of never.
+    MemoryReservation reserve(std::uint64_t bytes);
+    // Returns nothing instead of blocking when the bytes do not fit.
+    std::optional<MemoryReservation> tryReserve(std::uint64_t bytes);
+
+private:
+    friend class MemoryReservation;
+    void release(std::uint64_t bytes) noexcept;
+    std::uint64_t clamp(std::uint64_t bytes) const noexcept;
+
+    std::uint64_t capacity_;
+    std::uint64_t used_ {0};
+    mutable std::mutex mutex_;
+    std::condition_variable released_;
+};
+
+// Parses a byte count with an optional K, M, G or T suffix (powers of 1024).
+std::uint64_t parseByteSize(const std::string& text);
+
+// Sets the shared budget's capacity before first use; 0 disables the limit. Throws
+// std::logic_error once the budget exists with a different capacity.
+void configureMemoryLimit(std::uint64_t bytes);
+
+// The configured limit, else GSEA_MEM_LIMIT, else half of the physical memory.
+MemoryBudget& sharedMemoryBudget();
+
+} // namespace gesa::concurrency
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace gesa::concurrency {
+
+// Power-of-two buckets: bucket 0 counts zeros and bucket b counts values in [2^(b-1), 2^b).
+class Histogram {
+public:
+    static constexpr std::size_t kBuckets = 48;
+
+    static std::size_t bucketOf(std::uint64_t value) noexcept;
+    // The largest value bucket can hold.
+    static std::uint64_t upperBound(std::size_t bucket) noexcept;
+
+    void add(std::size_t bucket, std::uint64_t count, std::uint64_t sum) noexcept;
+    void merge(const Histogram& other) noexcept;
+
+    std::uint64_t count() const noexcept;
+    std::uint64_t sum() const noexcept { return sum_; }
+    double mean() const noexcept;
+    // Upper bound of the bucket holding the q-quantile, q in [0, 1]; 0 when empty.
+    std::uint64_t quantile(double q) const noexcept;
+
+    const std::array<std::uint64_t, kBuckets>& buckets() const noexcept { return buckets_; }
+
+private:
+    std::array<std::uint64_t, kBuckets> buckets_ {};
+    std::uint64_t sum_ {0};
+};
+
+struct WorkerStatistics {
+    std::uint64_t tasks {0};
+    std::chrono::nanoseconds busy {0};
+    std::chrono::nanoseconds idle {0};
+
+    double utilization() const noexcept;
+};
+
+// A snapshot of a pool since it started. Times are in nanoseconds; the queue depth is
+// the number of tasks still waiting whenever a worker took one.
+struct PoolStatistics {
+    std::chrono::nanoseconds uptime {0};
+    std::vector<WorkerStatistics> workers;
+    Histogram queueWait;
+    Histogram runTime;
+    Histogram queueDepth;
+
+    std::uint64_t tasks() const noexcept;
+    double utilization() const noexcept;
+};
+
+void printStatistics(std::ostream& output, const PoolStatistics& statistics);
+
+namespace detail {
+
+// Owned by one worker, which is the only writer. Updates are relaxed load/store pairs
+// rather than read-modify-writes, so recording a task costs no locked instruction and
+// a reader merging the counters may just be a few tasks behind.
+class WorkerCounters {
+public:
+    void record(std::uint64_t waitNanos, std::uint64_t runNanos, std::uint64_t depth) noexcept;
+
+    // Adds this worker's totals to statistics; idle time is what the uptime leaves.
+    void collect(PoolStatistics& statistics) const;
+
+private:
+    struct Series {
+        std::array<std::atomic<std::uint64_t>, Histogram::kBuckets> buckets {};
+        std::atomic<std::uint64_t> sum {0};
+
+        void add(std::uint64_t value) noexcept;
+        void mergeInto(Histogram& histogram) const noexcept;
+    };
+
+    Series wait_;
+    Series run_;
+    Series depth_;
+};
+
+} // namespace detail
+
+} // namespace gesa::concurrency
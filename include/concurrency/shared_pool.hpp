@@ -0,0 +1,38 @@
+#pragma once
+
+#include "concurrency/thread_pool.hpp"
+
+#include <cstddef>
+#include <memory>
+
+namespace gesa::concurrency {
+
+inline constexpr const char* kThreadCountVariable = "GSEA_THREADS";
+
+// Sizes the shared pool; 0 restores the default. Throws std::logic_error once the pool
+// already runs with a different size.
+void configureSharedPool(std::size_t threadCount);
+
+// Overrides GSEA_AFFINITY (none, compact or scatter) for the shared pool's workers.
+// Throws std::logic_error once the pool already runs with a different placement.
+void configureSharedPlacement(Placement placement);
+
+// The configured size, else GSEA_THREADS, else the hardware concurrency.
+std::size_t sharedPoolSize();
+
+// Created on first use and shared by every subsystem for the rest of the process.
+ThreadPool& sharedPool();
+
+// The shared pool for a thread count of 0, otherwise a private pool of that many threads.
+class PoolLease {
+public:
+    explicit PoolLease(std::size_t threadCount);
+
+    ThreadPool& get() const noexcept { return *pool_; }
+
+private:
+    std::unique_ptr<ThreadPool> owned_;
+    ThreadPool* pool_ {nullptr};
+};
+
+} // namespace gesa::concurrency
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace gesa::concurrency {
+
+namespace detail {
+
+// A queued unit of work. The callable is stored inline in the derived node, so a task
+// costs exactly one allocation and a queue slot is a single pointer.
+class TaskNode {
+public:
+    // Runs the work and releases the node.
+    virtual void run() noexcept = 0;
+    // Releases the node without running it.
+    virtual void discard() noexcept = 0;
+
+    // Stamped by the pool on submission, for its queue-wait statistics.
+    std::chrono::steady_clock::time_point queuedAt;
+
+protected:
+    ~TaskNode() = default;
+};
+
+// Fire-and-forget work; an exception escaping the callable terminates, as with std::thread.
+template <class Callable>
+class CallableNode final : public TaskNode {
+public:
+    template <class F>
+    explicit CallableNode(F&& callable)
+        : callable_(std::forward<F>(callable))
+    {
+    }
+
+    void run() noexcept override
+    {
+        callable_();
+        delete this;
+    }
+
+    void discard() noexcept override { delete this; }
+
+private:
+    Callable callable_;
+};
+
+// Work whose result is delivered through a promise. When the node was placed behind the
+// promise's shared state, the future owns its memory and the node only destroys itself.
+template <class Callable, class Result>
+class PromiseNode final : public TaskNode {
+public:
+    PromiseNode(Callable&& callable, std::promise<Result>&& promise, bool ownsStorage)
+        : callable_(std::move(callable)), promise_(std::move(promise)), ownsStorage_(ownsStorage)
+    {
+    }
+
+    void run() noexcept override
+    {
+        try {
+            if constexpr (std::is_void_v<Result>) {
+                callable_();
+                promise_.set_value();
+            } else {
+                promise_.set_value(callable_());
+            }
+        } catch (...) {
+            promise_.set_exception(std::current_exception());
+        }
+        release();
+    }
+
+    // The destroyed promise reports broken_promise to the future.
+    void discard() noexcept override { release(); }
+
+private:
+    void release() noexcept
+    {
+        if (ownsStorage_) {
+            delete this;
+            return;
+        }
+        // The shared state holds this node's storage, so it must outlive the destructor.
+        auto promise = std::move(promise_);
+        this->~PromiseNode();
+    }
+
+    Callable callable_;
+    std::promise<Result> promise_;
+    bool ownsStorage_;
+};
+
+// Allocates the promise's shared state with extra trailing room for the task node and
+// reports where that room starts. Only the first allocation is extended.
+template <class T>
+class TrailingAllocator {
+public:
+    using value_type = T;
+
+    TrailingAllocator(std::size_t extraSize, std::size_t extraAlign, void** extra) noexcept
+        : extraSize_(extraSize), extraAlign_(extraAlign), extra_(extra)
+    {
+    }
+
+    template <class U>
+    TrailingAllocator(const TrailingAllocator<U>& other) noexcept
+        : extraSize_(other.extraSize_), extraAlign_(other.extraAlign_), extra_(other.extra_)
+    {
+    }
+
+    T* allocate(std::size_t count)
+    {
+        const auto head = count * sizeof(T);
+        if (*extra_ != nullptr) {
+            return static_cast<T*>(::operator new(head));
+        }
+        const auto offset = (head + extraAlign_ - 1U) / extraAlign_ * extraAlign_;
+        auto* block = static_cast<unsigned char*>(::operator new(offset + extraSize_));
+        *extra_ = block + offset;
+        return reinterpret_cast<T*>(block);
+    }
+
+    void deallocate(T* pointer, std::size_t) noexcept { ::operator delete(pointer); }
+
+    template <class U>
+    bool operator==(const TrailingAllocator<U>& other) const noexcept
+    {
+        return extra_ == other.extra_;
+    }
+
+    template <class U>
+    bool operator!=(const TrailingAllocator<U>& other) const noexcept
+    {
+        return !(*this == other);
+    }
+
+private:
+    template <class U>
+    friend class TrailingAllocator;
+
+    std::size_t extraSize_;
+    std::size_t extraAlign_;
+    void** extra_;
+};
+
+} // namespace detail
+
+// Move-only handle to a queued unit of work.
+class Task {
+public:
+    Task() = default;
+
+    template <class Callable,
+              class = std::enable_if_t<!std::is_same_v<std::decay_t<Callable>, Task>>>
+    explicit Task(Callable&& callable)
+        : node_(new detail::CallableNode<std::decay_t<Callable>>(std::forward<Callable>(callable)))
+    {
+    }
+
+    ~Task()
+    {
+        if (node_ != nullptr) {
+            node_->discard();
+        }
+    }
+
+    Task(Task&& other) noexcept
+        : node_(std::exchange(other.node_, nullptr))
+    {
+    }
+
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other) {
+            Task(std::move(other)).swap(*this);
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    // Builds a task whose result or exception is delivered through the returned future.
+    // The node is placed in the same allocation as the future's shared state.
+    template <class Callable>
+    static std::pair<Task, std::future<std::invoke_result_t<std::decay_t<Callable>&>>> withFuture(Callable&& callable)
+    {
+        using Work = std::decay_t<Callable>;
+        using Result = std::invoke_result_t<Work&>;
+        using Node = detail::PromiseNode<Work, Result>;
+        static_assert(alignof(Node) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "Over-aligned task callable");
+
+        void* storage = nullptr;
+        std::promise<Result> promise(std::allocator_arg,
+                                     detail::TrailingAllocator<unsigned char>(sizeof(Node), alignof(Node), &storage));
+        auto future = promise.get_future();
+
+        Work work(std::forward<Callable>(callable));
+        detail::TaskNode* node = storage != nullptr
+            ? static_cast<detail::TaskNode*>(new (storage) Node(std::move(work), std::move(promise), false))
+            : static_cast<detail::TaskNode*>(new Node(std::move(work), std::move(promise), true));
+        return {adopt(node), std::move(future)};
+    }
+
+    static Task adopt(detail::TaskNode* node) noexcept
+    {
+        Task task;
+        task.node_ = node;
+        return task;
+    }
+
+    detail::TaskNode* get() const noexcept { return node_; }
+    detail::TaskNode* release() noexcept { return std::exchange(node_, nullptr); }
+
+    void operator()() { std::exchange(node_, nullptr)->run(); }
+
+    explicit operator bool() const noexcept { return node_ != nullptr; }
+
+    void swap(Task& other) noexcept { std::swap(node_, other.node_); }
+
+private:
+    detail::TaskNode* node_ {nullptr};
+};
+
+} // namespace gesa::concurrency
@@ -1,12 +1,25 @@
 #pragma once
 
+#include "concurrency/chunk_loop.hpp"
+#include "concurrency/completion_queue.hpp"
+#include "concurrency/pool_statistics.hpp"
+#include "concurrency/task.hpp"
+#include "concurrency/topology.hpp"
+#include "concurrency/work_stealing_deque.hpp"
+
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstddef>
-#include <functional>
+#include <cstdint>
+#include <deque>
+#include <exception>
 #include <future>
+#include <iterator>
+#include <memory>
 #include <mutex>
-#include <queue>
 #include <thread>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -14,9 +27,15 @@
 
 namespace gesa::concurrency {
 
+// Each worker owns a Chase-Lev deque that tasks submitted from inside the pool go to;
+// submissions from other threads land in a shared injection queue. Idle workers take
+// from their own deque, then the injection queue, then steal from random victims.
+// With a placement, workers are pinned and steal within their NUMA node before crossing
+// to another, so the buffers a task first touches stay on the node that runs it.
 class ThreadPool {
 public:
-    explicit ThreadPool(std::size_t threadCount = std::thread::hardware_concurrency());
+    explicit ThreadPool(std::size_t threadCount = std::thread::hardware_concurrency(),
+                        Placement placement = Placement::None);
     ~ThreadPool();
 
     ThreadPool(const ThreadPool&) = delete;
@@ -28,18 +47,67 @@ public:
     auto enqueue(Callable&& task, Args&&... args)
         -> std::future<std::invoke_result_t<Callable, Args...>>;
 
+    // Fire-and-forget submission without a future. An exception escaping the callable
+    // terminates the process, so callables report failures themselves.
+    template <class Callable>
+    void post(Callable&& task);
+
+    // Runs the callable and reports key to completions once it has finished or thrown.
+    // A submission that fails is reported the same way instead of throwing.
+    template <class Callable>
+    void submitTo(CompletionQueue& completions, std::size_t key, Callable&& task);
+
+    // Runs function(index) for every index in [begin, end), split into chunks of grain
+    // indices; a grain of 0 picks one from the pool size. Chunks are submitted as one
+    // batch, the calling thread works through them too, and the call returns once all
+    // of them have finished, rethrowing the first exception.
+    template <class Function>
+    void parallelFor(std::size_t begin, std::size_t end, std::size_t grain, Function&& function);
+
+    // Returns function(element) for every element of a random-access range, in order.
+    template <class Range, class Function>
+    auto parallelTransform(const Range& inputs, std::size_t grain, Function&& function)
+        -> std::vector<std::invoke_result_t<Function&, decltype(*std::begin(inputs))>>;
+
     std::size_t size() const noexcept;
+    Placement placement() const noexcept { return placement_; }
+
+    // Merges every worker's counters into a snapshot covering the pool's lifetime.
+    PoolStatistics statistics() const;
 
 private:
-    using Task = std::function<void()>;
+    using TaskNode = detail::TaskNode;
+    using Clock = std::chrono::steady_clock;
 
-    void workerLoop();
+    struct Worker {
+        WorkStealingDeque<TaskNode> deque;
+        std::uint64_t seed {0};
+        WorkerSlot slot;
+        detail::WorkerCounters counters;
+    };
 
+    void submit(Task task);
+    void submitAll(std::vector<Task> tasks);
+    void runChunks(std::size_t begin, std::size_t end, std::size_t grain, ChunkLoop::Body body, void* context);
+    TaskNode* findTask(std::size_t index);
+    TaskNode* stealTask(std::size_t index);
+    TaskNode* stealFrom(std::size_t index, bool sameNode);
+    void workerLoop(std::size_t index);
+
+    Clock::time_point startedAt_ {Clock::now()};
+    Placement placement_ {Placement::None};
+    bool nodeAware_ {false};
+    std::vector<std::unique_ptr<Worker>> queues_;
     std::vector<std::thread> workers_;
-    std::queue<Task> tasks_;
-    mutable std::mutex mutex_;
+
+    std::mutex injectMutex_;
+    std::deque<TaskNode*> injected_;
+
+    std::atomic<std::size_t> pending_ {0};
+    std::atomic<std::size_t> sleepers_ {0};
+    std::mutex mutex_;
     std::condition_variable cv_;
-    bool stop_ {false};
+    std::atomic<bool> stop_ {false};
 };
 
 
@@ -48,19 +116,72 @@ auto ThreadPool::enqueue(Callable&& task, Args&&... args) -> std::future<std::in
 {
     using Result = std::invoke_result_t<Callable, Args...>;
 
-    auto packagedTask = std::make_shared<std::packaged_task<Result()>>(
-        std::bind(std::forward<Callable>(task), std::forward<Args>(args)...));
+    if constexpr (sizeof...(Args) == 0) {
+        auto [packaged, future] = Task::withFuture(std::forward<Callable>(task));
+        submit(std::move(packaged));
+        return std::move(future);
+    } else {
+        auto [packaged, future] = Task::withFuture(
+            [callable = std::decay_t<Callable>(std::forward<Callable>(task)),
+             arguments = std::make_tuple(std::forward<Args>(args)...)]() mutable -> Result {
+                return std::apply(callable, arguments);
+            });
+        submit(std::move(packaged));
+        return std::move(future);
+    }
+}
 
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        if (stop_) {
-            throw std::runtime_error("ThreadPool is stopped");
-        }
-        tasks_.emplace([packagedTask]() { (*packagedTask)(); });
+template <class Callable>
+void ThreadPool::post(Callable&& task)
+{
+    submit(Task(std::forward<Callable>(task)));
+}
+
+template <class Callable>
+void ThreadPool::submitTo(CompletionQueue& completions, std::size_t key, Callable&& task)
+{
+    completions.expect();
+    try {
+        post([&completions, key, callable = std::decay_t<Callable>(std::forward<Callable>(task))]() mutable {
+            std::exception_ptr error;
+            try {
+                callable();
+            } catch (...) {
+                error = std::current_exception();
+            }
+            completions.complete(key, std::move(error));
+        });
+    } catch (...) {
+        completions.complete(key, std::current_exception());
     }
+}
+
+template <class Function>
+void ThreadPool::parallelFor(std::size_t begin, std::size_t end, std::size_t grain, Function&& function)
+{
+    using Stored = std::remove_reference_t<Function>;
+    const ChunkLoop::Body body = [](void* context, std::size_t first, std::size_t last) {
+        auto& callable = *static_cast<Stored*>(context);
+        for (auto index = first; index < last; ++index) {
+            callable(index);
+        }
+    };
+    runChunks(begin, end, grain, body, const_cast<void*>(static_cast<const void*>(std::addressof(function))));
+}
+
+template <class Range, class Function>
+auto ThreadPool::parallelTransform(const Range& inputs, std::size_t grain, Function&& function)
+    -> std::vector<std::invoke_result_t<Function&, decltype(*std::begin(inputs))>>
+{
+    using Result = std::invoke_result_t<Function&, decltype(*std::begin(inputs))>;
+    static_assert(!std::is_same_v<Result, bool>, "std::vector<bool> elements cannot be written concurrently");
 
-    cv_.notify_one();
-    return packagedTask->get_future();
+    std::vector<Result> results(std::size(inputs));
+    const auto first = std::begin(inputs);
+    parallelFor(0, results.size(), grain, [&](std::size_t index) {
+        results[index] = function(first[static_cast<std::ptrdiff_t>(index)]);
+    });
+    return results;
 }
 
 } // namespace gesa::concurrency
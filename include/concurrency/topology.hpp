@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace gesa::concurrency {
+
+inline constexpr const char* kSysfsNodeRoot = "/sys/devices/system/node";
+inline constexpr const char* kAffinityVariable = "GSEA_AFFINITY";
+
+struct NumaNode {
+    std::size_t id {0};
+    std::vector<unsigned> cpus;
+};
+
+struct CpuTopology {
+    std::vector<NumaNode> nodes;
+
+    std::size_t cpuCount() const noexcept;
+};
+
+// None leaves workers to the scheduler; Compact fills one node before the next; Scatter
+// deals workers round-robin across nodes.
+enum class Placement {
+    None,
+    Compact,
+    Scatter,
+};
+
+struct WorkerSlot {
+    int cpu {-1};
+    std::size_t node {0};
+};
+
+// Parses a sysfs CPU list such as "0-3,8,10-11".
+std::vector<unsigned> parseCpuList(const std::string& text);
+
+// Reads nodeN/cpulist below nodeRoot, keeping only CPUs in allowedCpus (all CPUs when
+// empty). Without usable entries the result is one node holding every allowed CPU.
+CpuTopology readTopology(const std::filesystem::path& nodeRoot, const std::vector<unsigned>& allowedCpus);
+
+// The topology of the CPUs this process may run on, detected once.
+const CpuTopology& systemTopology();
+
+Placement parsePlacement(const std::string& name);
+
+// One slot per worker; every slot has cpu -1 for Placement::None.
+std::vector<WorkerSlot> planPlacement(const CpuTopology& topology, std::size_t workerCount, Placement placement);
+
+// Best effort; returns false when the platform refuses or does not support pinning.
+bool pinCurrentThread(int cpu) noexcept;
+
+} // namespace gesa::concurrency
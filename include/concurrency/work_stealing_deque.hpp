@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace gesa::concurrency {
+
+// Chase-Lev deque: the owning thread pushes and pops at the bottom without locks while
+// other threads steal from the top. Grown buffers are retired, not freed, until the
+// deque is destroyed, so a thief never reads released memory.
+template <class T>
+class WorkStealingDeque {
+public:
+    explicit WorkStealingDeque(std::size_t capacity = 256)
+    {
+        std::size_t rounded = 1;
+        while (rounded < capacity) {
+            rounded <<= 1U;
+        }
+        buffers_.push_back(std::make_unique<Buffer>(rounded));
+        buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    // Owner only.
+    void push(T* item)
+    {
+        const auto bottom = bottom_.load(std::memory_order_relaxed);
+        const auto top = top_.load(std::memory_order_acquire);
+        auto* buffer = buffer_.load(std::memory_order_relaxed);
+        if (bottom - top >= static_cast<std::int64_t>(buffer->capacity)) {
+            buffer = grow(buffer, top, bottom);
+        }
+        buffer->store(bottom, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    // Owner only; returns nullptr when empty.
+    T* pop()
+    {
+        const auto bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        auto* buffer = buffer_.load(std::memory_order_relaxed);
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto top = top_.load(std::memory_order_relaxed);
+
+        if (top > bottom) {
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        T* item = buffer->load(bottom);
+        if (top == bottom) {
+            if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                item = nullptr;
+            }
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    // Any thread; returns nullptr when empty or when another thread won the race.
+    T* steal()
+    {
+        auto top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const auto bottom = bottom_.load(std::memory_order_acquire);
+        if (top >= bottom) {
+            return nullptr;
+        }
+
+        auto* buffer = buffer_.load(std::memory_order_acquire);
+        T* item = buffer->load(top);
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return item;
+    }
+
+    bool empty() const noexcept
+    {
+        return bottom_.load(std::memory_order_relaxed) <= top_.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Buffer {
+        explicit Buffer(std::size_t size)
+            : capacity(size), mask(size - 1U), slots(new std::atomic<T*>[size])
+        {
+        }
+
+        T* load(std::int64_t index) const noexcept
+        {
+            return slots[static_cast<std::size_t>(index) & mask].load(std::memory_order_relaxed);
+        }
+
+        void store(std::int64_t index, T* item) noexcept
+        {
+            slots[static_cast<std::size_t>(index) & mask].store(item, std::memory_order_relaxed);
+        }
+
+        std::size_t capacity;
+        std::size_t mask;
+        std::unique_ptr<std::atomic<T*>[]> slots;
+    };
+
+    Buffer* grow(Buffer* current, std::int64_t top, std::int64_t bottom)
+    {
+        buffers_.push_back(std::make_unique<Buffer>(current->capacity * 2U));
+        auto* grown = buffers_.back().get();
+        for (auto index = top; index < bottom; ++index) {
+            grown->store(index, current->load(index));
+        }
+        buffer_.store(grown, std::memory_order_release);
+        return grown;
+    }
+
+    alignas(64) std::atomic<std::int64_t> top_ {0};
+    alignas(64) std::atomic<std::int64_t> bottom_ {0};
+    std::atomic<Buffer*> buffer_ {nullptr};
+    std::vector<std::unique_ptr<Buffer>> buffers_;
+};
+
+} // namespace gesa::concurrency
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "filesystem/resource_context.hpp"
+#include "utils/byte_view.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace gesa::filesystem {
+
+struct ReadRequest {
+    std::filesystem::path path;
+    std::uint64_t sizeHint {0};
+};
+
+struct WriteRequest {
+    std::filesystem::path path;
+    gesa::utils::ByteView data;
+};
+
+// Whole-file reads and writes for many files at once. Parent directories of
+// write targets are created as needed.
+class BatchIo {
+public:
+    virtual ~BatchIo() = default;
+
+    virtual const char* name() const noexcept = 0;
+    virtual std::vector<std::vector<std::uint8_t>> readFiles(const std::vector<ReadRequest>& requests) = 0;
+    virtual void writeFiles(const std::vector<WriteRequest>& requests) = 0;
+};
+
+std::unique_ptr<BatchIo> makeBlockingBatchIo();
+
+// io_uring when it was compiled in and the kernel allows it, blocking syscalls otherwise.
+std::unique_ptr<BatchIo> makeBatchIo();
+
+} // namespace gesa::filesystem
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "utils/byte_view.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+namespace gesa::filesystem {
+
+// Input file held open for reads at explicit offsets, e.g. the archive an update
+// copies unchanged payloads out of.
+class SourceFile {
+public:
+    explicit SourceFile(std::filesystem::path path);
+    ~SourceFile();
+
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+
+    const std::filesystem::path& path() const noexcept { return path_; }
+    // Reads size bytes at offset with pread; safe to call from several threads at once.
+    std::vector<std::uint8_t> read(std::uint64_t offset, std::uint64_t size) const;
+
+private:
+    friend class PositionalFile;
+    friend class ScratchFile;
+
+    SourceFile(std::filesystem::path path, int fd) noexcept;
+
+    std::filesystem::path path_;
+    int fd_ {-1};
+};
+
+// Unnamed file that bytes are appended to and later copied out of by offset like any
+// SourceFile, e.g. finished results moved out of memory before an archive is written.
+// Created in directory when it allows that, in the temporary directory otherwise; its
+// space is freed once it is destroyed.
+class ScratchFile {
+public:
+    explicit ScratchFile(const std::filesystem::path& directory);
+
+    // Returns the offset data starts at.
+    std::uint64_t append(gesa::utils::ByteView data);
+    const SourceFile& source() const noexcept { return source_; }
+
+private:
+    SourceFile source_;
+    std::uint64_t size_ {0};
+};
+
+namespace detail {
+
+// Preallocates size bytes of fd through allocate (fallocate on Linux) and falls back to
+// ftruncate when the filesystem does not support preallocation.
+void reserveSpace(int fd, std::uint64_t size, const std::filesystem::path& path,
+                  int (*allocate)(int fd, std::int64_t size));
+
+} // namespace detail
+
+// Output file of known size written with pwrite at explicit offsets; write() is safe
+// to call from several threads at once. The bytes go to a temporary file next to path
+// (mkstemp) that close() renames over it, so a failed or abandoned write leaves
+// whatever was at path untouched. Destinations that cannot be replaced by name, such as
+// pipes or in-memory files under /proc/self/fd, are truncated and written in place.
+class PositionalFile {
+public:
+    PositionalFile(std::filesystem::path path, std::uint64_t size);
+    // Removes the temporary file unless close() succeeded.
+    ~PositionalFile();
+
+    PositionalFile(const PositionalFile&) = delete;
+    PositionalFile& operator=(const PositionalFile&) = delete;
+
+    void write(std::uint64_t offset, gesa::utils::ByteView data) const;
+    // Copies size bytes of source from sourceOffset to offset inside the kernel where the
+    // filesystems allow it (copy_file_range), through a bounded buffer otherwise.
+    void copyFrom(std::uint64_t offset, const SourceFile& source, std::uint64_t sourceOffset, std::uint64_t size) const;
+    // Closes the file and renames the temporary over the destination.
+    void close();
+
+private:
+    std::filesystem::path path_;
+    std::filesystem::path target_;
+    std::filesystem::path temporary_;
+    int fd_ {-1};
+    bool committed_ {false};
+};
+
+} // namespace gesa::filesystem
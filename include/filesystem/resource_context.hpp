@@ -1,11 +1,13 @@
 #pragma once
 
+#include "concurrency/completion_queue.hpp"
+#include "concurrency/shared_pool.hpp"
 #include "concurrency/thread_pool.hpp"
+#include "utils/byte_view.hpp"
 
 #include <cstdint>
 #include <filesystem>
 #include <functional>
-#include <future>
 #include <memory>
 #include <string>
 #include <utility>
@@ -30,14 +32,45 @@ struct FileDescriptor {
 
 FileDescriptor describePath(const std::filesystem::path& path);
 
+inline constexpr std::uintmax_t kMapThreshold = 256U * 1024U;
+inline constexpr std::uintmax_t kPopulateLimit = 64U * 1024U * 1024U;
+
+// Read-only file contents: memory-mapped at or above kMapThreshold, read into an owned buffer below it.
+class FileView {
+public:
+    FileView() = default;
+    FileView(const FileView&) = delete;
+    FileView& operator=(const FileView&) = delete;
+    FileView(FileView&& other) noexcept;
+    FileView& operator=(FileView&& other) noexcept;
+    ~FileView();
+
+    gesa::utils::ByteView bytes() const noexcept;
+    std::size_t size() const noexcept;
+    bool mapped() const noexcept;
+
+private:
+    friend class FileContext;
+
+    void release() noexcept;
+
+    void* mapping_ {nullptr};
+    std::size_t mappingSize_ {0};
+    std::vector<std::uint8_t> buffer_;
+};
+
 class FileContext {
 public:
     explicit FileContext(std::filesystem::path sourcePath);
+    // Reuses metadata that was already gathered, e.g. by DirectoryContext::walk.
+    explicit FileContext(FileDescriptor descriptor);
 
     const FileDescriptor& descriptor() const noexcept;
 
     std::vector<std::uint8_t> readAll() const;
     std::vector<std::uint8_t> readRange(std::uintmax_t offset, std::size_t length) const;
+    FileView view() const;
+    std::size_t readInto(std::uintmax_t offset, std::uint8_t* buffer, std::size_t length) const;
     void writeAll(const std::filesystem::path& destinationPath, const std::vector<std::uint8_t>& data) const;
     void copyTo(const std::filesystem::path& destinationPath) const;
 
@@ -47,19 +80,28 @@ private:
 
 class DirectoryContext {
 public:
+    using EntryCallback = std::function<void(const FileDescriptor&)>;
+
     DirectoryContext(std::filesystem::path rootPath, bool followSymlinks = false);
 
     const std::filesystem::path& root() const noexcept;
     bool followsSymlinks() const noexcept;
 
-    std::vector<FileDescriptor> listEntries(bool recursive = true, bool includeDirectories = true) const;
+    // Entries sorted by relative path.
+    std::vector<FileDescriptor> listEntries(bool recursive = true, bool includeDirectories = true,
+                                            std::size_t threadCount = 0) const;
+    std::vector<FileDescriptor> listEntries(gesa::concurrency::ThreadPool& pool, bool recursive = true,
+                                            bool includeDirectories = true) const;
+
+    // Scans every directory as its own pool task and reports entries as soon as they
+    // are read; onEntry runs on pool workers, possibly concurrently.
+    void walk(gesa::concurrency::ThreadPool& pool, const EntryCallback& onEntry,
+              bool recursive = true, bool includeDirectories = true) const;
 
     template <class Callable>
     void forEachFile(Callable&& callback, bool recursive = true, std::size_t threadCount = 0) const;
 
 private:
-    FileDescriptor buildDescriptor(const std::filesystem::directory_entry& entry) const;
-
     std::filesystem::path rootPath_;
     bool followSymlinks_ {false};
 };
@@ -69,23 +111,21 @@ private:
 template <class Callable>
 void DirectoryContext::forEachFile(Callable&& callback, bool recursive, std::size_t threadCount) const
 {
-    const auto entries = listEntries(recursive, false);
-    if (entries.empty()) {
-        return;
-    }
-
-    gesa::concurrency::ThreadPool pool(threadCount);
-    auto sharedCallback = std::make_shared<std::decay_t<Callable>>(std::forward<Callable>(callback));
-
-    std::vector<std::future<void>> futures;
-    futures.reserve(entries.size());
-
-    for (const auto& entry : entries) {
-        futures.emplace_back(pool.enqueue([sharedCallback, entry]() { (*sharedCallback)(entry); }));
-    }
-
-    for (auto& future : futures) {
-        future.get();
+    const gesa::concurrency::PoolLease lease(threadCount);
+    auto& pool = lease.get();
+
+    // Files go to the pool as the walk reports them, so callbacks start long before a
+    // large tree is fully listed; the queue is the single latch for all of them and
+    // waits for the stragglers even when the walk throws.
+    gesa::concurrency::CompletionQueue completions;
+    walk(
+        pool,
+        [&](const FileDescriptor& entry) { pool.submitTo(completions, 0, [&callback, entry]() { callback(entry); }); },
+        recursive,
+        false);
+
+    while (auto completion = completions.next()) {
+        completion->rethrow();
     }
 }
 
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace gesa::utils {
+
+inline constexpr std::size_t kDefaultReadWindowSize = 64U * 1024U;
+
+template <class T>
+void storeLittleEndian(std::uint8_t* out, T value)
+{
+    static_assert(std::is_integral_v<T>, "storeLittleEndian requires an integral type");
+    using Unsigned = std::make_unsigned_t<T>;
+    auto bits = static_cast<Unsigned>(value);
+    for (std::size_t byte = 0; byte < sizeof(T); ++byte) {
+        out[byte] = static_cast<std::uint8_t>(bits & 0xFFU);
+        bits = static_cast<Unsigned>(bits >> 8U);
+    }
+}
+
+template <class T>
+T loadLittleEndian(const std::uint8_t* in)
+{
+    static_assert(std::is_integral_v<T>, "loadLittleEndian requires an integral type");
+    using Unsigned = std::make_unsigned_t<T>;
+    Unsigned bits = 0;
+    for (std::size_t byte = sizeof(T); byte > 0; --byte) {
+        bits = static_cast<Unsigned>((bits << 8U) | in[byte - 1]);
+    }
+    return static_cast<T>(bits);
+}
+
+// Encodes little-endian values into a growable buffer that is emitted with a single write.
+class BinaryWriter {
+public:
+    template <class T>
+    void write(T value)
+    {
+        const auto offset = buffer_.size();
+        buffer_.resize(offset + sizeof(T));
+        storeLittleEndian(buffer_.data() + offset, value);
+    }
+
+    void writeBytes(const void* data, std::size_t size);
+    void writeString(const std::string& text);
+
+    std::size_t size() const { return buffer_.size(); }
+    const std::vector<std::uint8_t>& data() const { return buffer_; }
+
+    void flush(std::ostream& output);
+    std::vector<std::uint8_t> release();
+
+private:
+    std::vector<std::uint8_t> buffer_;
+};
+
+// Parses little-endian values from a contiguous in-memory view.
+class ByteReader {
+public:
+    ByteReader(const std::uint8_t* data, std::size_t size);
+
+    template <class T>
+    T read()
+    {
+        const auto* bytes = consume(sizeof(T));
+        return loadLittleEndian<T>(bytes);
+    }
+
+    void readBytes(void* out, std::size_t size);
+    void skip(std::size_t size);
+
+    std::size_t remaining() const { return size_ - cursor_; }
+
+private:
+    const std::uint8_t* consume(std::size_t size);
+
+    const std::uint8_t* data_;
+    std::size_t size_;
+    std::size_t cursor_ {0};
+};
+
+// Reads a seekable stream through a fixed window so that headers are parsed from memory.
+class BufferedReader {
+public:
+    explicit BufferedReader(std::istream& input, std::size_t windowSize = kDefaultReadWindowSize);
+
+    ByteReader take(std::size_t size);
+
+    template <class T>
+    T read()
+    {
+        return take(sizeof(T)).template read<T>();
+    }
+
+    void readBytes(void* out, std::size_t size);
+    void skip(std::uint64_t size);
+
+    std::uint64_t position() const { return windowOffset_ + cursor_; }
+    std::uint64_t size() const { return streamSize_; }
+
+private:
+    void refill(std::size_t size);
+
+    std::istream& input_;
+    std::vector<std::uint8_t> window_;
+    std::uint64_t streamSize_ {0};
+    std::uint64_t windowOffset_ {0};
+    std::size_t cursor_ {0};
+    std::size_t end_ {0};
+};
+
+} // namespace gesa::utils
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gesa::utils {
+
+// Non-owning view over a contiguous byte range.
+struct ByteView {
+    const std::uint8_t* data {nullptr};
+    std::size_t size {0};
+
+    ByteView() = default;
+    ByteView(const std::uint8_t* bytes, std::size_t length)
+        : data(bytes), size(length)
+    {
+    }
+    ByteView(const std::vector<std::uint8_t>& bytes)
+        : data(bytes.data()), size(bytes.size())
+    {
+    }
+
+    bool empty() const noexcept { return size == 0U; }
+    const std::uint8_t* begin() const noexcept { return data; }
+    const std::uint8_t* end() const noexcept { return data + size; }
+    const std::uint8_t& operator[](std::size_t index) const noexcept { return data[index]; }
+
+    ByteView subview(std::size_t offset, std::size_t length) const noexcept { return ByteView(data + offset, length); }
+    std::vector<std::uint8_t> copy() const { return std::vector<std::uint8_t>(begin(), end()); }
+};
+
+} // namespace gesa::utils
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "utils/byte_view.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace gesa::utils {
+
+inline constexpr std::size_t kStreamChunkSize = 1U * 1024U * 1024U;
+inline constexpr std::size_t kStreamReadSize = 64U * 1024U;
+inline constexpr std::uint8_t kFrameStreamVersion = 1;
+
+// Push-based byte consumer; finish() is called exactly once after the last write.
+class ByteSink {
+public:
+    virtual ~ByteSink() = default;
+
+    virtual void write(ByteView data) = 0;
+    virtual void finish() = 0;
+};
+
+// Writes to a stream and flushes after every write so pipelines see output promptly.
+class OstreamSink final : public ByteSink {
+public:
+    explicit OstreamSink(std::ostream& output);
+
+    void write(ByteView data) override;
+    void finish() override;
+
+private:
+    std::ostream& output_;
+};
+
+using FrameTransform = std::function<std::vector<std::uint8_t>(ByteView)>;
+
+// Cuts the input into chunkSize pieces and emits a 4-byte magic, a version byte and
+// one length-prefixed frame per transformed chunk, ending with an empty frame.
+// chunkSize is capped at kStreamChunkSize so decoders can bound the frames they accept.
+class FrameEncoder final : public ByteSink {
+public:
+    FrameEncoder(const char (&magic)[4], FrameTransform transform, ByteSink& output,
+                 std::size_t chunkSize = kStreamChunkSize);
+
+    void write(ByteView data) override;
+    void finish() override;
+
+private:
+    void emit(ByteView chunk);
+
+    std::string magic_;
+    FrameTransform transform_;
+    ByteSink& output_;
+    std::size_t chunkSize_;
+    std::vector<std::uint8_t> pending_;
+    bool started_ {false};
+};
+
+// Parses the framing written by FrameEncoder as bytes arrive and passes every
+// transformed frame downstream. A frame longer than maxFrameSize, the most the matching
+// encoder's transform makes of a kStreamChunkSize chunk, is rejected from its length
+// alone instead of being buffered.
+class FrameDecoder final : public ByteSink {
+public:
+    FrameDecoder(const char (&magic)[4], FrameTransform transform, ByteSink& output, std::size_t maxFrameSize);
+
+    void write(ByteView data) override;
+    void finish() override;
+
+private:
+    std::string magic_;
+    FrameTransform transform_;
+    ByteSink& output_;
+    std::size_t maxFrameSize_;
+    std::vector<std::uint8_t> pending_;
+    bool started_ {false};
+    bool ended_ {false};
+};
+
+// Reads a file descriptor until end of file, handing over whatever each read returns.
+void pumpDescriptor(int fd, ByteSink& sink, std::size_t readSize = kStreamReadSize);
+
+} // namespace gesa::utils
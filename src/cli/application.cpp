@@ -2,25 +2,46 @@
 
 #include "compression/huffman.hpp"
 #include "compression/lzw.hpp"
+#include "compression/stream.hpp"
+#include "concurrency/memory_budget.hpp"
+#include "concurrency/pool_statistics.hpp"
+#include "concurrency/shared_pool.hpp"
 #include "encryption/RSA.h"
+#include "utils/file_io.hpp"
+#include "utils/frame_stream.hpp"
 
 #include <algorithm>
 #include <cctype>
+#include <cerrno>
+#include <cstdlib>
 #include <exception>
 #include <filesystem>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <memory>
 #include <optional>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <system_error>
 #include <unordered_map>
 #include <vector>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 namespace {
 
+const std::filesystem::path kStandardStream {"-"};
+
 enum class Command {
     Compress,
     Decompress,
+    List,
+    Stats,
     Help
 };
 
@@ -46,6 +67,11 @@ struct Options {
     std::filesystem::path input;
     std::filesystem::path output;
     std::size_t threads {0};
+    std::optional<gesa::concurrency::Placement> affinity;
+    std::optional<std::uint64_t> memoryLimit;
+    bool poolStats {false};
+    bool solid {false};
+    std::filesystem::path previousArchive;
     // New encryption/operations options
     std::string opSequence; // e.g. "ce", "du", etc.
     EncAlgorithm encAlgorithm {EncAlgorithm::RSA};
@@ -58,21 +84,38 @@ void printUsage()
               << "  gsea help\n"
               << "\n"
               << "  // New unified flags (can be combined):\n"
-              << "  gsea -[c|d|e|u]+ --comp-alg <huffman|lzw> --enc-alg <rsa> -i <input> -o <output> [-t <n>] [-k <key>]\n"
+              << "  gsea -[c|d|e|u]+ --comp-alg <huffman|lzw> --enc-alg <rsa> -i <input> -o <output> [-t <n>] [--affinity <mode>] [--mem-limit <size>] [--stats] [-k <key>] [--solid] [--update <archive>]\n"
               << "    -c: compress   -d: decompress   -e: encrypt   -u: decrypt\n"
               << "    e.g. -ce to compress, then encrypt. -du to decrypt, then decompress.\n"
               << "\n"
               << "  // Back-compat commands (still supported):\n"
-              << "  gsea compress --algo <huffman|lzw> --input <path> --output <path> [--threads <n>]\n"
-              << "  gsea decompress --algo <huffman|lzw> --input <path> --output <path> [--threads <n>]\n\n"
+              << "  gsea compress --algo <huffman|lzw> --input <path> --output <path> [--threads <n>] [--affinity <mode>] [--mem-limit <size>] [--stats] [--solid] [--update <archive>]\n"
+              << "  gsea decompress --algo <huffman|lzw> --input <path> --output <path> [--threads <n>] [--affinity <mode>] [--stats]\n"
+              << "  gsea list --input <archive>\n"
+              << "  gsea stats --input <archive>\n\n"
               << "Notes:\n"
               << "  - For compression, input may be a single file or a directory.\n"
               << "  - When decompressing, the CLI inspects the source magic to decide if it is\n"
               << "    an archive (directory) or a single-file payload.\n"
-              << "  - Thread count applies to directory operations; 0 uses the default pool size.\n"
+              << "  - list and stats only read archive headers; payloads are never decoded.\n"
+              << "  - -t sizes the worker pool shared by every stage (default: GSEA_THREADS, else\n"
+              << "    the hardware concurrency).\n"
+              << "  - --affinity none|compact|scatter pins pool workers to CPUs, filling one NUMA\n"
+              << "    node first or spreading across nodes (default: GSEA_AFFINITY, else none).\n"
+              << "  - --mem-limit caps the memory of in-flight compression jobs, e.g. 512M or 8G;\n"
+              << "    0 disables it (default: GSEA_MEM_LIMIT, else half of the physical memory).\n"
+              << "  - --stats reports worker pool queue wait, run time, queue depth and\n"
+              << "    per-worker utilization once the operation completes.\n"
+              << "  - --solid packs small files of a directory into shared compressed blocks.\n"
+              << "  - --update reuses entries of a previous archive whose size and mtime match:\n"
+              << "    payloads, duplicates of reused files and, with --solid, blocks whose members\n"
+              << "    are all unchanged. A block with any changed member is packed again.\n"
               << "  - Encryption expects files. For directories, use -c before -e (e.g. -ce).\n"
               << "  - -k provides public key (encrypt) or private key (decrypt). If omitted for\n"
-              << "    encryption, a keypair is generated and printed.\n";
+              << "    encryption, a keypair is generated and printed.\n"
+              << "  - -i - reads stdin and -o - writes stdout. Every stage then uses a framed\n"
+              << "    stream format that is processed in 1 MiB chunks as data arrives; status\n"
+              << "    messages go to stderr. Directories are not supported in this mode.\n";
 }
 
 std::string toLower(std::string value)
@@ -104,6 +147,12 @@ Command parseCommand(const std::string& argument)
     if (lowered == "decompress") {
         return Command::Decompress;
     }
+    if (lowered == "list") {
+        return Command::List;
+    }
+    if (lowered == "stats") {
+        return Command::Stats;
+    }
     if (lowered == "help" || lowered == "--help" || lowered == "-h") {
         return Command::Help;
     }
@@ -185,6 +234,16 @@ Options parseOptions(int argc, char** argv)
                 } catch (const std::exception&) {
                     throw std::invalid_argument("Invalid thread count: " + value);
                 }
+            } else if (argument == "--affinity" && index + 1 < argc) {
+                options.affinity = gesa::concurrency::parsePlacement(argv[++index]);
+            } else if (argument == "--mem-limit" && index + 1 < argc) {
+                options.memoryLimit = gesa::concurrency::parseByteSize(argv[++index]);
+            } else if (argument == "--stats") {
+                options.poolStats = true;
+            } else if (argument == "--solid") {
+                options.solid = true;
+            } else if (argument == "--update" && index + 1 < argc) {
+                options.previousArchive = std::filesystem::path(argv[++index]);
             } else if (argument == "--help" || argument == "-h") {
                 options.command = Command::Help;
                 return options;
@@ -196,6 +255,9 @@ Options parseOptions(int argc, char** argv)
         if (options.input.empty()) {
             throw std::invalid_argument("Missing required --input argument");
         }
+        if (options.command == Command::List || options.command == Command::Stats) {
+            return options;
+        }
         if (options.output.empty()) {
             throw std::invalid_argument("Missing required --output argument");
         }
@@ -225,6 +287,16 @@ Options parseOptions(int argc, char** argv)
             }
         } else if ((argument == "--key" || argument == "-k") && index + 1 < argc) {
             options.key = argv[++index];
+        } else if (argument == "--affinity" && index + 1 < argc) {
+            options.affinity = gesa::concurrency::parsePlacement(argv[++index]);
+        } else if (argument == "--mem-limit" && index + 1 < argc) {
+            options.memoryLimit = gesa::concurrency::parseByteSize(argv[++index]);
+        } else if (argument == "--stats") {
+            options.poolStats = true;
+        } else if (argument == "--solid") {
+            options.solid = true;
+        } else if (argument == "--update" && index + 1 < argc) {
+            options.previousArchive = std::filesystem::path(argv[++index]);
         } else if (argument == "--help" || argument == "-h") {
             options.command = Command::Help;
             return options;
@@ -242,25 +314,50 @@ Options parseOptions(int argc, char** argv)
     return options;
 }
 
+bool usesStandardStreams(const Options& options)
+{
+    return options.input == kStandardStream || options.output == kStandardStream;
+}
+
+std::ostream& statusStream(const Options& options)
+{
+    return options.output == kStandardStream ? std::cerr : std::cout;
+}
+
+gesa::compression::StreamCodec toStreamCodec(Algorithm algorithm)
+{
+    return algorithm == Algorithm::LZW ? gesa::compression::StreamCodec::LZW : gesa::compression::StreamCodec::Huffman;
+}
+
+void streamOperations(const Options& options, const std::vector<Operation>& ops);
+
 void compressWithAlgorithm(const Options& options)
 {
+    if (usesStandardStreams(options)) {
+        streamOperations(options, {Operation::Compress});
+        return;
+    }
+
     if (!std::filesystem::exists(options.input)) {
         throw std::runtime_error("Input path does not exist: " + options.input.string());
     }
 
     const bool isDirectory = std::filesystem::is_directory(options.input);
+    gesa::compression::DirectoryOptions directoryOptions {};
+    directoryOptions.solid = options.solid;
+    directoryOptions.previousArchive = options.previousArchive;
 
     switch (options.algorithm) {
     case Algorithm::Huffman:
         if (isDirectory) {
-            gesa::compression::huffman::compressDirectory(options.input, options.output, options.threads);
+            gesa::compression::huffman::compressDirectory(options.input, options.output, directoryOptions);
         } else {
             gesa::compression::huffman::compressFile(options.input, options.output);
         }
         break;
     case Algorithm::LZW:
         if (isDirectory) {
-            gesa::compression::lzw::compressDirectory(options.input, options.output, options.threads);
+            gesa::compression::lzw::compressDirectory(options.input, options.output, directoryOptions);
         } else {
             gesa::compression::lzw::compressFile(options.input, options.output);
         }
@@ -270,6 +367,11 @@ void compressWithAlgorithm(const Options& options)
 
 void decompressWithAlgorithm(const Options& options)
 {
+    if (usesStandardStreams(options)) {
+        streamOperations(options, {Operation::Decompress});
+        return;
+    }
+
     if (!std::filesystem::exists(options.input)) {
         throw std::runtime_error("Input path does not exist: " + options.input.string());
     }
@@ -284,7 +386,7 @@ void decompressWithAlgorithm(const Options& options)
         if (magic == std::string{"GHUF", 4}) {
             gesa::compression::huffman::decompressFile(options.input, options.output);
         } else if (magic == std::string{"GHAR", 4}) {
-            gesa::compression::huffman::decompressDirectory(options.input, options.output, options.threads);
+            gesa::compression::huffman::decompressDirectory(options.input, options.output);
         } else {
             throw std::runtime_error("Unrecognized Huffman magic header in input file");
         }
@@ -293,7 +395,7 @@ void decompressWithAlgorithm(const Options& options)
         if (magic == std::string{"GLZW", 4}) {
             gesa::compression::lzw::decompressFile(options.input, options.output);
         } else if (magic == std::string{"GLZA", 4}) {
-            gesa::compression::lzw::decompressDirectory(options.input, options.output, options.threads);
+            gesa::compression::lzw::decompressDirectory(options.input, options.output);
         } else {
             throw std::runtime_error("Unrecognized LZW magic header in input file");
         }
@@ -342,39 +444,305 @@ void writeFileBytes(const std::filesystem::path& path, const std::vector<std::ui
     }
 }
 
-void encryptFileRSA(const std::filesystem::path& input,
-                    const std::filesystem::path& output,
-                    const std::string& maybePublicKey)
+std::string resolvePublicKey(Rsa& rsa, const std::string& maybePublicKey, std::ostream& report)
 {
-    Rsa rsa(61, 53); // demo primes; n >= 256
-    std::string publicKey = maybePublicKey;
-    if (publicKey.empty()) {
-        const auto keys = rsa.generateKeys();
-        std::cout << "Generated RSA keypair:\n"
-                  << "  Public (-k for encrypt):  " << keys.publicKey << "\n"
-                  << "  Private (-k for decrypt): " << keys.privateKey << "\n";
-        publicKey = keys.publicKey;
-        Utils::freeCString(keys.publicKey);
-        Utils::freeCString(keys.privateKey);
-    }
-    const auto plain = readFileBytes(input);
-    const auto cipher = rsa.encrypt(plain, publicKey);
-    writeFileBytes(output, cipher);
+    if (!maybePublicKey.empty()) {
+        return maybePublicKey;
+    }
+    const auto keys = rsa.generateKeys();
+    report << "Generated RSA keypair:\n"
+           << "  Public (-k for encrypt):  " << keys.publicKey << "\n"
+           << "  Private (-k for decrypt): " << keys.privateKey << "\n";
+    std::string publicKey = keys.publicKey;
+    Utils::freeCString(keys.publicKey);
+    Utils::freeCString(keys.privateKey);
+    return publicKey;
 }
 
-void decryptFileRSA(const std::filesystem::path& input,
-                    const std::filesystem::path& output,
-                    const std::string& privateKey)
+constexpr char kRsaStreamMagic[4] = {'G', 'R', 'S', 'T'};
+// Rsa::encrypt turns every input byte into a 4-byte word.
+constexpr std::size_t kRsaMaxFrameSize = 4U * gesa::utils::kStreamChunkSize;
+
+class InputHandle {
+public:
+    explicit InputHandle(const std::filesystem::path& path)
+        : fd_(path == kStandardStream ? STDIN_FILENO : ::open(path.c_str(), O_RDONLY | O_CLOEXEC))
+        , owned_(path != kStandardStream)
+    {
+        if (fd_ < 0) {
+            throw std::runtime_error("Failed to open input: " + path.string());
+        }
+    }
+    InputHandle(const InputHandle&) = delete;
+    InputHandle& operator=(const InputHandle&) = delete;
+    ~InputHandle()
+    {
+        if (owned_) {
+            ::close(fd_);
+        }
+    }
+
+    int get() const noexcept { return fd_; }
+
+private:
+    int fd_;
+    bool owned_;
+};
+
+// Chains one framed-stream stage per operation, so data flows from the input to the
+// output in bounded chunks without intermediate files.
+void streamOperations(const Options& options, const std::vector<Operation>& ops)
 {
-    if (privateKey.empty()) {
-        throw std::invalid_argument("Missing -k <private_key> for decryption");
+    if (options.input != kStandardStream && std::filesystem::is_directory(options.input)) {
+        throw std::runtime_error("Directories cannot be streamed; write the archive to a file instead");
+    }
+    const InputHandle input(options.input);
+
+    std::ofstream file;
+    if (options.output != kStandardStream) {
+        gesa::utils::ensureParentDirectory(options.output);
+        file.open(options.output, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("Failed to open output: " + options.output.string());
+        }
     }
+    gesa::utils::OstreamSink output(options.output == kStandardStream ? std::cout : file);
+
     Rsa rsa(61, 53);
-    const auto cipher = readFileBytes(input);
-    const auto plain = rsa.decrypt(cipher, privateKey);
-    writeFileBytes(output, plain);
+    const auto codec = toStreamCodec(options.algorithm);
+    std::vector<std::unique_ptr<gesa::utils::ByteSink>> stages;
+    gesa::utils::ByteSink* downstream = &output;
+    for (auto op = ops.rbegin(); op != ops.rend(); ++op) {
+        switch (*op) {
+        case Operation::Compress:
+            stages.push_back(gesa::compression::makeCompressingSink(codec, *downstream));
+            break;
+        case Operation::Decompress:
+            stages.push_back(gesa::compression::makeDecompressingSink(codec, *downstream));
+            break;
+        case Operation::Encrypt: {
+            const auto publicKey = resolvePublicKey(rsa, options.key, statusStream(options));
+            stages.push_back(std::make_unique<gesa::utils::FrameEncoder>(
+                kRsaStreamMagic, [&rsa, publicKey](gesa::utils::ByteView chunk) { return rsa.encrypt(chunk.copy(), publicKey); },
+                *downstream));
+            break;
+        }
+        case Operation::Decrypt:
+            if (options.key.empty()) {
+                throw std::invalid_argument("Missing -k <private_key> for decryption");
+            }
+            stages.push_back(std::make_unique<gesa::utils::FrameDecoder>(
+                kRsaStreamMagic, [&rsa, &options](gesa::utils::ByteView frame) { return rsa.decrypt(frame.copy(), options.key); },
+                *downstream, kRsaMaxFrameSize));
+            break;
+        }
+        downstream = stages.back().get();
+    }
+
+    gesa::utils::pumpDescriptor(input.get(), *downstream);
 }
 
+// Anonymous in-memory file for the few stages that need a path, such as archives
+// produced or consumed in the middle of a chain.
+class MemoryFile {
+public:
+    MemoryFile()
+        : fd_(::memfd_create("gsea-stage", MFD_CLOEXEC))
+    {
+        if (fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), "Failed to create in-memory stage file");
+        }
+    }
+    explicit MemoryFile(const std::vector<std::uint8_t>& contents)
+        : MemoryFile()
+    {
+        std::size_t written = 0;
+        while (written < contents.size()) {
+            const auto count = ::write(fd_, contents.data() + written, contents.size() - written);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(), "Failed to fill in-memory stage file");
+            }
+            written += static_cast<std::size_t>(count);
+        }
+    }
+    MemoryFile(const MemoryFile&) = delete;
+    MemoryFile& operator=(const MemoryFile&) = delete;
+    ~MemoryFile()
+    {
+        ::close(fd_);
+    }
+
+    std::filesystem::path path() const
+    {
+        return std::filesystem::path("/proc/self/fd") / std::to_string(fd_);
+    }
+
+    std::vector<std::uint8_t> contents() const
+    {
+        struct stat status {};
+        if (::fstat(fd_, &status) != 0) {
+            throw std::system_error(errno, std::generic_category(), "Failed to size in-memory stage file");
+        }
+        std::vector<std::uint8_t> data(static_cast<std::size_t>(status.st_size));
+        std::size_t total = 0;
+        while (total < data.size()) {
+            const auto count = ::pread(fd_, data.data() + total, data.size() - total, static_cast<off_t>(total));
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                throw std::system_error(count < 0 ? errno : EIO, std::generic_category(), "Failed to read in-memory stage file");
+            }
+            total += static_cast<std::size_t>(count);
+        }
+        return data;
+    }
+
+private:
+    int fd_;
+};
+
+// Directory produced by decompressing an archive before the last operation. mkdtemp
+// picks an unpredictable name and fails rather than adopting an existing path, so the
+// destructor only ever removes a directory this process created.
+class ScratchDirectory {
+public:
+    ScratchDirectory()
+    {
+        auto pattern = (std::filesystem::temp_directory_path() / "gsea-stage-XXXXXX").string();
+        if (::mkdtemp(pattern.data()) == nullptr) {
+            throw std::system_error(errno, std::generic_category(), "Failed to create scratch directory");
+        }
+        path_ = pattern;
+    }
+    ScratchDirectory(const ScratchDirectory&) = delete;
+    ScratchDirectory& operator=(const ScratchDirectory&) = delete;
+    ~ScratchDirectory()
+    {
+        std::error_code ec;
+        std::filesystem::remove_all(path_, ec);
+    }
+
+    const std::filesystem::path& path() const noexcept { return path_; }
+
+private:
+    std::filesystem::path path_;
+};
+
+// What one operation hands to the next: bytes in memory, or a path when the data is
+// the original input or a directory.
+struct StageData {
+    std::filesystem::path path;
+    std::vector<std::uint8_t> bytes;
+    bool inMemory {false};
+    std::shared_ptr<ScratchDirectory> scratch;
+};
+
+std::vector<std::uint8_t> takeBytes(StageData& data)
+{
+    if (!data.inMemory) {
+        if (std::filesystem::is_directory(data.path)) {
+            throw std::runtime_error("This operation expects a file. Compress directories first (use -c before -e).");
+        }
+        return readFileBytes(data.path);
+    }
+    return std::move(data.bytes);
+}
+
+StageData inMemory(std::vector<std::uint8_t> bytes)
+{
+    StageData data;
+    data.bytes = std::move(bytes);
+    data.inMemory = true;
+    return data;
+}
+
+StageData compressStage(const Options& options, StageData input, const std::filesystem::path* finalOutput)
+{
+    if (!input.inMemory && std::filesystem::is_directory(input.path)) {
+        Options local = options;
+        local.input = input.path;
+        if (finalOutput != nullptr) {
+            local.output = *finalOutput;
+            compressWithAlgorithm(local);
+            return {};
+        }
+        const MemoryFile archive;
+        local.output = archive.path();
+        compressWithAlgorithm(local);
+        return inMemory(archive.contents());
+    }
+
+    const auto bytes = takeBytes(input);
+    return inMemory(options.algorithm == Algorithm::LZW ? gesa::compression::lzw::compressToImage(bytes)
+                                                        : gesa::compression::huffman::compressToImage(bytes));
+}
+
+StageData decompressStage(const Options& options, StageData input, const std::filesystem::path* finalOutput)
+{
+    if (!input.inMemory && std::filesystem::is_directory(input.path)) {
+        throw std::runtime_error("Decompression input must be a file, not a directory");
+    }
+
+    std::string magic;
+    if (!input.inMemory) {
+        magic = readMagic(input.path);
+    } else if (input.bytes.size() >= 4U) {
+        magic.assign(input.bytes.begin(), input.bytes.begin() + 4);
+    }
+
+    const bool isLzw = options.algorithm == Algorithm::LZW;
+    if (magic == (isLzw ? std::string {"GLZW", 4} : std::string {"GHUF", 4})) {
+        const auto bytes = takeBytes(input);
+        return inMemory(isLzw ? gesa::compression::lzw::decompressImage(bytes)
+                              : gesa::compression::huffman::decompressImage(bytes));
+    }
+
+    // Archives expand to directories, which only exist on disk.
+    std::unique_ptr<MemoryFile> archive;
+    Options local = options;
+    local.input = input.path;
+    if (input.inMemory) {
+        archive = std::make_unique<MemoryFile>(input.bytes);
+        local.input = archive->path();
+    }
+
+    StageData output;
+    if (finalOutput != nullptr) {
+        output.path = *finalOutput;
+    } else {
+        output.scratch = std::make_shared<ScratchDirectory>();
+        output.path = output.scratch->path();
+    }
+    local.output = output.path;
+    decompressWithAlgorithm(local);
+    return output;
+}
+
+StageData cipherStage(const Options& options, Operation op, StageData input)
+{
+    const auto bytes = takeBytes(input);
+    Rsa rsa(61, 53); // demo primes; n >= 256
+    if (op == Operation::Encrypt) {
+        const auto publicKey = resolvePublicKey(rsa, options.key, statusStream(options));
+        auto cipher = rsa.encrypt(bytes, publicKey);
+        std::cout << "Encriptación completada" << "\n";
+        return inMemory(std::move(cipher));
+    }
+
+    if (options.key.empty()) {
+        throw std::invalid_argument("Missing -k <private_key> for decryption");
+    }
+    auto plain = rsa.decrypt(bytes, options.key);
+    std::cout << "Desencriptación completada" << "\n";
+    return inMemory(std::move(plain));
+}
+
+// Runs the chain with every intermediate result kept in memory; only the last stage
+// touches the output path, so a failing stage leaves nothing behind.
 void executeOperations(const Options& options)
 {
     auto ops = getOperations(options);
@@ -383,60 +751,144 @@ void executeOperations(const Options& options)
         return;
     }
 
-    std::filesystem::path currentInput = options.input;
-    std::filesystem::path finalOutput = options.output;
-    std::filesystem::path tempPath = finalOutput;
-    tempPath += ".tmp";
+    if (usesStandardStreams(options)) {
+        streamOperations(options, ops);
+        return;
+    }
 
-    for (std::size_t idx = 0; idx < ops.size(); ++idx) {
-        const bool isLast = (idx + 1 == ops.size());
-        const auto outPath = isLast ? finalOutput : tempPath;
+    if (!std::filesystem::exists(options.input)) {
+        throw std::runtime_error("Input path does not exist: " + options.input.string());
+    }
 
+    StageData current;
+    current.path = options.input;
+    for (std::size_t idx = 0; idx < ops.size(); ++idx) {
+        const auto* finalOutput = idx + 1 == ops.size() ? &options.output : nullptr;
         switch (ops[idx]) {
-        case Operation::Compress: {
-            Options local = options;
-            local.input = currentInput;
-            local.output = outPath;
-            compressWithAlgorithm(local);
-            currentInput = outPath;
+        case Operation::Compress:
+            current = compressStage(options, std::move(current), finalOutput);
             break;
-        }
-        case Operation::Decompress: {
-            Options local = options;
-            local.input = currentInput;
-            local.output = outPath;
-            decompressWithAlgorithm(local);
-            currentInput = outPath;
+        case Operation::Decompress:
+            current = decompressStage(options, std::move(current), finalOutput);
             break;
-        }
-        case Operation::Encrypt: {
-            if (std::filesystem::is_directory(currentInput)) {
-                throw std::runtime_error("Encryption expects a file. Compress directories first (use -c before -e).");
-            }
-            switch (options.encAlgorithm) {
-            case EncAlgorithm::RSA:
-                encryptFileRSA(currentInput, outPath, options.key);
-                break;
-            }
-            std::cout << "Encriptación completada" << "\n";
-            currentInput = outPath;
+        case Operation::Encrypt:
+        case Operation::Decrypt:
+            current = cipherStage(options, ops[idx], std::move(current));
             break;
         }
-        case Operation::Decrypt: {
-            if (std::filesystem::is_directory(currentInput)) {
-                throw std::runtime_error("Decryption expects a file output.");
-            }
-            switch (options.encAlgorithm) {
-            case EncAlgorithm::RSA:
-                decryptFileRSA(currentInput, outPath, options.key);
-                break;
+    }
+
+    if (current.inMemory) {
+        gesa::utils::ensureParentDirectory(options.output);
+        writeFileBytes(options.output, current.bytes);
+    }
+}
+
+gesa::compression::ArchiveSummary summarizeArchive(const std::filesystem::path& path)
+{
+    if (!std::filesystem::is_regular_file(path)) {
+        throw std::runtime_error("Archive path is not a file: " + path.string());
+    }
+
+    const auto magic = readMagic(path);
+    if (magic == std::string{"GHAR", 4}) {
+        return gesa::compression::huffman::summarizeArchive(path);
+    }
+    if (magic == std::string{"GLZA", 4}) {
+        return gesa::compression::lzw::summarizeArchive(path);
+    }
+    throw std::runtime_error("Input is not a GHAR/GLZA directory archive: " + path.string());
+}
+
+std::string formatRatio(std::uint64_t originalSize, std::uint64_t compressedSize)
+{
+    if (originalSize == 0U) {
+        return "-";
+    }
+    std::ostringstream output;
+    output << std::fixed << std::setprecision(1)
+           << 100.0 * static_cast<double>(compressedSize) / static_cast<double>(originalSize) << '%';
+    return output.str();
+}
+
+void printListing(const gesa::compression::ArchiveSummary& summary)
+{
+    std::cout << std::setw(14) << "original" << std::setw(14) << "compressed" << std::setw(9) << "ratio"
+              << "  " << std::left << std::setw(10) << "codec" << std::right << "path\n";
+
+    for (const auto& entry : summary.entries) {
+        std::string codec = summary.codec;
+        std::string path = entry.relativePath.generic_string();
+        std::string ratio = formatRatio(entry.originalSize, entry.compressedSize);
+        switch (entry.kind) {
+        case gesa::compression::EntryKind::Payload:
+            if (entry.codec == gesa::compression::CodecId::Stored) {
+                codec = "stored";
             }
-            std::cout << "Desencriptación completada" << "\n";
-            currentInput = outPath;
+            break;
+        case gesa::compression::EntryKind::Duplicate:
+            codec = "duplicate";
+            ratio = "-";
+            path += " (= " + summary.entries[entry.reference].relativePath.generic_string() + ")";
+            break;
+        case gesa::compression::EntryKind::Solid:
+            codec = "solid";
+            ratio = "-";
+            path += " (block " + std::to_string(entry.reference) + ")";
             break;
         }
+
+        std::cout << std::setw(14) << entry.originalSize << std::setw(14) << entry.compressedSize << std::setw(9) << ratio
+                  << "  " << std::left << std::setw(10) << codec << std::right << path << "\n";
+    }
+}
+
+void printStats(const gesa::compression::ArchiveSummary& summary)
+{
+    std::uint64_t originalBytes = 0;
+    std::uint64_t storedBytes = 0;
+    std::uint64_t duplicateBytes = 0;
+    std::size_t payloadEntries = 0;
+    std::size_t duplicateEntries = 0;
+    std::size_t solidEntries = 0;
+
+    for (const auto& entry : summary.entries) {
+        originalBytes += entry.originalSize;
+        storedBytes += entry.compressedSize;
+        switch (entry.kind) {
+        case gesa::compression::EntryKind::Payload:
+            ++payloadEntries;
+            break;
+        case gesa::compression::EntryKind::Duplicate:
+            ++duplicateEntries;
+            duplicateBytes += entry.originalSize;
+            break;
+        case gesa::compression::EntryKind::Solid:
+            ++solidEntries;
+            break;
         }
     }
+    for (const auto& block : summary.blocks) {
+        storedBytes += block.compressedSize;
+    }
+
+    std::cout << "Codec              : " << summary.codec << "\n"
+              << "Entries            : " << summary.entries.size() << "\n"
+              << "  payload          : " << payloadEntries << "\n"
+              << "  duplicate        : " << duplicateEntries << "\n"
+              << "  solid member     : " << solidEntries << "\n"
+              << "Solid blocks       : " << summary.blocks.size() << "\n"
+              << "Original bytes     : " << originalBytes << "\n"
+              << "Stored payload     : " << storedBytes << " (" << formatRatio(originalBytes, storedBytes) << ")\n"
+              << "Deduplicated bytes : " << duplicateBytes << "\n"
+              << "Archive bytes      : " << summary.archiveSize << " (" << formatRatio(originalBytes, summary.archiveSize) << ")\n";
+}
+
+void reportPoolStatistics(const Options& options)
+{
+    if (options.poolStats) {
+        gesa::concurrency::printStatistics(statusStream(options), gesa::concurrency::sharedPool().statistics());
+    }
 }
 
 } // namespace
@@ -447,10 +899,18 @@ int run(int argc, char** argv)
 {
     try {
         const auto options = parseOptions(argc, argv);
+        gesa::concurrency::configureSharedPool(options.threads);
+        if (options.affinity) {
+            gesa::concurrency::configureSharedPlacement(*options.affinity);
+        }
+        if (options.memoryLimit) {
+            gesa::concurrency::configureMemoryLimit(*options.memoryLimit);
+        }
 
         if (!options.opSequence.empty()) {
             executeOperations(options);
-            std::cout << "Operations completed successfully\n";
+            statusStream(options) << "Operations completed successfully\n";
+            reportPoolStatistics(options);
             return 0;
         }
 
@@ -461,13 +921,25 @@ int run(int argc, char** argv)
 
         if (options.command == Command::Compress) {
             compressWithAlgorithm(options);
-            std::cout << "Compression completed successfully\n";
+            statusStream(options) << "Compression completed successfully\n";
+            reportPoolStatistics(options);
             return 0;
         }
 
         if (options.command == Command::Decompress) {
             decompressWithAlgorithm(options);
-            std::cout << "Decompression completed successfully\n";
+            statusStream(options) << "Decompression completed successfully\n";
+            reportPoolStatistics(options);
+            return 0;
+        }
+
+        if (options.command == Command::List) {
+            printListing(summarizeArchive(options.input));
+            return 0;
+        }
+
+        if (options.command == Command::Stats) {
+            printStats(summarizeArchive(options.input));
             return 0;
         }
 
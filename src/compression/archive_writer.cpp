@@ -0,0 +1,98 @@
+#include "compression/archive_writer.hpp"
+
+#include "filesystem/positional_file.hpp"
+#include "utils/file_io.hpp"
+
+
+namespace gesa::compression {
+
+namespace {
+
+std::uint64_t recordSize(const ArchiveRecord& record)
+{
+    const auto payload = record.copy.source != nullptr ? record.copy.size : static_cast<std::uint64_t>(record.payload.size);
+    return static_cast<std::uint64_t>(record.header.size()) + payload;
+}
+
+void copyPayload(const gesa::filesystem::PositionalFile& file, const ArchiveRecord& record, std::uint64_t offset)
+{
+    file.copyFrom(offset, *record.copy.source, record.copy.offset, record.copy.size);
+}
+
+void writeRun(const gesa::filesystem::PositionalFile& file, const std::vector<ArchiveRecord>& records,
+              const std::vector<std::uint64_t>& offsets, std::size_t first, std::size_t last)
+{
+    const auto runSize = offsets[last] - offsets[first];
+    if (runSize <= kArchiveWriteChunkSize) {
+        // Copied payloads split the run: what was gathered so far goes out before them.
+        std::vector<std::uint8_t> buffer;
+        buffer.reserve(static_cast<std::size_t>(runSize));
+        auto bufferStart = offsets[first];
+        for (std::size_t index = first; index < last; ++index) {
+            buffer.insert(buffer.end(), records[index].header.begin(), records[index].header.end());
+            if (records[index].copy.source == nullptr) {
+                buffer.insert(buffer.end(), records[index].payload.begin(), records[index].payload.end());
+                continue;
+            }
+            file.write(bufferStart, buffer);
+            copyPayload(file, records[index], offsets[index] + records[index].header.size());
+            buffer.clear();
+            bufferStart = offsets[index + 1U];
+        }
+        file.write(bufferStart, buffer);
+        return;
+    }
+
+    for (std::size_t index = first; index < last; ++index) {
+        file.write(offsets[index], records[index].header);
+        if (records[index].copy.source != nullptr) {
+            copyPayload(file, records[index], offsets[index] + records[index].header.size());
+        } else {
+            file.write(offsets[index] + records[index].header.size(), records[index].payload);
+        }
+    }
+}
+
+} // namespace
+
+std::vector<std::size_t> planArchiveRuns(const std::vector<std::uint64_t>& offsets)
+{
+    const auto count = offsets.size() - 1U;
+    std::vector<std::size_t> runStarts;
+    for (std::size_t first = 0; first < count;) {
+        runStarts.push_back(first);
+        auto last = first + 1U;
+        while (last < count && offsets[last] - offsets[first] < kArchiveWriteChunkSize) {
+            ++last;
+        }
+        first = last;
+    }
+    runStarts.push_back(count);
+    return runStarts;
+}
+
+void writeArchiveFile(const std::filesystem::path& destination,
+                      const std::vector<std::uint8_t>& header,
+                      const std::vector<ArchiveRecord>& records,
+                      gesa::concurrency::ThreadPool& pool)
+{
+    std::vector<std::uint64_t> offsets(records.size() + 1U);
+    offsets[0] = static_cast<std::uint64_t>(header.size());
+    for (std::size_t index = 0; index < records.size(); ++index) {
+        offsets[index + 1U] = offsets[index] + recordSize(records[index]);
+    }
+
+    gesa::utils::ensureParentDirectory(destination);
+    gesa::filesystem::PositionalFile file(destination, offsets.back());
+
+    const auto runStarts = planArchiveRuns(offsets);
+
+    pool.parallelFor(0, runStarts.size() - 1U, 1, [&](std::size_t run) {
+        writeRun(file, records, offsets, runStarts[run], runStarts[run + 1U]);
+    });
+
+    file.write(0, header);
+    file.close();
+}
+
+} // namespace gesa::compression
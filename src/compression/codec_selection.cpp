@@ -0,0 +1,47 @@
+#include "compression/codec_selection.hpp"
+
+#include <array>
+#include <cmath>
+
+namespace gesa::compression {
+
+double estimateEntropyBits(const std::uint8_t* data, std::size_t size)
+{
+    if (size == 0U) {
+        return 0.0;
+    }
+
+    std::array<std::uint64_t, 256> counts {};
+    for (std::size_t index = 0; index < size; ++index) {
+        ++counts[data[index]];
+    }
+
+    double entropy = 0.0;
+    const auto total = static_cast<double>(size);
+    for (const auto count : counts) {
+        if (count == 0U) {
+            continue;
+        }
+        const auto probability = static_cast<double>(count) / total;
+        entropy -= probability * std::log2(probability);
+    }
+    return entropy;
+}
+
+std::vector<std::uint8_t> selectionSample(gesa::utils::ByteView data)
+{
+    if (data.size <= kSelectionSampleLimit) {
+        return data.copy();
+    }
+
+    std::vector<std::uint8_t> sample;
+    sample.reserve(kSelectionSampleLimit);
+    const std::size_t starts[3] = {0U, (data.size - kSelectionWindowSize) / 2U, data.size - kSelectionWindowSize};
+    for (const auto start : starts) {
+        const auto window = data.subview(start, kSelectionWindowSize);
+        sample.insert(sample.end(), window.begin(), window.end());
+    }
+    return sample;
+}
+
+} // namespace gesa::compression
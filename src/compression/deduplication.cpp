@@ -0,0 +1,150 @@
+#include "compression/deduplication.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace gesa::compression {
+namespace {
+
+constexpr std::size_t kChunkSize = 64U * 1024U;
+constexpr std::uint64_t kHashSeed = 0x9E3779B97F4A7C15ULL;
+constexpr std::uint64_t kHashMultiplier = 0xFF51AFD7ED558CCDULL;
+
+std::uint64_t mix(std::uint64_t hash, std::uint64_t word)
+{
+    hash ^= word;
+    hash *= kHashMultiplier;
+    hash ^= hash >> 32U;
+    return hash;
+}
+
+std::ifstream openForReading(const std::filesystem::path& path)
+{
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        throw std::runtime_error("Failed to open file for reading: " + path.string());
+    }
+    return input;
+}
+
+} // namespace
+
+std::uint64_t hashFileContents(const std::filesystem::path& path)
+{
+    auto input = openForReading(path);
+    std::vector<char> buffer(kChunkSize);
+
+    std::uint64_t hash = kHashSeed;
+    std::uint64_t total = 0;
+    while (input) {
+        input.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        const auto count = static_cast<std::size_t>(input.gcount());
+        if (count == 0U) {
+            break;
+        }
+
+        std::size_t offset = 0;
+        for (; offset + sizeof(std::uint64_t) <= count; offset += sizeof(std::uint64_t)) {
+            std::uint64_t word = 0;
+            std::memcpy(&word, buffer.data() + offset, sizeof(word));
+            hash = mix(hash, word);
+        }
+        if (offset < count) {
+            std::uint64_t word = 0;
+            std::memcpy(&word, buffer.data() + offset, count - offset);
+            hash = mix(hash, word);
+        }
+        total += count;
+    }
+
+    if (input.bad()) {
+        throw std::runtime_error("Failed to hash file contents: " + path.string());
+    }
+    return mix(hash, total);
+}
+
+bool fileContentsEqual(const std::filesystem::path& lhs, const std::filesystem::path& rhs)
+{
+    auto left = openForReading(lhs);
+    auto right = openForReading(rhs);
+    std::vector<char> leftBuffer(kChunkSize);
+    std::vector<char> rightBuffer(kChunkSize);
+
+    while (true) {
+        left.read(leftBuffer.data(), static_cast<std::streamsize>(leftBuffer.size()));
+        right.read(rightBuffer.data(), static_cast<std::streamsize>(rightBuffer.size()));
+        const auto leftCount = left.gcount();
+        const auto rightCount = right.gcount();
+        if (leftCount != rightCount) {
+            return false;
+        }
+        if (leftCount == 0) {
+            return true;
+        }
+        if (std::memcmp(leftBuffer.data(), rightBuffer.data(), static_cast<std::size_t>(leftCount)) != 0) {
+            return false;
+        }
+    }
+}
+
+std::vector<std::size_t> findDuplicateSources(const std::vector<gesa::filesystem::FileDescriptor>& descriptors,
+                                              gesa::concurrency::ThreadPool& pool,
+                                              const std::vector<bool>& excluded)
+{
+    std::vector<std::size_t> sources(descriptors.size());
+    std::iota(sources.begin(), sources.end(), std::size_t {0});
+
+    std::unordered_map<std::uintmax_t, std::vector<std::size_t>> bySize;
+    for (std::size_t index = 0; index < descriptors.size(); ++index) {
+        const auto& descriptor = descriptors[index];
+        if (index < excluded.size() && excluded[index]) {
+            continue;
+        }
+        if (descriptor.type == gesa::filesystem::EntryType::File && descriptor.size > 0U) {
+            bySize[descriptor.size].push_back(index);
+        }
+    }
+
+    std::vector<std::size_t> candidates;
+    for (const auto& [size, indices] : bySize) {
+        if (indices.size() > 1U) {
+            candidates.insert(candidates.end(), indices.begin(), indices.end());
+        }
+    }
+    if (candidates.empty()) {
+        return sources;
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    const auto hashes = pool.parallelTransform(candidates, 1, [&descriptors](std::size_t index) {
+        return hashFileContents(descriptors[index].absolutePath);
+    });
+
+    std::map<std::pair<std::uintmax_t, std::uint64_t>, std::size_t> firstBySignature;
+    std::vector<std::pair<std::size_t, std::size_t>> pending;
+    for (std::size_t position = 0; position < candidates.size(); ++position) {
+        const auto index = candidates[position];
+        const auto signature = std::make_pair(descriptors[index].size, hashes[position]);
+        const auto [iterator, inserted] = firstBySignature.emplace(signature, index);
+        if (!inserted) {
+            pending.emplace_back(index, iterator->second);
+        }
+    }
+
+    pool.parallelFor(0, pending.size(), 1, [&](std::size_t position) {
+        const auto [duplicate, source] = pending[position];
+        if (fileContentsEqual(descriptors[duplicate].absolutePath, descriptors[source].absolutePath)) {
+            sources[duplicate] = source;
+        }
+    });
+
+    return sources;
+}
+
+} // namespace gesa::compression
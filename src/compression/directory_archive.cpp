@@ -0,0 +1,462 @@
+#include "compression/directory_archive.hpp"
+
+#include "compression/deduplication.hpp"
+#include "compression/scheduling.hpp"
+#include "compression/solid.hpp"
+#include "concurrency/completion_queue.hpp"
+#include "concurrency/memory_budget.hpp"
+#include "concurrency/shared_pool.hpp"
+#include "filesystem/batch_io.hpp"
+#include "filesystem/positional_file.hpp"
+
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+namespace gesa::compression {
+
+namespace {
+
+struct SplitEntry {
+    std::size_t index {0};
+    gesa::filesystem::FileView file;
+};
+
+// Reads and writes are bound by the disk rather than the CPU: a couple at a time keep it
+// busy and leave the other workers to decode.
+constexpr std::size_t kReadStageLimit = 2;
+constexpr std::size_t kWriteStageLimit = 2;
+
+// Each worker keeps its own instance, and with it its io_uring, across the groups it reads
+// and the jobs it writes.
+gesa::filesystem::BatchIo& workerBatchIo()
+{
+    thread_local const auto io = gesa::filesystem::makeBatchIo();
+    return *io;
+}
+
+// Runs one stage of job through token, which records a failure or a skip once. Either way
+// the stage then throws OperationCancelled, so the rest of the job's chain passes it by.
+template <class Work>
+auto runStage(gesa::concurrency::CancellationToken& token, const std::string& job, Work&& work)
+{
+    using Result = std::invoke_result_t<Work&>;
+    if constexpr (std::is_void_v<Result>) {
+        if (!token.run(job, work)) {
+            throw gesa::concurrency::OperationCancelled();
+        }
+    } else {
+        std::optional<Result> result;
+        if (!token.run(job, [&]() { result.emplace(work()); })) {
+            throw gesa::concurrency::OperationCancelled();
+        }
+        return std::move(*result);
+    }
+}
+
+} // namespace
+
+gesa::concurrency::Async<void> DirectoryCodec::encodeSplit(std::size_t, gesa::utils::ByteView,
+                                                           gesa::concurrency::ThreadPool&,
+                                                           const gesa::concurrency::CancellationToken&)
+{
+    throw std::logic_error("Codec does not split files");
+}
+
+void compressDirectoryArchive(const std::filesystem::path& sourceDirectory,
+                              const std::filesystem::path& destinationArchive,
+                              const DirectoryOptions& options, DirectoryCodec& codec)
+{
+    gesa::filesystem::DirectoryContext directory(sourceDirectory);
+    const gesa::concurrency::PoolLease lease(options.threadCount);
+    auto& pool = lease.get();
+    auto& budget = options.memoryBudget != nullptr ? *options.memoryBudget : gesa::concurrency::sharedMemoryBudget();
+    const auto descriptors = directory.listEntries(pool, true, false);
+
+    // Unchanged payloads and solid blocks of a previous archive are copied out of it by
+    // offset when the new archive is written, never read into memory.
+    std::optional<gesa::filesystem::SourceFile> previousFile;
+    std::optional<gesa::filesystem::ScratchFile> scratch;
+    PreviousArchive previous;
+    if (!options.previousArchive.empty()) {
+        previousFile.emplace(options.previousArchive);
+        previous = codec.readPrevious(options.previousArchive, *previousFile);
+    }
+
+    std::size_t blockCount = 0;
+    // Keyed like the archive: solid blocks first, then one record per entry.
+    std::vector<ArchiveRecord> records;
+    // Per record: the budget its payload holds until the archive is written.
+    std::vector<gesa::concurrency::MemoryReservation> held;
+    const auto encodeRecord = [&](std::size_t key) {
+        return key < blockCount ? codec.blockRecord(key) : codec.entryRecord(key - blockCount);
+    };
+
+    if (!descriptors.empty()) {
+        const auto reuse = planReuse(descriptors, previous.entries, previous.blockCount, options.solid);
+        const auto reused = reuse.reusedMask();
+
+        const auto sources = findDuplicateSources(descriptors, pool, reused);
+        const auto blockPlans = planSolidBlocks(descriptors, sources, options, reused);
+
+        const auto carried = reuse.blocks.size();
+        blockCount = carried + blockPlans.size();
+        codec.resize(descriptors.size(), blockCount);
+        for (std::size_t block = 0; block < carried; ++block) {
+            codec.carryBlock(block, reuse.blocks[block]);
+        }
+
+        std::vector<EntryLayout> layouts(descriptors.size());
+        for (std::size_t index = 0; index < descriptors.size(); ++index) {
+            auto& layout = layouts[index];
+            if (sources[index] != index) {
+                layout.kind = EntryKind::Duplicate;
+                layout.sourceIndex = static_cast<std::uint32_t>(sources[index]);
+            }
+            if (!reuse.reused(index)) {
+                continue;
+            }
+
+            const auto& entry = previous.entries[reuse.previous[index]];
+            layout.kind = entry.kind;
+            switch (entry.kind) {
+            case EntryKind::Payload:
+                layout.previous = reuse.previous[index];
+                break;
+            case EntryKind::Duplicate:
+                layout.sourceIndex = static_cast<std::uint32_t>(reuse.reference[index]);
+                break;
+            case EntryKind::Solid:
+                layout.blockIndex = static_cast<std::uint32_t>(reuse.reference[index]);
+                layout.blockOffset = entry.blockOffset;
+                break;
+            }
+        }
+
+        std::vector<ScheduledTask> tasks;
+        for (std::size_t planned = 0; planned < blockPlans.size(); ++planned) {
+            const auto block = carried + planned;
+            const auto& plan = blockPlans[planned];
+            for (std::size_t member = 0; member < plan.members.size(); ++member) {
+                auto& layout = layouts[plan.members[member]];
+                layout.kind = EntryKind::Solid;
+                layout.blockIndex = static_cast<std::uint32_t>(block);
+                layout.blockOffset = plan.offsets[member];
+            }
+            tasks.push_back({block, solidBlockName(block), plan.size, [&codec, &plan, &descriptors, block]() {
+                codec.encodeBlock(block, readSolidBlock(plan, descriptors));
+            }});
+        }
+        for (std::size_t index = 0; index < descriptors.size(); ++index) {
+            codec.layoutEntry(index, descriptors[index], layouts[index]);
+        }
+        records.resize(blockCount + descriptors.size());
+        held.resize(records.size());
+
+        // Files large enough to split are encoded block-parallel once everything else is
+        // queued. Like every other job they are only opened once they have been admitted.
+        std::vector<std::size_t> splitIndices;
+        std::vector<std::size_t> batched;
+        for (std::size_t index = 0; index < descriptors.size(); ++index) {
+            const auto size = static_cast<std::uint64_t>(descriptors[index].size);
+            if (layouts[index].kind != EntryKind::Payload || reused[index]) {
+                continue;
+            }
+            if (size < gesa::filesystem::kMapThreshold) {
+                batched.push_back(index);
+            } else if (size < codec.splitThreshold()) {
+                tasks.push_back({blockCount + index, descriptors[index].relativePath.generic_string(), size,
+                                 [&codec, &descriptor = descriptors[index], index]() {
+                                     const auto file = gesa::filesystem::FileContext(descriptor).view();
+                                     codec.encodeEntry(index, file.bytes());
+                                 }});
+            } else {
+                splitIndices.push_back(index);
+            }
+        }
+
+        // The first failing entry cancels the rest: queued jobs skip their work and the
+        // error is reported once the jobs already running have stopped. Records of
+        // finished jobs are encoded as they complete, between feeding the pool.
+        gesa::concurrency::CancellationToken token;
+        gesa::concurrency::CompletionQueue completions;
+        std::vector<SplitEntry> splits;
+        splits.reserve(splitIndices.size());
+        std::vector<gesa::concurrency::Async<void>> splitJobs;
+        std::size_t splitsFinished = 0;
+        // Keys whose payload is still in memory, holding their output's share of the budget.
+        std::vector<std::size_t> resident;
+        // Per key: the input its small-file group read for it.
+        std::vector<std::vector<std::uint8_t>> inputs(records.size());
+
+        const auto keep = [&](std::size_t key) {
+            records[key] = encodeRecord(key);
+            held[key].shrinkTo(records[key].payload.size);
+            if (records[key].payload.size > 0U) {
+                resident.push_back(key);
+            }
+        };
+        const auto accept = [&](const gesa::concurrency::Completion& completion) {
+            completion.rethrow();
+            if (!token.cancelled()) {
+                keep(completion.key);
+            }
+        };
+        const auto acceptFinished = [&]() {
+            while (const auto completion = completions.tryNext()) {
+                accept(*completion);
+            }
+        };
+        const auto finishSplit = [&]() {
+            const auto position = splitsFinished++;
+            const auto index = splits[position].index;
+            token.run(descriptors[index].relativePath.generic_string(), [&]() { splitJobs[position].get(); });
+            if (!token.cancelled()) {
+                keep(blockCount + index);
+            }
+        };
+        // Finished payloads move to the scratch file and give their bytes back.
+        const auto spill = [&]() {
+            if (resident.empty()) {
+                return false;
+            }
+            if (!scratch) {
+                scratch.emplace(destinationArchive.parent_path());
+            }
+            for (const auto key : resident) {
+                auto& record = records[key];
+                record.copy = {&scratch->source(), scratch->append(record.payload), record.payload.size};
+                record.payload = {};
+                if (key < blockCount) {
+                    codec.releaseBlock(key);
+                } else {
+                    codec.releaseEntry(key - blockCount);
+                }
+                held[key].release();
+            }
+            resident.clear();
+            return true;
+        };
+        // Jobs in flight free their input once taken in; only with none left do finished
+        // payloads leave memory.
+        JobBudget jobs(budget, held, [&]() {
+            if (const auto completion = completions.tryNext()) {
+                accept(*completion);
+                return true;
+            }
+            if (splitsFinished < splitJobs.size()) {
+                finishSplit();
+                return true;
+            }
+            if (completions.outstanding() > 0U) {
+                if (const auto completion = completions.next()) {
+                    accept(*completion);
+                    return true;
+                }
+            }
+            return spill();
+        });
+
+        try {
+            enqueueLargestFirst(std::move(tasks), pool, jobs, token, completions);
+
+            // Small files are read in one batch per group by the worker that encodes them,
+            // so their bytes are first touched on that worker's node.
+            TaskGroup smallFiles(pool, jobs, token, completions, [&](const std::vector<ScheduledTask>& group) {
+                std::vector<gesa::filesystem::ReadRequest> requests;
+                requests.reserve(group.size());
+                for (const auto& task : group) {
+                    const auto& descriptor = descriptors[task.key - blockCount];
+                    requests.push_back({descriptor.absolutePath, static_cast<std::uint64_t>(descriptor.size)});
+                }
+                auto contents = workerBatchIo().readFiles(requests);
+                for (std::size_t member = 0; member < group.size(); ++member) {
+                    inputs[group[member].key] = std::move(contents[member]);
+                }
+            });
+            for (const auto index : batched) {
+                const auto key = blockCount + index;
+                smallFiles.add({key, descriptors[index].relativePath.generic_string(), static_cast<std::uint64_t>(descriptors[index].size),
+                                [&codec, &inputs, index, key]() {
+                                    const auto data = std::move(inputs[key]);
+                                    codec.encodeEntry(index, data);
+                                }});
+                acceptFinished();
+            }
+            smallFiles.flush();
+            acceptFinished();
+
+            // Split files are chained as continuations, so several of them are in flight at
+            // once and no thread parks on one. Each is admitted first, then mapped and
+            // populated by a worker; its blocks are encoded wherever the pool has room, so
+            // unlike whole files they are not kept on the mapping worker's node. The
+            // reservation shrinks to the output once the result has been taken in.
+            for (const auto index : splitIndices) {
+                if (token.cancelled()) {
+                    token.skip(descriptors[index].relativePath.generic_string());
+                    continue;
+                }
+                held[blockCount + index] = jobs.admit(static_cast<std::uint64_t>(descriptors[index].size));
+                auto& split = splits.emplace_back(SplitEntry {index, {}});
+                splitJobs.push_back(gesa::concurrency::async(pool, [&codec, &split, &descriptor = descriptors[index], &pool, &token]() {
+                    split.file = gesa::filesystem::FileContext(descriptor).view();
+                    return codec.encodeSplit(split.index, split.file.bytes(), pool, token);
+                }));
+                acceptFinished();
+            }
+            while (splitsFinished < splitJobs.size()) {
+                finishSplit();
+            }
+
+            while (const auto completion = completions.next()) {
+                accept(*completion);
+            }
+        } catch (...) {
+            token.cancel();
+            for (auto& job : splitJobs) {
+                if (job.valid()) {
+                    job.wait();
+                }
+            }
+            completions.wait();
+            splits.clear();
+            throw;
+        }
+        token.rethrowIfFailed();
+    }
+
+    // Duplicates, solid members and reused entries have no job of their own.
+    for (std::size_t key = 0; key < records.size(); ++key) {
+        if (records[key].header.empty()) {
+            records[key] = encodeRecord(key);
+        }
+    }
+
+    writeArchiveFile(destinationArchive, codec.archiveHeader(descriptors.size(), blockCount), records, pool);
+}
+
+void extractDirectoryArchive(const std::filesystem::path& sourceArchive,
+                             const std::filesystem::path& destinationDirectory, std::size_t threadCount,
+                             const ArchiveContents& contents, const DirectoryDecoder& decoder)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(destinationDirectory, ec);
+    if (ec) {
+        throw std::filesystem::filesystem_error("create_directories", destinationDirectory, ec);
+    }
+
+    const auto& entries = contents.entries;
+    if (entries.empty()) {
+        return;
+    }
+
+    std::vector<std::vector<std::filesystem::path>> outputPaths(entries.size());
+    std::vector<std::vector<std::size_t>> blockMembers(contents.blocks.size());
+    for (std::size_t index = 0; index < entries.size(); ++index) {
+        const auto& entry = entries[index];
+        const auto owner = entry.kind == EntryKind::Duplicate ? entry.reference : index;
+        outputPaths[owner].push_back(destinationDirectory / entry.relativePath);
+        if (entry.kind == EntryKind::Solid) {
+            blockMembers[entry.reference].push_back(index);
+        }
+    }
+
+    // One job per live solid block followed by one per payload entry.
+    std::vector<std::size_t> liveBlocks;
+    for (std::size_t block = 0; block < contents.blocks.size(); ++block) {
+        if (!blockMembers[block].empty()) {
+            liveBlocks.push_back(block);
+        }
+    }
+    std::vector<std::size_t> payloads;
+    for (std::size_t index = 0; index < entries.size(); ++index) {
+        if (entries[index].kind == EntryKind::Payload) {
+            payloads.push_back(index);
+        }
+    }
+    const auto jobCount = liveBlocks.size() + payloads.size();
+    std::vector<std::string> names(jobCount);
+    for (std::size_t job = 0; job < jobCount; ++job) {
+        names[job] = job < liveBlocks.size() ? solidBlockName(liveBlocks[job])
+                                             : entries[payloads[job - liveBlocks.size()]].relativePath.generic_string();
+    }
+
+    const auto writeOutputs = [&](std::size_t job, const std::vector<std::uint8_t>& bytes) {
+        std::vector<gesa::filesystem::WriteRequest> requests;
+        if (job >= liveBlocks.size()) {
+            for (const auto& outputPath : outputPaths[payloads[job - liveBlocks.size()]]) {
+                requests.push_back({outputPath, bytes});
+            }
+        } else {
+            const gesa::utils::ByteView blockBytes(bytes);
+            for (const auto member : blockMembers[liveBlocks[job]]) {
+                const auto slice = blockBytes.subview(static_cast<std::size_t>(entries[member].blockOffset),
+                                                      static_cast<std::size_t>(entries[member].originalSize));
+                for (const auto& outputPath : outputPaths[member]) {
+                    requests.push_back({outputPath, slice});
+                }
+            }
+        }
+        workerBatchIo().writeFiles(requests);
+    };
+
+    const gesa::filesystem::SourceFile archive(sourceArchive);
+    const gesa::concurrency::PoolLease lease(threadCount);
+    auto& pool = lease.get();
+    auto& budget = gesa::concurrency::sharedMemoryBudget();
+    // Declared before the jobs so that they outlive every chain still running on them.
+    gesa::concurrency::Stage reads(pool, kReadStageLimit);
+    gesa::concurrency::Stage writes(pool, kWriteStageLimit);
+    // The first failing job cancels the rest: stages that have not started yet are skipped,
+    // and the error is reported once every chain has settled.
+    gesa::concurrency::CancellationToken token;
+    std::vector<gesa::concurrency::Async<void>> jobs;
+    jobs.reserve(jobCount);
+
+    try {
+        for (std::size_t job = 0; job < jobCount; ++job) {
+            const auto isBlock = job < liveBlocks.size();
+            const auto position = isBlock ? liveBlocks[job] : payloads[job - liveBlocks.size()];
+            const auto offset = isBlock ? contents.blocks[position].payloadOffset : entries[position].payloadOffset;
+            const auto size = isBlock ? contents.blocks[position].payloadSize : entries[position].payloadSize;
+            const auto originalSize = isBlock ? contents.blocks[position].originalSize : entries[position].originalSize;
+            const auto& name = names[job];
+            if (token.cancelled()) {
+                token.skip(name);
+                continue;
+            }
+
+            // Held until the job's outputs are written, or its chain has been skipped.
+            auto reservation = budget.reserve(size + originalSize);
+            jobs.push_back(gesa::concurrency::async(reads, [&archive, &token, &name, offset, size]() {
+                               return runStage(token, name, [&]() { return archive.read(offset, size); });
+                           })
+                               .then(pool, [&decoder, &token, &name, isBlock, position](std::vector<std::uint8_t> payload) {
+                                   return runStage(token, name, [&]() {
+                                       return isBlock ? decoder.decodeBlock(position, std::move(payload))
+                                                      : decoder.decodeEntry(position, std::move(payload));
+                                   });
+                               })
+                               .then(writes, [&writeOutputs, &token, &name, job, reservation = std::move(reservation)](
+                                                 std::vector<std::uint8_t> bytes) {
+                                   runStage(token, name, [&]() { writeOutputs(job, bytes); });
+                               }));
+        }
+    } catch (...) {
+        token.cancel();
+        for (const auto& job : jobs) {
+            job.wait();
+        }
+        throw;
+    }
+
+    for (const auto& job : jobs) {
+        job.wait();
+    }
+    token.rethrowIfFailed();
+}
+
+} // namespace gesa::compression
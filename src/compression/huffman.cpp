@@ -1,24 +1,87 @@
 #include "compression/huffman.hpp"
 
+#include "compression/codec_selection.hpp"
+#include "compression/directory_archive.hpp"
 #include "compression/huffman/archive.hpp"
 #include "compression/huffman/codec.hpp"
 #include "compression/huffman/types.hpp"
+#include "compression/update.hpp"
+#include "concurrency/async.hpp"
+#include "concurrency/cancellation.hpp"
+#include "concurrency/shared_pool.hpp"
 #include "concurrency/thread_pool.hpp"
+#include "filesystem/positional_file.hpp"
 #include "filesystem/resource_context.hpp"
 #include "utils/file_io.hpp"
 
 #include <fstream>
 #include <future>
 #include <stdexcept>
-#include <system_error>
+#include <string>
 #include <vector>
 
 namespace {
 
-gesa::compression::huffman::ArchiveEntry compressEntry(const gesa::filesystem::FileDescriptor& descriptor)
+constexpr std::uint64_t kHuffmanHeaderBytes = sizeof(std::uint64_t) + sizeof(gesa::compression::huffman::FrequencyTable);
+constexpr std::uint64_t kParallelSplitThreshold = 2U * gesa::compression::huffman::kParallelBlockSize;
+
+bool huffmanWorthwhile(gesa::utils::ByteView data)
+{
+    std::vector<std::uint8_t> sample;
+    auto probe = data;
+    if (data.size > gesa::compression::kSelectionSampleLimit) {
+        sample = gesa::compression::selectionSample(data);
+        probe = sample;
+    }
+
+    const auto bits = gesa::compression::estimateEntropyBits(probe.data, probe.size);
+    const auto estimated = static_cast<double>(data.size) * bits / 8.0 + static_cast<double>(kHuffmanHeaderBytes);
+    return estimated < static_cast<double>(data.size);
+}
+
+void storeEntry(gesa::utils::ByteView data, gesa::compression::huffman::ArchiveEntry& entry)
+{
+    entry.codec = gesa::compression::CodecId::Stored;
+    entry.result = gesa::compression::huffman::CompressionResult {};
+    entry.result.metadata.originalSize = static_cast<std::uint64_t>(data.size);
+    entry.result.compressed = data.copy();
+}
+
+void acceptEncoded(gesa::compression::huffman::CompressionResult result, gesa::utils::ByteView data, bool adaptive,
+                   gesa::compression::huffman::ArchiveEntry& entry)
+{
+    if (adaptive && result.compressed.size() + kHuffmanHeaderBytes >= data.size) {
+        storeEntry(data, entry);
+        return;
+    }
+    entry.codec = gesa::compression::CodecId::Huffman;
+    entry.result = std::move(result);
+}
+
+void encodePayload(gesa::utils::ByteView data, bool adaptive, gesa::compression::huffman::ArchiveEntry& entry)
+{
+    if (adaptive && !huffmanWorthwhile(data)) {
+        storeEntry(data, entry);
+        return;
+    }
+    acceptEncoded(gesa::compression::huffman::encodeBuffer(data), data, adaptive, entry);
+}
+
+gesa::compression::huffman::CompressionResult encodeSingleFile(gesa::utils::ByteView data)
+{
+    if (data.size >= kParallelSplitThreshold) {
+        return gesa::compression::huffman::ParallelEncoder(data, gesa::concurrency::sharedPool()).finish();
+    }
+    return gesa::compression::huffman::encodeBuffer(data);
+}
+
+gesa::compression::huffman::ArchiveIndex readPreviousIndex(const std::filesystem::path& previousArchive)
 {
-    const auto result = gesa::compression::huffman::encodeBuffer(gesa::filesystem::FileContext(descriptor.absolutePath).readAll());
-    return gesa::compression::huffman::ArchiveEntry {descriptor.relativePath, result};
+    std::ifstream input(previousArchive, std::ios::binary);
+    if (!input) {
+        throw std::runtime_error("Failed to open previous archive: " + previousArchive.string());
+    }
+    return gesa::compression::huffman::readArchiveIndex(input);
 }
 
 std::vector<std::uint8_t> readFilePayload(std::istream& input, std::uint64_t size)
@@ -33,6 +96,146 @@ std::vector<std::uint8_t> readFilePayload(std::istream& input, std::uint64_t siz
     return buffer;
 }
 
+// Huffman entries and solid blocks for the shared directory driver; files big enough
+// to split are encoded block-parallel through encodeAsync.
+class HuffmanDirectoryCodec final : public gesa::compression::DirectoryCodec {
+public:
+    explicit HuffmanDirectoryCodec(bool adaptive)
+        : adaptive_(adaptive)
+    {
+    }
+
+    gesa::compression::PreviousArchive readPrevious(const std::filesystem::path& archive,
+                                                    const gesa::filesystem::SourceFile& file) override
+    {
+        previousFile_ = &file;
+        previous_ = readPreviousIndex(archive);
+        return {gesa::compression::describePrevious(previous_), previous_.blocks.size()};
+    }
+
+    void resize(std::size_t entryCount, std::size_t blockCount) override
+    {
+        entries_.resize(entryCount);
+        entryCopies_.resize(entryCount);
+        blocks_.resize(blockCount);
+        blockCopies_.resize(blockCount);
+    }
+
+    void carryBlock(std::size_t block, std::size_t previous) override
+    {
+        const auto& carried = previous_.blocks[previous];
+        blocks_[block].metadata = carried.metadata;
+        blockCopies_[block] = {previousFile_, carried.payloadOffset, carried.payloadSize};
+    }
+
+    void layoutEntry(std::size_t index, const gesa::filesystem::FileDescriptor& descriptor,
+                     const gesa::compression::EntryLayout& layout) override
+    {
+        auto& entry = entries_[index];
+        entry.relativePath = descriptor.relativePath;
+        entry.result.metadata.originalSize = static_cast<std::uint64_t>(descriptor.size);
+        entry.lastWriteTime = gesa::compression::toArchiveTime(descriptor.lastWriteTime);
+        entry.kind = layout.kind;
+        entry.sourceIndex = layout.sourceIndex;
+        entry.blockIndex = layout.blockIndex;
+        entry.blockOffset = layout.blockOffset;
+        if (layout.previous != gesa::compression::ReusePlan::kNotReused) {
+            const auto& previous = previous_.entries[layout.previous];
+            entry.codec = previous.codec;
+            entry.result.metadata = previous.metadata;
+            entryCopies_[index] = {previousFile_, previous.payloadOffset, previous.payloadSize};
+        }
+    }
+
+    void encodeBlock(std::size_t block, gesa::utils::ByteView data) override
+    {
+        blocks_[block] = gesa::compression::huffman::encodeBuffer(data);
+    }
+
+    void encodeEntry(std::size_t index, gesa::utils::ByteView data) override
+    {
+        encodePayload(data, adaptive_, entries_[index]);
+    }
+
+    std::uint64_t splitThreshold() const override { return kParallelSplitThreshold; }
+
+    gesa::concurrency::Async<void> encodeSplit(std::size_t index, gesa::utils::ByteView data,
+                                               gesa::concurrency::ThreadPool& pool,
+                                               const gesa::concurrency::CancellationToken& token) override
+    {
+        auto& entry = entries_[index];
+        if (adaptive_ && !huffmanWorthwhile(data)) {
+            storeEntry(data, entry);
+            return gesa::concurrency::Async<void>::ready();
+        }
+        return gesa::compression::huffman::encodeAsync(data, pool, gesa::compression::huffman::kParallelBlockSize, &token)
+            .then(pool, [data, adaptive = adaptive_, &entry](gesa::compression::huffman::CompressionResult encoded) {
+                acceptEncoded(std::move(encoded), data, adaptive, entry);
+            });
+    }
+
+    gesa::compression::ArchiveRecord blockRecord(std::size_t block) const override
+    {
+        return gesa::compression::huffman::encodeSolidBlock(blocks_[block], blockCopies_[block]);
+    }
+
+    gesa::compression::ArchiveRecord entryRecord(std::size_t index) const override
+    {
+        return gesa::compression::huffman::encodeArchiveEntry(entries_[index], entryCopies_[index]);
+    }
+
+    void releaseBlock(std::size_t block) override
+    {
+        blocks_[block].compressed = std::vector<std::uint8_t>();
+    }
+
+    void releaseEntry(std::size_t index) override
+    {
+        entries_[index].result.compressed = std::vector<std::uint8_t>();
+    }
+
+    std::vector<std::uint8_t> archiveHeader(std::size_t entryCount, std::size_t blockCount) const override
+    {
+        return gesa::compression::huffman::encodeArchiveHeader(static_cast<std::uint32_t>(entryCount),
+                                                               static_cast<std::uint32_t>(blockCount));
+    }
+
+private:
+    bool adaptive_ {true};
+    const gesa::filesystem::SourceFile* previousFile_ {nullptr};
+    gesa::compression::huffman::ArchiveIndex previous_;
+    std::vector<gesa::compression::huffman::ArchiveEntry> entries_;
+    std::vector<gesa::compression::huffman::CompressionResult> blocks_;
+    std::vector<gesa::compression::PayloadCopy> entryCopies_;
+    std::vector<gesa::compression::PayloadCopy> blockCopies_;
+};
+
+// Turns the payloads of an archive index back into bytes for the shared extraction driver.
+class HuffmanDirectoryDecoder final : public gesa::compression::DirectoryDecoder {
+public:
+    explicit HuffmanDirectoryDecoder(const gesa::compression::huffman::ArchiveIndex& index)
+        : index_(index)
+    {
+    }
+
+    std::vector<std::uint8_t> decodeBlock(std::size_t block, std::vector<std::uint8_t> payload) const override
+    {
+        return gesa::compression::huffman::decodeBuffer(index_.blocks[block].metadata, payload);
+    }
+
+    std::vector<std::uint8_t> decodeEntry(std::size_t index, std::vector<std::uint8_t> payload) const override
+    {
+        const auto& entry = index_.entries[index];
+        if (entry.codec == gesa::compression::CodecId::Stored) {
+            return payload;
+        }
+        return gesa::compression::huffman::decodeBuffer(entry.metadata, payload);
+    }
+
+private:
+    const gesa::compression::huffman::ArchiveIndex& index_;
+};
+
 } // namespace
 
 namespace gesa::compression::huffman {
@@ -40,8 +243,8 @@ namespace gesa::compression::huffman {
 void compressFile(const std::filesystem::path& source, const std::filesystem::path& destination)
 {
     gesa::filesystem::FileContext context(source);
-    const auto buffer = context.readAll();
-    const auto result = encodeBuffer(buffer);
+    const auto file = context.view();
+    const auto result = encodeSingleFile(file.bytes());
 
     gesa::utils::ensureParentDirectory(destination);
     std::ofstream output(destination, std::ios::binary | std::ios::trunc);
@@ -71,40 +274,41 @@ void decompressFile(const std::filesystem::path& source, const std::filesystem::
     gesa::utils::writeBufferToFile(destination, decompressed);
 }
 
-void compressDirectory(const std::filesystem::path& sourceDirectory,
-                       const std::filesystem::path& destinationArchive,
-                       std::size_t threadCount)
+std::vector<std::uint8_t> compressToImage(gesa::utils::ByteView input)
 {
-    gesa::filesystem::DirectoryContext directory(sourceDirectory);
-    const auto descriptors = directory.listEntries(true, false);
-
-    std::vector<ArchiveEntry> entries;
-    entries.reserve(descriptors.size());
-
-    if (!descriptors.empty()) {
-        gesa::concurrency::ThreadPool pool(threadCount);
-        std::vector<std::future<ArchiveEntry>> futures;
-        futures.reserve(descriptors.size());
-
-        for (const auto& descriptor : descriptors) {
-            futures.emplace_back(pool.enqueue([descriptor]() { return compressEntry(descriptor); }));
-        }
+    const auto result = encodeSingleFile(input);
+    auto image = encodeFileHeader(result.metadata, static_cast<std::uint64_t>(result.compressed.size()));
+    image.insert(image.end(), result.compressed.begin(), result.compressed.end());
+    return image;
+}
 
-        for (auto& future : futures) {
-            entries.emplace_back(future.get());
-        }
+std::vector<std::uint8_t> decompressImage(gesa::utils::ByteView image)
+{
+    gesa::utils::ByteReader reader(image.data, image.size);
+    const auto header = parseFileHeader(reader);
+    if (header.compressedSize > reader.remaining()) {
+        throw std::runtime_error("Truncated Huffman payload");
     }
+    std::vector<std::uint8_t> compressed(static_cast<std::size_t>(header.compressedSize));
+    reader.readBytes(compressed.data(), compressed.size());
+    return decodeBuffer(header.metadata, compressed);
+}
 
-    gesa::utils::ensureParentDirectory(destinationArchive);
-    std::ofstream output(destinationArchive, std::ios::binary | std::ios::trunc);
-    if (!output) {
-        throw std::runtime_error("Failed to open archive for writing: " + destinationArchive.string());
-    }
+void compressDirectory(const std::filesystem::path& sourceDirectory,
+                       const std::filesystem::path& destinationArchive,
+                       std::size_t threadCount)
+{
+    gesa::compression::DirectoryOptions options {};
+    options.threadCount = threadCount;
+    compressDirectory(sourceDirectory, destinationArchive, options);
+}
 
-    writeArchiveHeader(output, static_cast<std::uint32_t>(entries.size()));
-    for (const auto& entry : entries) {
-        writeArchiveEntry(output, entry);
-    }
+void compressDirectory(const std::filesystem::path& sourceDirectory,
+                       const std::filesystem::path& destinationArchive,
+                       const gesa::compression::DirectoryOptions& options)
+{
+    HuffmanDirectoryCodec codec(options.adaptiveCodec);
+    gesa::compression::compressDirectoryArchive(sourceDirectory, destinationArchive, options, codec);
 }
 
 void decompressDirectory(const std::filesystem::path& sourceArchive,
@@ -115,33 +319,54 @@ void decompressDirectory(const std::filesystem::path& sourceArchive,
     if (!input) {
         throw std::runtime_error("Failed to open archive: " + sourceArchive.string());
     }
+    const auto index = readArchiveIndex(input);
+    input.close();
 
-    std::error_code ec;
-    std::filesystem::create_directories(destinationDirectory, ec);
-    if (ec) {
-        throw std::filesystem::filesystem_error("create_directories", destinationDirectory, ec);
-    }
+    const HuffmanDirectoryDecoder decoder(index);
+    gesa::compression::extractDirectoryArchive(sourceArchive, destinationDirectory, threadCount,
+                                               gesa::compression::describeContents(index), decoder);
+}
 
-    auto entries = readArchive(input);
-    if (entries.empty()) {
-        return;
+gesa::compression::ArchiveSummary summarizeArchive(const std::filesystem::path& sourceArchive)
+{
+    std::ifstream input(sourceArchive, std::ios::binary);
+    if (!input) {
+        throw std::runtime_error("Failed to open archive: " + sourceArchive.string());
     }
 
-    gesa::concurrency::ThreadPool pool(threadCount);
-    std::vector<std::future<void>> futures;
-    futures.reserve(entries.size());
+    const auto index = readArchiveIndex(input);
+
+    gesa::compression::ArchiveSummary summary {};
+    summary.codec = "huffman";
+    summary.archiveSize = static_cast<std::uint64_t>(std::filesystem::file_size(sourceArchive));
 
-    for (auto& entry : entries) {
-        const auto outputPath = destinationDirectory / entry.relativePath;
-        futures.emplace_back(pool.enqueue([outputPath, metadata = entry.metadata, compressed = std::move(entry.compressed)]() mutable {
-            const auto decompressed = decodeBuffer(metadata, compressed);
-            gesa::utils::writeBufferToFile(outputPath, decompressed);
-        }));
+    summary.blocks.reserve(index.blocks.size());
+    for (const auto& block : index.blocks) {
+        summary.blocks.push_back({block.metadata.originalSize, block.payloadSize});
     }
 
-    for (auto& future : futures) {
-        future.get();
+    summary.entries.reserve(index.entries.size());
+    for (const auto& entry : index.entries) {
+        gesa::compression::EntrySummary item {};
+        item.relativePath = entry.relativePath;
+        item.kind = entry.kind;
+        item.codec = entry.codec;
+        item.originalSize = entry.metadata.originalSize;
+        switch (entry.kind) {
+        case EntryKind::Payload:
+            item.compressedSize = entry.payloadSize;
+            break;
+        case EntryKind::Duplicate:
+            item.reference = entry.sourceIndex;
+            break;
+        case EntryKind::Solid:
+            item.reference = entry.blockIndex;
+            break;
+        }
+        summary.entries.emplace_back(std::move(item));
     }
+
+    return summary;
 }
 
 } // namespace gesa::compression::huffman
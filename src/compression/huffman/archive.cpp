@@ -1,6 +1,7 @@
 #include "compression/huffman/archive.hpp"
 
 #include "compression/huffman/types.hpp"
+#include "utils/binary_io.hpp"
 
 #include <cstring>
 #include <fstream>
@@ -10,190 +11,276 @@
 namespace gesa::compression::huffman {
 namespace {
 
-template <class T>
-void writeValue(std::ostream& output, T value)
+constexpr std::size_t kFrequencyTableBytes = std::tuple_size_v<FrequencyTable> * sizeof(std::uint32_t);
+constexpr std::size_t kFileHeaderBytes = sizeof(kFileMagic) + 4U + 2U * sizeof(std::uint64_t) + kFrequencyTableBytes;
+constexpr std::size_t kPayloadHeaderBytes = sizeof(std::uint64_t) + kFrequencyTableBytes;
+
+EntryKind readEntryKind(gesa::utils::ByteReader& reader)
 {
-    output.write(reinterpret_cast<const char*>(&value), sizeof(T));
-    if (!output) {
-        throw std::runtime_error("Failed to write binary value");
+    const auto kind = reader.read<std::uint8_t>();
+    if (kind > static_cast<std::uint8_t>(EntryKind::Solid)) {
+        throw std::runtime_error("Unknown archive entry kind");
+    }
+    return static_cast<EntryKind>(kind);
+}
+
+CodecId readCodecId(gesa::utils::ByteReader& reader)
+{
+    const auto codec = static_cast<CodecId>(reader.read<std::uint8_t>());
+    if (codec != CodecId::Stored && codec != CodecId::Huffman) {
+        throw std::runtime_error("Unsupported codec in Huffman archive entry");
     }
+    return codec;
+}
+
+void writePrologue(gesa::utils::BinaryWriter& writer, const char (&magic)[4], std::uint8_t version)
+{
+    writer.writeBytes(magic, sizeof(magic));
+    writer.write(version);
+    const std::uint8_t padding[3] = {0, 0, 0};
+    writer.writeBytes(padding, sizeof(padding));
 }
 
-template <class T>
-T readValue(std::istream& input)
+std::uint8_t readPrologue(gesa::utils::ByteReader& reader, const char (&magic)[4], const char* invalidMagic)
 {
-    T value {};
-    input.read(reinterpret_cast<char*>(&value), sizeof(T));
-    if (input.gcount() != static_cast<std::streamsize>(sizeof(T))) {
-        throw std::runtime_error("Failed to read binary value");
+    char actual[4] = {0, 0, 0, 0};
+    reader.readBytes(actual, sizeof(actual));
+    if (std::memcmp(actual, magic, sizeof(actual)) != 0) {
+        throw std::runtime_error(invalidMagic);
     }
-    return value;
+    const auto version = reader.read<std::uint8_t>();
+    reader.skip(3U);
+    return version;
 }
 
-void writeFrequencies(std::ostream& output, const FrequencyTable& frequencies)
+void writeFrequencies(gesa::utils::BinaryWriter& writer, const FrequencyTable& frequencies)
 {
     for (auto frequency : frequencies) {
-        writeValue(output, frequency);
+        writer.write(frequency);
     }
 }
 
-void readFrequencies(std::istream& input, FrequencyTable& frequencies)
+void readFrequencies(gesa::utils::ByteReader& reader, FrequencyTable& frequencies)
 {
     for (auto& frequency : frequencies) {
-        frequency = readValue<std::uint32_t>(input);
+        frequency = reader.read<std::uint32_t>();
+    }
+}
+
+void indexPayload(gesa::utils::BufferedReader& input, HuffmanMetadata& metadata,
+                  std::uint64_t& payloadOffset, std::uint64_t& payloadSize)
+{
+    auto header = input.take(kPayloadHeaderBytes);
+    payloadSize = header.read<std::uint64_t>();
+    readFrequencies(header, metadata.frequencies);
+
+    payloadOffset = input.position();
+    if (payloadSize > input.size() - payloadOffset) {
+        throw std::runtime_error("Archive payload exceeds archive size");
     }
+    input.skip(payloadSize);
+}
+
+void indexStored(gesa::utils::BufferedReader& input, std::uint64_t originalSize,
+                 std::uint64_t& payloadOffset, std::uint64_t& payloadSize)
+{
+    payloadOffset = input.position();
+    if (originalSize > input.size() - payloadOffset) {
+        throw std::runtime_error("Stored payload exceeds archive size");
+    }
+    payloadSize = originalSize;
+    input.skip(payloadSize);
 }
 
 } // namespace
 
 ParsedFileHeader readFileHeader(std::istream& input)
 {
-    char magic[4] = {0, 0, 0, 0};
-    input.read(magic, sizeof(magic));
-    if (input.gcount() != static_cast<std::streamsize>(sizeof(magic))) {
-        throw std::runtime_error("Failed to read file magic");
-    }
-    if (std::memcmp(magic, kFileMagic, sizeof(magic)) != 0) {
-        throw std::runtime_error("Invalid Huffman file magic");
+    std::uint8_t bytes[kFileHeaderBytes];
+    input.read(reinterpret_cast<char*>(bytes), static_cast<std::streamsize>(sizeof(bytes)));
+    if (input.gcount() != static_cast<std::streamsize>(sizeof(bytes))) {
+        throw std::runtime_error("Failed to read Huffman file header");
     }
 
-    const auto version = readValue<std::uint8_t>(input);
-    if (version != kFormatVersion) {
-        throw std::runtime_error("Unsupported Huffman file version");
-    }
+    gesa::utils::ByteReader reader(bytes, sizeof(bytes));
+    return parseFileHeader(reader);
+}
 
-    char padding[3];
-    input.read(padding, sizeof(padding));
-    if (input.gcount() != static_cast<std::streamsize>(sizeof(padding))) {
-        throw std::runtime_error("Failed to read file padding");
+ParsedFileHeader parseFileHeader(gesa::utils::ByteReader& reader)
+{
+    if (readPrologue(reader, kFileMagic, "Invalid Huffman file magic") != kFormatVersion) {
+        throw std::runtime_error("Unsupported Huffman file version");
     }
 
     ParsedFileHeader header {};
-    header.metadata.originalSize = readValue<std::uint64_t>(input);
-    header.compressedSize = readValue<std::uint64_t>(input);
-    readFrequencies(input, header.metadata.frequencies);
+    header.metadata.originalSize = reader.read<std::uint64_t>();
+    header.compressedSize = reader.read<std::uint64_t>();
+    readFrequencies(reader, header.metadata.frequencies);
     return header;
 }
 
 void writeFileHeader(std::ostream& output, const HuffmanMetadata& metadata, std::uint64_t compressedSize)
 {
-    output.write(kFileMagic, sizeof(kFileMagic));
-    if (!output) {
-        throw std::runtime_error("Failed to write file magic");
-    }
-
-    writeValue(output, kFormatVersion);
-    const std::uint8_t padding[3] = {0, 0, 0};
-    output.write(reinterpret_cast<const char*>(padding), sizeof(padding));
+    const auto header = encodeFileHeader(metadata, compressedSize);
+    output.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
     if (!output) {
-        throw std::runtime_error("Failed to write file padding");
+        throw std::runtime_error("Failed to write Huffman file header");
     }
-
-    writeValue(output, metadata.originalSize);
-    writeValue(output, compressedSize);
-    writeFrequencies(output, metadata.frequencies);
 }
 
-void writeArchiveHeader(std::ostream& output, std::uint32_t fileCount)
+std::vector<std::uint8_t> encodeFileHeader(const HuffmanMetadata& metadata, std::uint64_t compressedSize)
 {
-    output.write(kArchiveMagic, sizeof(kArchiveMagic));
-    if (!output) {
-        throw std::runtime_error("Failed to write archive magic");
-    }
+    gesa::utils::BinaryWriter writer;
+    writePrologue(writer, kFileMagic, kFormatVersion);
+    writer.write(metadata.originalSize);
+    writer.write(compressedSize);
+    writeFrequencies(writer, metadata.frequencies);
+    return writer.release();
+}
 
-    writeValue(output, kFormatVersion);
-    const std::uint8_t padding[3] = {0, 0, 0};
-    output.write(reinterpret_cast<const char*>(padding), sizeof(padding));
-    if (!output) {
-        throw std::runtime_error("Failed to write archive padding");
-    }
+std::vector<std::uint8_t> encodeArchiveHeader(std::uint32_t fileCount, std::uint32_t blockCount)
+{
+    gesa::utils::BinaryWriter writer;
+    writePrologue(writer, kArchiveMagic, kArchiveFormatVersion);
+    writer.write(fileCount);
+    writer.write(blockCount);
+    return writer.release();
+}
 
-    writeValue(output, fileCount);
+ArchiveRecord encodeSolidBlock(const CompressionResult& block, const PayloadCopy& copy)
+{
+    gesa::utils::BinaryWriter writer;
+    writer.write(block.metadata.originalSize);
+    writer.write(copy.source != nullptr ? copy.size : static_cast<std::uint64_t>(block.compressed.size()));
+    writeFrequencies(writer, block.metadata.frequencies);
+    return ArchiveRecord {writer.release(), block.compressed, copy};
 }
 
-void writeArchiveEntry(std::ostream& output, const ArchiveEntry& entry)
+ArchiveRecord encodeArchiveEntry(const ArchiveEntry& entry, const PayloadCopy& copy)
 {
     const auto relative = entry.relativePath.generic_string();
     if (relative.size() > static_cast<std::size_t>(std::numeric_limits<std::uint32_t>::max())) {
         throw std::runtime_error("Relative path exceeds maximum supported length");
     }
 
-    const auto pathSize = static_cast<std::uint32_t>(relative.size());
-    writeValue(output, pathSize);
-    if (pathSize > 0U) {
-        output.write(relative.data(), static_cast<std::streamsize>(relative.size()));
-        if (!output) {
-            throw std::runtime_error("Failed to write archive path");
+    gesa::utils::BinaryWriter writer;
+    writer.write(static_cast<std::uint32_t>(relative.size()));
+    writer.writeString(relative);
+    writer.write(static_cast<std::uint8_t>(entry.kind));
+    writer.write(entry.result.metadata.originalSize);
+    writer.write(entry.lastWriteTime);
+    switch (entry.kind) {
+    case EntryKind::Payload: {
+        const auto payloadSize = copy.source != nullptr ? copy.size : static_cast<std::uint64_t>(entry.result.compressed.size());
+        writer.write(static_cast<std::uint8_t>(entry.codec));
+        if (entry.codec == CodecId::Stored) {
+            if (payloadSize != entry.result.metadata.originalSize) {
+                throw std::runtime_error("Stored payload size does not match original size");
+            }
+        } else {
+            writer.write(payloadSize);
+            writeFrequencies(writer, entry.result.metadata.frequencies);
         }
+        return ArchiveRecord {writer.release(), entry.result.compressed, copy};
     }
-
-    writeValue(output, entry.result.metadata.originalSize);
-    const auto compressedSize = static_cast<std::uint64_t>(entry.result.compressed.size());
-    writeValue(output, compressedSize);
-    writeFrequencies(output, entry.result.metadata.frequencies);
-    if (compressedSize > 0U) {
-        output.write(reinterpret_cast<const char*>(entry.result.compressed.data()), static_cast<std::streamsize>(entry.result.compressed.size()));
-        if (!output) {
-            throw std::runtime_error("Failed to write archive payload");
-        }
+    case EntryKind::Duplicate:
+        writer.write(entry.sourceIndex);
+        break;
+    case EntryKind::Solid:
+        writer.write(entry.blockIndex);
+        writer.write(entry.blockOffset);
+        break;
     }
+    return ArchiveRecord {writer.release(), {}, {}};
 }
 
-std::vector<PendingArchiveEntry> readArchive(std::istream& input)
+ArchiveIndex readArchiveIndex(std::istream& stream)
 {
-    char magic[4] = {0, 0, 0, 0};
-    input.read(magic, sizeof(magic));
-    if (input.gcount() != static_cast<std::streamsize>(sizeof(magic))) {
-        throw std::runtime_error("Failed to read archive magic");
-    }
-    if (std::memcmp(magic, kArchiveMagic, sizeof(magic)) != 0) {
-        throw std::runtime_error("Invalid archive magic");
-    }
+    gesa::utils::BufferedReader input(stream);
 
-    const auto version = readValue<std::uint8_t>(input);
-    if (version != kFormatVersion) {
+    auto prologue = input.take(sizeof(kArchiveMagic) + 4U);
+    const auto version = readPrologue(prologue, kArchiveMagic, "Invalid archive magic");
+    if (version < kLegacyArchiveFormatVersion || version > kArchiveFormatVersion) {
         throw std::runtime_error("Unsupported archive version");
     }
 
-    char padding[3];
-    input.read(padding, sizeof(padding));
-    if (input.gcount() != static_cast<std::streamsize>(sizeof(padding))) {
-        throw std::runtime_error("Failed to read archive padding");
+    const bool hasEntryKinds = version >= 2U;
+    const bool hasSolidBlocks = version >= 3U;
+    const bool hasTimestamps = version >= 4U;
+    const bool hasCodecIds = version >= 5U;
+
+    const auto fileCount = input.read<std::uint32_t>();
+    const auto blockCount = hasSolidBlocks ? input.read<std::uint32_t>() : std::uint32_t {0};
+
+    ArchiveIndex index {};
+    index.blocks.reserve(blockCount);
+    for (std::uint32_t block = 0; block < blockCount; ++block) {
+        BlockIndexEntry entry {};
+        entry.metadata.originalSize = input.read<std::uint64_t>();
+        indexPayload(input, entry.metadata, entry.payloadOffset, entry.payloadSize);
+        index.blocks.emplace_back(entry);
     }
 
-    const auto fileCount = readValue<std::uint32_t>(input);
+    const std::size_t fixedBytes = (hasEntryKinds ? 1U : 0U) + sizeof(std::uint64_t)
+        + (hasTimestamps ? sizeof(std::int64_t) : 0U);
 
-    std::vector<PendingArchiveEntry> entries;
+    auto& entries = index.entries;
     entries.reserve(fileCount);
-
-    for (std::uint32_t index = 0; index < fileCount; ++index) {
-        const auto pathSize = readValue<std::uint32_t>(input);
-        std::string relativePath(pathSize, '\0');
-        if (pathSize > 0U) {
-            input.read(relativePath.data(), static_cast<std::streamsize>(pathSize));
-            if (input.gcount() != static_cast<std::streamsize>(pathSize)) {
-                throw std::runtime_error("Failed to read archive path");
-            }
+    for (std::uint32_t position = 0; position < fileCount; ++position) {
+        const auto pathSize = input.read<std::uint32_t>();
+        if (pathSize > input.size() - input.position()) {
+            throw std::runtime_error("Archive path exceeds archive size");
         }
+        std::string relativePath(pathSize, '\0');
+        input.readBytes(relativePath.data(), pathSize);
 
-        PendingArchiveEntry entry {};
+        ArchiveIndexEntry entry {};
         entry.relativePath = std::filesystem::path(relativePath);
-        entry.metadata.originalSize = readValue<std::uint64_t>(input);
-        const auto compressedSize = readValue<std::uint64_t>(input);
-        readFrequencies(input, entry.metadata.frequencies);
-
-        entry.compressed.resize(static_cast<std::size_t>(compressedSize));
-        if (compressedSize > 0U) {
-            input.read(reinterpret_cast<char*>(entry.compressed.data()), static_cast<std::streamsize>(compressedSize));
-            if (input.gcount() != static_cast<std::streamsize>(compressedSize)) {
-                throw std::runtime_error("Failed to read archive compressed payload");
+
+        auto fixed = input.take(fixedBytes);
+        if (hasEntryKinds) {
+            entry.kind = readEntryKind(fixed);
+        }
+        entry.metadata.originalSize = fixed.read<std::uint64_t>();
+        if (hasTimestamps) {
+            entry.lastWriteTime = fixed.read<std::int64_t>();
+        }
+
+        switch (entry.kind) {
+        case EntryKind::Payload:
+            if (hasCodecIds) {
+                auto codec = input.take(1U);
+                entry.codec = readCodecId(codec);
+            }
+            if (entry.codec == CodecId::Stored) {
+                indexStored(input, entry.metadata.originalSize, entry.payloadOffset, entry.payloadSize);
+            } else {
+                indexPayload(input, entry.metadata, entry.payloadOffset, entry.payloadSize);
             }
+            break;
+        case EntryKind::Duplicate:
+            entry.sourceIndex = input.read<std::uint32_t>();
+            if (entry.sourceIndex >= position || entries[entry.sourceIndex].kind == EntryKind::Duplicate) {
+                throw std::runtime_error("Invalid duplicate entry reference in archive");
+            }
+            break;
+        case EntryKind::Solid: {
+            auto reference = input.take(sizeof(std::uint32_t) + sizeof(std::uint64_t));
+            entry.blockIndex = reference.read<std::uint32_t>();
+            entry.blockOffset = reference.read<std::uint64_t>();
+            if (entry.blockIndex >= index.blocks.size()
+                || entry.blockOffset > index.blocks[entry.blockIndex].metadata.originalSize
+                || entry.metadata.originalSize > index.blocks[entry.blockIndex].metadata.originalSize - entry.blockOffset) {
+                throw std::runtime_error("Invalid solid block reference in archive");
+            }
+            break;
+        }
         }
 
         entries.emplace_back(std::move(entry));
     }
 
-    return entries;
+    return index;
 }
 
 std::string readMagic(const std::filesystem::path& path)
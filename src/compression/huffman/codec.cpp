@@ -2,7 +2,9 @@
 
 #include "compression/huffman/bit_stream.hpp"
 
+#include <algorithm>
 #include <array>
+#include <cstring>
 #include <memory>
 #include <queue>
 #include <stdexcept>
@@ -97,34 +99,31 @@ void buildCodeTable(Node* node, std::vector<bool>& prefix, std::array<CodeTableE
     prefix.pop_back();
 }
 
-} // namespace
+using CodeTable = std::array<CodeTableEntry, 256>;
 
-CompressionResult encodeBuffer(const std::vector<std::uint8_t>& input)
+void countFrequencies(gesa::utils::ByteView input, FrequencyTable& frequencies)
 {
-    CompressionResult result {};
-    result.metadata.originalSize = static_cast<std::uint64_t>(input.size());
-
-    if (input.empty()) {
-        return result;
-    }
-
-    FrequencyTable& frequencies = result.metadata.frequencies;
     for (const auto value : input) {
         ++frequencies[static_cast<std::size_t>(value)];
     }
+}
 
+bool buildCodes(const FrequencyTable& frequencies, CodeTable& table)
+{
     NodeStorage storage;
     storage.reserve(512);
     Node* root = buildTree(frequencies, storage);
     if (!root) {
-        return result;
+        return false;
     }
 
-    std::array<CodeTableEntry, 256> table;
     std::vector<bool> prefix;
     buildCodeTable(root, prefix, table);
+    return true;
+}
 
-    BitWriter writer;
+void writeCodes(gesa::utils::ByteView input, const CodeTable& table, BitWriter& writer)
+{
     for (const auto value : input) {
         const auto& bits = table[static_cast<std::size_t>(value)].bits;
         if (bits.empty()) {
@@ -132,11 +131,159 @@ CompressionResult encodeBuffer(const std::vector<std::uint8_t>& input)
         }
         writer.writeCode(bits);
     }
+}
 
+} // namespace
+
+CompressionResult encodeBuffer(gesa::utils::ByteView input)
+{
+    CompressionResult result {};
+    result.metadata.originalSize = static_cast<std::uint64_t>(input.size);
+
+    if (input.empty()) {
+        return result;
+    }
+
+    countFrequencies(input, result.metadata.frequencies);
+
+    CodeTable table;
+    if (!buildCodes(result.metadata.frequencies, table)) {
+        return result;
+    }
+
+    BitWriter writer;
+    writeCodes(input, table, writer);
     result.compressed = writer.finish();
     return result;
 }
 
+namespace {
+
+// Shared by the steps of one block-parallel encode.
+struct BlockEncoding {
+    gesa::utils::ByteView input;
+    std::size_t blockSize {1};
+    const gesa::concurrency::CancellationToken* token {nullptr};
+    std::vector<FrequencyTable> blockFrequencies;
+    CodeTable table;
+    std::vector<std::uint64_t> startBits;
+    std::vector<std::uint8_t> leadingBytes;
+    CompressionResult result {};
+
+    gesa::utils::ByteView block(std::size_t index) const noexcept
+    {
+        const auto offset = index * blockSize;
+        return input.subview(offset, std::min(blockSize, input.size - offset));
+    }
+
+    void throwIfCancelled() const
+    {
+        if (token != nullptr) {
+            token->throwIfCancelled();
+        }
+    }
+};
+
+} // namespace
+
+gesa::concurrency::Async<CompressionResult> encodeAsync(gesa::utils::ByteView input, gesa::concurrency::ThreadPool& pool,
+                                                        std::size_t blockSize,
+                                                        const gesa::concurrency::CancellationToken* token)
+{
+    auto encoding = std::make_shared<BlockEncoding>();
+    encoding->input = input;
+    encoding->blockSize = std::max<std::size_t>(blockSize, 1U);
+    encoding->token = token;
+
+    const auto blockCount = (input.size + encoding->blockSize - 1U) / encoding->blockSize;
+    encoding->blockFrequencies.assign(blockCount, FrequencyTable {});
+    std::vector<gesa::concurrency::Async<void>> counts;
+    counts.reserve(blockCount);
+    for (std::size_t index = 0; index < blockCount; ++index) {
+        counts.push_back(gesa::concurrency::async(pool, [encoding, index]() {
+            encoding->throwIfCancelled();
+            countFrequencies(encoding->block(index), encoding->blockFrequencies[index]);
+        }));
+    }
+
+    return gesa::concurrency::whenAll(std::move(counts))
+        .then(pool, [encoding, &pool]() {
+            auto& result = encoding->result;
+            result.metadata.originalSize = static_cast<std::uint64_t>(encoding->input.size);
+            for (const auto& frequencies : encoding->blockFrequencies) {
+                for (std::size_t symbol = 0; symbol < frequencies.size(); ++symbol) {
+                    result.metadata.frequencies[symbol] += frequencies[symbol];
+                }
+            }
+
+            std::vector<gesa::concurrency::Async<void>> emits;
+            if (encoding->input.empty() || !buildCodes(result.metadata.frequencies, encoding->table)) {
+                return gesa::concurrency::whenAll(std::move(emits));
+            }
+
+            // Block frequencies give every block's exact bit length, so each block can be
+            // emitted independently at its final bit offset.
+            const auto blockCount = encoding->blockFrequencies.size();
+            const auto& table = encoding->table;
+            auto& startBits = encoding->startBits;
+            startBits.assign(blockCount + 1U, 0);
+            for (std::size_t index = 0; index < blockCount; ++index) {
+                std::uint64_t bits = 0;
+                for (std::size_t symbol = 0; symbol < table.size(); ++symbol) {
+                    bits += static_cast<std::uint64_t>(encoding->blockFrequencies[index][symbol]) * table[symbol].bits.size();
+                }
+                startBits[index + 1U] = startBits[index] + bits;
+            }
+            result.compressed.assign(static_cast<std::size_t>((startBits[blockCount] + 7U) / 8U), 0);
+
+            // Each block writes every byte it owns except its first, which it may share with
+            // the previous block; those are merged once all blocks are done.
+            encoding->leadingBytes.assign(blockCount, 0);
+            emits.reserve(blockCount);
+            for (std::size_t index = 0; index < blockCount; ++index) {
+                emits.push_back(gesa::concurrency::async(pool, [encoding, index]() {
+                    encoding->throwIfCancelled();
+                    BitWriter writer;
+                    for (auto padding = encoding->startBits[index] % 8U; padding > 0U; --padding) {
+                        writer.writeBit(false);
+                    }
+                    writeCodes(encoding->block(index), encoding->table, writer);
+                    const auto bytes = writer.finish();
+
+                    const auto first = static_cast<std::size_t>(encoding->startBits[index] / 8U);
+                    encoding->leadingBytes[index] = bytes.front();
+                    std::memcpy(encoding->result.compressed.data() + first + 1U, bytes.data() + 1U, bytes.size() - 1U);
+                }));
+            }
+            return gesa::concurrency::whenAll(std::move(emits));
+        })
+        .then(pool, [encoding]() {
+            for (std::size_t index = 0; index < encoding->leadingBytes.size(); ++index) {
+                encoding->result.compressed[static_cast<std::size_t>(encoding->startBits[index] / 8U)] |=
+                    encoding->leadingBytes[index];
+            }
+            return std::move(encoding->result);
+        });
+}
+
+ParallelEncoder::ParallelEncoder(gesa::utils::ByteView input, gesa::concurrency::ThreadPool& pool,
+                                 std::size_t blockSize, const gesa::concurrency::CancellationToken* token)
+    : pending_(encodeAsync(input, pool, blockSize, token))
+{
+}
+
+ParallelEncoder::~ParallelEncoder()
+{
+    if (pending_.valid()) {
+        pending_.wait();
+    }
+}
+
+CompressionResult ParallelEncoder::finish()
+{
+    return pending_.get();
+}
+
 std::vector<std::uint8_t> decodeBuffer(const HuffmanMetadata& metadata, const std::vector<std::uint8_t>& compressed)
 {
     std::vector<std::uint8_t> output;
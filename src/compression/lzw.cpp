@@ -1,25 +1,66 @@
 #include "compression/lzw.hpp"
 
+#include "compression/codec_selection.hpp"
+#include "compression/directory_archive.hpp"
 #include "compression/lzw/archive.hpp"
 #include "compression/lzw/codec.hpp"
 #include "compression/lzw/types.hpp"
-#include "concurrency/thread_pool.hpp"
+#include "compression/update.hpp"
+#include "filesystem/positional_file.hpp"
 #include "filesystem/resource_context.hpp"
 #include "utils/file_io.hpp"
 
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <future>
 #include <stdexcept>
-#include <system_error>
+#include <string>
 #include <vector>
 
 namespace {
 
-gesa::compression::lzw::ArchiveEntry compressEntry(const gesa::filesystem::FileDescriptor& descriptor)
+constexpr std::uint64_t kLzwHeaderBytes = sizeof(std::uint16_t) + sizeof(std::uint64_t);
+
+bool lzwShrinks(const gesa::compression::lzw::CompressionResult& result, std::size_t inputSize)
+{
+    return result.codes.size() * sizeof(std::uint16_t) + kLzwHeaderBytes < inputSize;
+}
+
+bool lzwWorthwhile(gesa::utils::ByteView data)
+{
+    if (data.size <= gesa::compression::kSelectionSampleLimit) {
+        return true;
+    }
+    const auto sample = gesa::compression::selectionSample(data);
+    return lzwShrinks(gesa::compression::lzw::encodeBuffer(sample), sample.size());
+}
+
+void encodePayload(gesa::utils::ByteView data, bool adaptive, gesa::compression::lzw::ArchiveEntry& entry)
+{
+    if (!adaptive || lzwWorthwhile(data)) {
+        auto result = gesa::compression::lzw::encodeBuffer(data);
+        if (!adaptive || lzwShrinks(result, data.size)) {
+            entry.codec = gesa::compression::CodecId::LZW;
+            entry.metadata = result.metadata;
+            entry.codes = std::move(result.codes);
+            return;
+        }
+    }
+
+    entry.codec = gesa::compression::CodecId::Stored;
+    entry.metadata = gesa::compression::lzw::LZWMetadata {};
+    entry.metadata.originalSize = static_cast<std::uint64_t>(data.size);
+    entry.stored = data.copy();
+}
+
+gesa::compression::lzw::ArchiveIndex readPreviousIndex(const std::filesystem::path& previousArchive)
 {
-    gesa::compression::lzw::CompressionResult result = gesa::compression::lzw::encodeBuffer(gesa::filesystem::FileContext(descriptor.absolutePath).readAll());
-    return gesa::compression::lzw::ArchiveEntry {descriptor.relativePath, result.metadata, std::move(result.codes)};
+    std::ifstream input(previousArchive, std::ios::binary);
+    if (!input) {
+        throw std::runtime_error("Failed to open previous archive: " + previousArchive.string());
+    }
+    return gesa::compression::lzw::readArchiveIndex(input);
 }
 
 std::vector<std::uint16_t> readCodeStream(std::istream& input, std::uint64_t count)
@@ -34,6 +75,140 @@ std::vector<std::uint16_t> readCodeStream(std::istream& input, std::uint64_t cou
     return codes;
 }
 
+// LZW entries and solid blocks for the shared directory driver.
+class LzwDirectoryCodec final : public gesa::compression::DirectoryCodec {
+public:
+    explicit LzwDirectoryCodec(bool adaptive)
+        : adaptive_(adaptive)
+    {
+    }
+
+    gesa::compression::PreviousArchive readPrevious(const std::filesystem::path& archive,
+                                                    const gesa::filesystem::SourceFile& file) override
+    {
+        previousFile_ = &file;
+        previous_ = readPreviousIndex(archive);
+        return {gesa::compression::describePrevious(previous_), previous_.blocks.size()};
+    }
+
+    void resize(std::size_t entryCount, std::size_t blockCount) override
+    {
+        entries_.resize(entryCount);
+        entryCopies_.resize(entryCount);
+        blocks_.resize(blockCount);
+        blockCopies_.resize(blockCount);
+    }
+
+    void carryBlock(std::size_t block, std::size_t previous) override
+    {
+        const auto& carried = previous_.blocks[previous];
+        blocks_[block].metadata = carried.metadata;
+        blockCopies_[block] = {previousFile_, carried.payloadOffset, carried.payloadSize};
+    }
+
+    void layoutEntry(std::size_t index, const gesa::filesystem::FileDescriptor& descriptor,
+                     const gesa::compression::EntryLayout& layout) override
+    {
+        auto& entry = entries_[index];
+        entry.relativePath = descriptor.relativePath;
+        entry.metadata.originalSize = static_cast<std::uint64_t>(descriptor.size);
+        entry.lastWriteTime = gesa::compression::toArchiveTime(descriptor.lastWriteTime);
+        entry.kind = layout.kind;
+        entry.sourceIndex = layout.sourceIndex;
+        entry.blockIndex = layout.blockIndex;
+        entry.blockOffset = layout.blockOffset;
+        if (layout.previous != gesa::compression::ReusePlan::kNotReused) {
+            const auto& previous = previous_.entries[layout.previous];
+            entry.codec = previous.codec;
+            entry.metadata = previous.metadata;
+            entryCopies_[index] = {previousFile_, previous.payloadOffset, previous.payloadSize};
+        }
+    }
+
+    void encodeBlock(std::size_t block, gesa::utils::ByteView data) override
+    {
+        blocks_[block] = gesa::compression::lzw::encodeBuffer(data);
+    }
+
+    void encodeEntry(std::size_t index, gesa::utils::ByteView data) override
+    {
+        encodePayload(data, adaptive_, entries_[index]);
+    }
+
+    gesa::compression::ArchiveRecord blockRecord(std::size_t block) const override
+    {
+        return gesa::compression::lzw::encodeSolidBlock(blocks_[block], blockCopies_[block]);
+    }
+
+    gesa::compression::ArchiveRecord entryRecord(std::size_t index) const override
+    {
+        return gesa::compression::lzw::encodeArchiveEntry(entries_[index], entryCopies_[index]);
+    }
+
+    void releaseBlock(std::size_t block) override
+    {
+        blocks_[block].codes = std::vector<std::uint16_t>();
+    }
+
+    void releaseEntry(std::size_t index) override
+    {
+        entries_[index].codes = std::vector<std::uint16_t>();
+        entries_[index].stored = std::vector<std::uint8_t>();
+    }
+
+    std::vector<std::uint8_t> archiveHeader(std::size_t entryCount, std::size_t blockCount) const override
+    {
+        return gesa::compression::lzw::encodeArchiveHeader(static_cast<std::uint32_t>(entryCount),
+                                                           static_cast<std::uint32_t>(blockCount));
+    }
+
+private:
+    bool adaptive_ {true};
+    const gesa::filesystem::SourceFile* previousFile_ {nullptr};
+    gesa::compression::lzw::ArchiveIndex previous_;
+    std::vector<gesa::compression::lzw::ArchiveEntry> entries_;
+    std::vector<gesa::compression::lzw::CompressionResult> blocks_;
+    std::vector<gesa::compression::PayloadCopy> entryCopies_;
+    std::vector<gesa::compression::PayloadCopy> blockCopies_;
+};
+
+// Code streams are stored as the encoder's uint16_t array, in its byte order.
+std::vector<std::uint16_t> codesOf(const std::vector<std::uint8_t>& payload)
+{
+    if (payload.size() % sizeof(std::uint16_t) != 0U) {
+        throw std::runtime_error("Invalid archive code stream size");
+    }
+    std::vector<std::uint16_t> codes(payload.size() / sizeof(std::uint16_t));
+    std::memcpy(codes.data(), payload.data(), payload.size());
+    return codes;
+}
+
+// Turns the payloads of an archive index back into bytes for the shared extraction driver.
+class LzwDirectoryDecoder final : public gesa::compression::DirectoryDecoder {
+public:
+    explicit LzwDirectoryDecoder(const gesa::compression::lzw::ArchiveIndex& index)
+        : index_(index)
+    {
+    }
+
+    std::vector<std::uint8_t> decodeBlock(std::size_t block, std::vector<std::uint8_t> payload) const override
+    {
+        return gesa::compression::lzw::decodeBuffer(index_.blocks[block].metadata, codesOf(payload));
+    }
+
+    std::vector<std::uint8_t> decodeEntry(std::size_t index, std::vector<std::uint8_t> payload) const override
+    {
+        const auto& entry = index_.entries[index];
+        if (entry.codec == gesa::compression::CodecId::Stored) {
+            return payload;
+        }
+        return gesa::compression::lzw::decodeBuffer(entry.metadata, codesOf(payload));
+    }
+
+private:
+    const gesa::compression::lzw::ArchiveIndex& index_;
+};
+
 } // namespace
 
 namespace gesa::compression::lzw {
@@ -41,8 +216,8 @@ namespace gesa::compression::lzw {
 void compressFile(const std::filesystem::path& source, const std::filesystem::path& destination)
 {
     gesa::filesystem::FileContext context(source);
-    const auto data = context.readAll();
-    const auto result = encodeBuffer(data);
+    const auto file = context.view();
+    const auto result = encodeBuffer(file.bytes());
 
     gesa::utils::ensureParentDirectory(destination);
     std::ofstream output(destination, std::ios::binary | std::ios::trunc);
@@ -72,40 +247,42 @@ void decompressFile(const std::filesystem::path& source, const std::filesystem::
     gesa::utils::writeBufferToFile(destination, decompressed);
 }
 
-void compressDirectory(const std::filesystem::path& sourceDirectory,
-                       const std::filesystem::path& destinationArchive,
-                       std::size_t threadCount)
+std::vector<std::uint8_t> compressToImage(gesa::utils::ByteView input)
 {
-    gesa::filesystem::DirectoryContext directory(sourceDirectory);
-    const auto descriptors = directory.listEntries(true, false);
-
-    std::vector<ArchiveEntry> entries;
-    entries.reserve(descriptors.size());
-
-    if (!descriptors.empty()) {
-        gesa::concurrency::ThreadPool pool(threadCount);
-        std::vector<std::future<ArchiveEntry>> futures;
-        futures.reserve(descriptors.size());
-
-        for (const auto& descriptor : descriptors) {
-            futures.emplace_back(pool.enqueue([descriptor]() { return compressEntry(descriptor); }));
-        }
+    const auto result = encodeBuffer(input);
+    auto image = encodeFileHeader(result.metadata, static_cast<std::uint64_t>(result.codes.size()));
+    const auto* codes = reinterpret_cast<const std::uint8_t*>(result.codes.data());
+    image.insert(image.end(), codes, codes + result.codes.size() * sizeof(std::uint16_t));
+    return image;
+}
 
-        for (auto& future : futures) {
-            entries.emplace_back(future.get());
-        }
+std::vector<std::uint8_t> decompressImage(gesa::utils::ByteView image)
+{
+    gesa::utils::ByteReader reader(image.data, image.size);
+    const auto header = parseFileHeader(reader);
+    if (header.codeCount > reader.remaining() / sizeof(std::uint16_t)) {
+        throw std::runtime_error("Truncated LZW code stream");
     }
+    std::vector<std::uint16_t> codes(static_cast<std::size_t>(header.codeCount));
+    reader.readBytes(codes.data(), codes.size() * sizeof(std::uint16_t));
+    return decodeBuffer(header.metadata, codes);
+}
 
-    gesa::utils::ensureParentDirectory(destinationArchive);
-    std::ofstream output(destinationArchive, std::ios::binary | std::ios::trunc);
-    if (!output) {
-        throw std::runtime_error("Failed to open archive for writing: " + destinationArchive.string());
-    }
+void compressDirectory(const std::filesystem::path& sourceDirectory,
+                       const std::filesystem::path& destinationArchive,
+                       std::size_t threadCount)
+{
+    gesa::compression::DirectoryOptions options {};
+    options.threadCount = threadCount;
+    compressDirectory(sourceDirectory, destinationArchive, options);
+}
 
-    writeArchiveHeader(output, static_cast<std::uint32_t>(entries.size()));
-    for (const auto& entry : entries) {
-        writeArchiveEntry(output, entry);
-    }
+void compressDirectory(const std::filesystem::path& sourceDirectory,
+                       const std::filesystem::path& destinationArchive,
+                       const gesa::compression::DirectoryOptions& options)
+{
+    LzwDirectoryCodec codec(options.adaptiveCodec);
+    gesa::compression::compressDirectoryArchive(sourceDirectory, destinationArchive, options, codec);
 }
 
 void decompressDirectory(const std::filesystem::path& sourceArchive,
@@ -116,33 +293,54 @@ void decompressDirectory(const std::filesystem::path& sourceArchive,
     if (!input) {
         throw std::runtime_error("Failed to open archive: " + sourceArchive.string());
     }
+    const auto index = readArchiveIndex(input);
+    input.close();
 
-    std::error_code ec;
-    std::filesystem::create_directories(destinationDirectory, ec);
-    if (ec) {
-        throw std::filesystem::filesystem_error("create_directories", destinationDirectory, ec);
-    }
+    const LzwDirectoryDecoder decoder(index);
+    gesa::compression::extractDirectoryArchive(sourceArchive, destinationDirectory, threadCount,
+                                               gesa::compression::describeContents(index), decoder);
+}
 
-    auto entries = readArchive(input);
-    if (entries.empty()) {
-        return;
+gesa::compression::ArchiveSummary summarizeArchive(const std::filesystem::path& sourceArchive)
+{
+    std::ifstream input(sourceArchive, std::ios::binary);
+    if (!input) {
+        throw std::runtime_error("Failed to open archive: " + sourceArchive.string());
     }
 
-    gesa::concurrency::ThreadPool pool(threadCount);
-    std::vector<std::future<void>> futures;
-    futures.reserve(entries.size());
+    const auto index = readArchiveIndex(input);
+
+    gesa::compression::ArchiveSummary summary {};
+    summary.codec = "lzw";
+    summary.archiveSize = static_cast<std::uint64_t>(std::filesystem::file_size(sourceArchive));
 
-    for (auto& entry : entries) {
-        auto outputPath = destinationDirectory / entry.relativePath;
-        futures.emplace_back(pool.enqueue([outputPath, metadata = entry.metadata, codes = std::move(entry.codes)]() mutable {
-            const auto decompressed = decodeBuffer(metadata, codes);
-            gesa::utils::writeBufferToFile(outputPath, decompressed);
-        }));
+    summary.blocks.reserve(index.blocks.size());
+    for (const auto& block : index.blocks) {
+        summary.blocks.push_back({block.metadata.originalSize, block.payloadSize});
     }
 
-    for (auto& future : futures) {
-        future.get();
+    summary.entries.reserve(index.entries.size());
+    for (const auto& entry : index.entries) {
+        gesa::compression::EntrySummary item {};
+        item.relativePath = entry.relativePath;
+        item.kind = entry.kind;
+        item.codec = entry.codec;
+        item.originalSize = entry.metadata.originalSize;
+        switch (entry.kind) {
+        case EntryKind::Payload:
+            item.compressedSize = entry.payloadSize;
+            break;
+        case EntryKind::Duplicate:
+            item.reference = entry.sourceIndex;
+            break;
+        case EntryKind::Solid:
+            item.reference = entry.blockIndex;
+            break;
+        }
+        summary.entries.emplace_back(std::move(item));
     }
+
+    return summary;
 }
 
 } // namespace gesa::compression::lzw
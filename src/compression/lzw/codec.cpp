@@ -7,10 +7,10 @@
 
 namespace gesa::compression::lzw {
 
-CompressionResult encodeBuffer(const std::vector<std::uint8_t>& input)
+CompressionResult encodeBuffer(gesa::utils::ByteView input)
 {
     CompressionResult result {};
-    result.metadata.originalSize = static_cast<std::uint64_t>(input.size());
+    result.metadata.originalSize = static_cast<std::uint64_t>(input.size);
 
     if (input.empty()) {
         return result;
@@ -0,0 +1,139 @@
+#include "compression/scheduling.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+namespace gesa::compression {
+
+std::string solidBlockName(std::size_t block)
+{
+    return "solid block " + std::to_string(block);
+}
+
+JobBudget::JobBudget(gesa::concurrency::MemoryBudget& budget, std::vector<gesa::concurrency::MemoryReservation>& held,
+                     std::function<bool()> makeRoom)
+    : budget_(budget), held_(held), makeRoom_(std::move(makeRoom))
+{
+}
+
+gesa::concurrency::MemoryReservation JobBudget::admit(std::uint64_t cost)
+{
+    while (true) {
+        if (auto reservation = tryAdmit(cost)) {
+            return std::move(*reservation);
+        }
+        if (!makeRoom_()) {
+            return budget_.reserve(compressionFootprint(cost));
+        }
+    }
+}
+
+std::optional<gesa::concurrency::MemoryReservation> JobBudget::tryAdmit(std::uint64_t cost)
+{
+    return budget_.tryReserve(compressionFootprint(cost));
+}
+
+void JobBudget::handOver(std::size_t key, gesa::concurrency::MemoryReservation reservation)
+{
+    held_[key] = std::move(reservation);
+}
+
+void enqueueLargestFirst(std::vector<ScheduledTask> tasks, gesa::concurrency::ThreadPool& pool, JobBudget& budget,
+                         gesa::concurrency::CancellationToken& token,
+                         gesa::concurrency::CompletionQueue& completions)
+{
+    std::stable_sort(tasks.begin(), tasks.end(), [](const ScheduledTask& left, const ScheduledTask& right) {
+        return left.cost > right.cost;
+    });
+
+    for (auto& task : tasks) {
+        if (token.cancelled()) {
+            token.skip(task.name);
+            continue;
+        }
+        auto reservation = budget.admit(task.cost);
+        const auto key = task.key;
+        pool.submitTo(completions, key, [task = std::move(task), reservation = std::move(reservation), &budget, &token]() mutable {
+            token.run(task.name, task.run);
+            budget.handOver(task.key, std::move(reservation));
+        });
+    }
+}
+
+TaskGroup::TaskGroup(gesa::concurrency::ThreadPool& pool, JobBudget& budget, gesa::concurrency::CancellationToken& token,
+                     gesa::concurrency::CompletionQueue& completions, Load load)
+    : pool_(pool), budget_(budget), token_(token), completions_(completions), load_(std::move(load))
+{
+}
+
+void TaskGroup::add(ScheduledTask task)
+{
+    if (token_.cancelled()) {
+        token_.skip(task.name);
+        return;
+    }
+
+    // The pending group's own reservations can only be returned once it is queued.
+    auto reservation = budget_.tryAdmit(task.cost);
+    if (!reservation) {
+        flush();
+        reservation = budget_.admit(task.cost);
+    }
+    reservations_.push_back(std::move(*reservation));
+
+    pendingCost_ += task.cost;
+    pending_.push_back(std::move(task));
+    if (pending_.size() >= kTaskGroupSize || pendingCost_ >= kTaskGroupBytes) {
+        flush();
+    }
+}
+
+void TaskGroup::flush()
+{
+    if (pending_.empty()) {
+        return;
+    }
+
+    // Each member hands its reservation over and is reported as soon as it is done.
+    auto group = std::move(pending_);
+    auto reservations = std::move(reservations_);
+    pending_.clear();
+    reservations_.clear();
+    pendingCost_ = 0;
+    completions_.expect(group.size());
+    std::vector<std::size_t> keys;
+    keys.reserve(group.size());
+    for (const auto& task : group) {
+        keys.push_back(task.key);
+    }
+    try {
+        pool_.post([group = std::move(group), reservations = std::move(reservations), &budget = budget_, &token = token_,
+                    &completions = completions_, load = load_]() mutable {
+            std::exception_ptr loadError;
+            if (load && !token.cancelled()) {
+                try {
+                    load(group);
+                } catch (...) {
+                    loadError = std::current_exception();
+                }
+            }
+            for (std::size_t index = 0; index < group.size(); ++index) {
+                token.run(group[index].name, [&]() {
+                    if (loadError) {
+                        std::rethrow_exception(loadError);
+                    }
+                    group[index].run();
+                });
+                budget.handOver(group[index].key, std::move(reservations[index]));
+                completions.complete(group[index].key);
+            }
+        });
+    } catch (...) {
+        for (const auto key : keys) {
+            completions_.complete(key, std::current_exception());
+        }
+    }
+}
+
+} // namespace gesa::compression
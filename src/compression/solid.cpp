@@ -0,0 +1,61 @@
+#include "compression/solid.hpp"
+
+#include <stdexcept>
+
+namespace gesa::compression {
+
+std::vector<SolidBlockPlan> planSolidBlocks(const std::vector<gesa::filesystem::FileDescriptor>& descriptors,
+                                            const std::vector<std::size_t>& duplicateSources,
+                                            const DirectoryOptions& options,
+                                            const std::vector<bool>& excluded)
+{
+    std::vector<SolidBlockPlan> blocks;
+    if (!options.solid) {
+        return blocks;
+    }
+
+    SolidBlockPlan current {};
+    for (std::size_t index = 0; index < descriptors.size(); ++index) {
+        const auto& descriptor = descriptors[index];
+        if (index < excluded.size() && excluded[index]) {
+            continue;
+        }
+        if (duplicateSources[index] != index || descriptor.size == 0U || descriptor.size > options.solidFileThreshold) {
+            continue;
+        }
+
+        if (!current.members.empty() && current.size + descriptor.size > options.solidBlockSize) {
+            blocks.emplace_back(std::move(current));
+            current = SolidBlockPlan {};
+        }
+
+        current.members.push_back(index);
+        current.offsets.push_back(current.size);
+        current.size += descriptor.size;
+    }
+
+    if (!current.members.empty()) {
+        blocks.emplace_back(std::move(current));
+    }
+    return blocks;
+}
+
+std::vector<std::uint8_t> readSolidBlock(const SolidBlockPlan& plan,
+                                         const std::vector<gesa::filesystem::FileDescriptor>& descriptors)
+{
+    std::vector<std::uint8_t> block(static_cast<std::size_t>(plan.size));
+
+    for (std::size_t member = 0; member < plan.members.size(); ++member) {
+        const auto& descriptor = descriptors[plan.members[member]];
+        const gesa::filesystem::FileContext context(descriptor.absolutePath);
+        const auto length = static_cast<std::size_t>(descriptor.size);
+        if (context.descriptor().size != descriptor.size
+            || context.readInto(0, block.data() + plan.offsets[member], length) != length) {
+            throw std::runtime_error("File changed while building solid block: " + descriptor.absolutePath.string());
+        }
+    }
+
+    return block;
+}
+
+} // namespace gesa::compression
@@ -0,0 +1,138 @@
+#include "compression/stream.hpp"
+
+#include "compression/archive_types.hpp"
+#include "compression/huffman/codec.hpp"
+#include "compression/huffman/types.hpp"
+#include "compression/lzw/codec.hpp"
+#include "compression/lzw/types.hpp"
+#include "utils/binary_io.hpp"
+
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace gesa::compression {
+
+namespace {
+
+// Frame payload: codec id, original size, then the codec's own fields. Frames that
+// would not shrink are stored verbatim.
+constexpr std::size_t kFramePrefixSize = sizeof(std::uint8_t) + sizeof(std::uint32_t);
+// A coded frame that would reach the size of a stored one is stored instead.
+constexpr std::size_t kMaxFrameSize = kFramePrefixSize + gesa::utils::kStreamChunkSize;
+
+void writeFramePrefix(gesa::utils::BinaryWriter& writer, CodecId codec, std::size_t originalSize)
+{
+    writer.write(static_cast<std::uint8_t>(codec));
+    writer.write(static_cast<std::uint32_t>(originalSize));
+}
+
+std::vector<std::uint8_t> storedFrame(gesa::utils::ByteView chunk)
+{
+    gesa::utils::BinaryWriter writer;
+    writeFramePrefix(writer, CodecId::Stored, chunk.size);
+    writer.writeBytes(chunk.data, chunk.size);
+    return writer.release();
+}
+
+std::vector<std::uint8_t> encodeHuffmanFrame(gesa::utils::ByteView chunk)
+{
+    const auto result = huffman::encodeBuffer(chunk);
+    gesa::utils::BinaryWriter writer;
+    writeFramePrefix(writer, CodecId::Huffman, chunk.size);
+    for (const auto frequency : result.metadata.frequencies) {
+        writer.write(frequency);
+    }
+    writer.writeBytes(result.compressed.data(), result.compressed.size());
+    if (writer.size() >= kFramePrefixSize + chunk.size) {
+        return storedFrame(chunk);
+    }
+    return writer.release();
+}
+
+std::vector<std::uint8_t> encodeLzwFrame(gesa::utils::ByteView chunk)
+{
+    const auto result = lzw::encodeBuffer(chunk);
+    gesa::utils::BinaryWriter writer;
+    writeFramePrefix(writer, CodecId::LZW, chunk.size);
+    writer.write(result.metadata.dictionarySize);
+    for (const auto code : result.codes) {
+        writer.write(code);
+    }
+    if (writer.size() >= kFramePrefixSize + chunk.size) {
+        return storedFrame(chunk);
+    }
+    return writer.release();
+}
+
+std::vector<std::uint8_t> decodeFrame(gesa::utils::ByteView frame, CodecId expected)
+{
+    gesa::utils::ByteReader reader(frame.data, frame.size);
+    const auto codec = static_cast<CodecId>(reader.read<std::uint8_t>());
+    const auto originalSize = reader.read<std::uint32_t>();
+
+    std::vector<std::uint8_t> output;
+    if (codec == CodecId::Stored) {
+        output.resize(reader.remaining());
+        reader.readBytes(output.data(), output.size());
+    } else if (codec != expected) {
+        throw std::runtime_error("Unexpected codec in stream frame");
+    } else if (codec == CodecId::Huffman) {
+        huffman::HuffmanMetadata metadata {};
+        metadata.originalSize = originalSize;
+        for (auto& frequency : metadata.frequencies) {
+            frequency = reader.read<std::uint32_t>();
+        }
+        std::vector<std::uint8_t> compressed(reader.remaining());
+        reader.readBytes(compressed.data(), compressed.size());
+        output = huffman::decodeBuffer(metadata, compressed);
+    } else {
+        lzw::LZWMetadata metadata {};
+        metadata.originalSize = originalSize;
+        metadata.dictionarySize = reader.read<std::uint16_t>();
+        if (reader.remaining() % sizeof(std::uint16_t) != 0U) {
+            throw std::runtime_error("Invalid LZW stream frame size");
+        }
+        std::vector<std::uint16_t> codes(reader.remaining() / sizeof(std::uint16_t));
+        for (auto& code : codes) {
+            code = reader.read<std::uint16_t>();
+        }
+        output = lzw::decodeBuffer(metadata, codes);
+    }
+
+    if (output.size() != originalSize) {
+        throw std::runtime_error("Stream frame size mismatch");
+    }
+    return output;
+}
+
+} // namespace
+
+std::unique_ptr<gesa::utils::ByteSink> makeCompressingSink(StreamCodec codec, gesa::utils::ByteSink& output,
+                                                           std::size_t chunkSize)
+{
+    switch (codec) {
+    case StreamCodec::Huffman:
+        return std::make_unique<gesa::utils::FrameEncoder>(huffman::kStreamMagic, encodeHuffmanFrame, output, chunkSize);
+    case StreamCodec::LZW:
+        return std::make_unique<gesa::utils::FrameEncoder>(lzw::kStreamMagic, encodeLzwFrame, output, chunkSize);
+    }
+    throw std::invalid_argument("Unsupported stream codec");
+}
+
+std::unique_ptr<gesa::utils::ByteSink> makeDecompressingSink(StreamCodec codec, gesa::utils::ByteSink& output)
+{
+    switch (codec) {
+    case StreamCodec::Huffman:
+        return std::make_unique<gesa::utils::FrameDecoder>(
+            huffman::kStreamMagic, [](gesa::utils::ByteView frame) { return decodeFrame(frame, CodecId::Huffman); }, output,
+            kMaxFrameSize);
+    case StreamCodec::LZW:
+        return std::make_unique<gesa::utils::FrameDecoder>(
+            lzw::kStreamMagic, [](gesa::utils::ByteView frame) { return decodeFrame(frame, CodecId::LZW); }, output,
+            kMaxFrameSize);
+    }
+    throw std::invalid_argument("Unsupported stream codec");
+}
+
+} // namespace gesa::compression
@@ -0,0 +1,107 @@
+#include "compression/update.hpp"
+
+#include <unordered_map>
+
+namespace gesa::compression {
+
+std::vector<bool> ReusePlan::reusedMask() const
+{
+    std::vector<bool> mask(previous.size(), false);
+    for (std::size_t index = 0; index < previous.size(); ++index) {
+        mask[index] = reused(index);
+    }
+    return mask;
+}
+
+ReusePlan planReuse(const std::vector<gesa::filesystem::FileDescriptor>& descriptors,
+                    const std::vector<PreviousEntry>& previous, std::size_t previousBlockCount,
+                    bool reuseSolidBlocks)
+{
+    ReusePlan plan {};
+    plan.previous.assign(descriptors.size(), ReusePlan::kNotReused);
+    plan.reference.assign(descriptors.size(), 0U);
+    if (previous.empty()) {
+        return plan;
+    }
+
+    std::unordered_map<std::string, std::size_t> byPath;
+    for (std::size_t position = 0; position < previous.size(); ++position) {
+        byPath.emplace(previous[position].relativePath, position);
+    }
+
+    // Unchanged files, and for every previous entry the file that matched it.
+    std::vector<std::size_t> matched(descriptors.size(), ReusePlan::kNotReused);
+    std::vector<std::size_t> current(previous.size(), ReusePlan::kNotReused);
+    for (std::size_t index = 0; index < descriptors.size(); ++index) {
+        const auto& descriptor = descriptors[index];
+        const auto found = byPath.find(descriptor.relativePath.generic_string());
+        if (found == byPath.end()) {
+            continue;
+        }
+        const auto& entry = previous[found->second];
+        if (entry.originalSize == descriptor.size && entry.lastWriteTime == toArchiveTime(descriptor.lastWriteTime)) {
+            matched[index] = found->second;
+            current[found->second] = index;
+        }
+    }
+
+    for (std::size_t index = 0; index < descriptors.size(); ++index) {
+        if (matched[index] != ReusePlan::kNotReused && previous[matched[index]].kind == EntryKind::Payload) {
+            plan.previous[index] = matched[index];
+        }
+    }
+
+    if (reuseSolidBlocks) {
+        std::vector<bool> intact(previousBlockCount, true);
+        std::vector<bool> populated(previousBlockCount, false);
+        for (std::size_t position = 0; position < previous.size(); ++position) {
+            const auto& entry = previous[position];
+            if (entry.kind != EntryKind::Solid || entry.reference >= previousBlockCount) {
+                continue;
+            }
+            populated[entry.reference] = true;
+            if (current[position] == ReusePlan::kNotReused) {
+                intact[entry.reference] = false;
+            }
+        }
+
+        std::vector<std::size_t> carried(previousBlockCount, ReusePlan::kNotReused);
+        for (std::size_t block = 0; block < previousBlockCount; ++block) {
+            if (populated[block] && intact[block]) {
+                carried[block] = plan.blocks.size();
+                plan.blocks.push_back(block);
+            }
+        }
+        for (std::size_t index = 0; index < descriptors.size(); ++index) {
+            if (matched[index] == ReusePlan::kNotReused || previous[matched[index]].kind != EntryKind::Solid) {
+                continue;
+            }
+            const auto block = previous[matched[index]].reference;
+            if (block < previousBlockCount && carried[block] != ReusePlan::kNotReused) {
+                plan.previous[index] = matched[index];
+                plan.reference[index] = carried[block];
+            }
+        }
+    }
+
+    // A duplicate must still point backwards; descriptors keep the previous path order,
+    // so this only rules out archives written in some other order.
+    for (std::size_t index = 0; index < descriptors.size(); ++index) {
+        if (matched[index] == ReusePlan::kNotReused || previous[matched[index]].kind != EntryKind::Duplicate) {
+            continue;
+        }
+        const auto sourcePosition = previous[matched[index]].reference;
+        if (sourcePosition >= previous.size()) {
+            continue;
+        }
+        const auto source = current[sourcePosition];
+        if (source != ReusePlan::kNotReused && source < index && plan.reused(source)) {
+            plan.previous[index] = matched[index];
+            plan.reference[index] = source;
+        }
+    }
+
+    return plan;
+}
+
+} // namespace gesa::compression
@@ -0,0 +1,51 @@
+#include "concurrency/async.hpp"
+
+#include <algorithm>
+
+namespace gesa::concurrency {
+
+Stage::Stage(ThreadPool& pool, std::size_t limit)
+    : pool_(pool), limit_(std::max<std::size_t>(limit, 1))
+{
+}
+
+Stage::~Stage()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this]() { return running_ == 0U; });
+}
+
+void Stage::schedule(Task job)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_ >= limit_) {
+            waiting_.push_back(std::move(job));
+            return;
+        }
+        ++running_;
+    }
+
+    try {
+        pool_.post([this, job = std::move(job)]() mutable {
+            while (true) {
+                job();
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (waiting_.empty()) {
+                    --running_;
+                    idle_.notify_all();
+                    return;
+                }
+                job = std::move(waiting_.front());
+                waiting_.pop_front();
+            }
+        });
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --running_;
+        idle_.notify_all();
+        throw;
+    }
+}
+
+} // namespace gesa::concurrency
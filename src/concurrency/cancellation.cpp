@@ -0,0 +1,91 @@
+#include "concurrency/cancellation.hpp"
+
+#include <algorithm>
+
+namespace gesa::concurrency {
+
+namespace {
+
+constexpr std::size_t kListedSkips = 5;
+
+std::string describe(const std::exception_ptr& error)
+{
+    try {
+        std::rethrow_exception(error);
+    } catch (const std::exception& ex) {
+        return ex.what();
+    } catch (...) {
+        return "unknown error";
+    }
+}
+
+std::string summarize(const std::string& job, const std::exception_ptr& cause, const std::vector<std::string>& skipped)
+{
+    auto message = (job.empty() ? std::string() : job + ": ") + describe(cause);
+    if (skipped.empty()) {
+        return message;
+    }
+    message += " (" + std::to_string(skipped.size()) + " skipped: ";
+    for (std::size_t index = 0; index < std::min(skipped.size(), kListedSkips); ++index) {
+        message += (index == 0 ? "" : ", ") + skipped[index];
+    }
+    if (skipped.size() > kListedSkips) {
+        message += ", ...";
+    }
+    return message + ")";
+}
+
+} // namespace
+
+OperationCancelled::OperationCancelled()
+    : std::runtime_error("Operation cancelled")
+{
+}
+
+BatchFailure::BatchFailure(std::string job, std::exception_ptr cause, std::vector<std::string> skipped)
+    : std::runtime_error(summarize(job, cause, skipped))
+    , job_(std::move(job))
+    , cause_(std::move(cause))
+    , skipped_(std::move(skipped))
+{
+}
+
+void CancellationToken::throwIfCancelled() const
+{
+    if (cancelled()) {
+        throw OperationCancelled();
+    }
+}
+
+void CancellationToken::fail(const std::string& job, std::exception_ptr error)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!error_) {
+            failedJob_ = job;
+            error_ = std::move(error);
+        }
+    }
+    cancel();
+}
+
+void CancellationToken::skip(const std::string& job)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    skipped_.push_back(job);
+}
+
+void CancellationToken::rethrowIfFailed() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (error_) {
+        auto skipped = skipped_;
+        std::sort(skipped.begin(), skipped.end());
+        throw BatchFailure(failedJob_, error_, std::move(skipped));
+    }
+    if (cancelled()) {
+        throw OperationCancelled();
+    }
+}
+
+} // namespace gesa::concurrency
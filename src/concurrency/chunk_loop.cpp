@@ -0,0 +1,56 @@
+#include "concurrency/chunk_loop.hpp"
+
+#include <algorithm>
+
+namespace gesa::concurrency {
+
+ChunkLoop::ChunkLoop(std::size_t begin, std::size_t end, std::size_t grain, Body body, void* context)
+    : begin_(begin),
+      end_(std::max(begin, end)),
+      grain_(std::max<std::size_t>(grain, 1)),
+      chunkCount_((end_ - begin_ + grain_ - 1U) / grain_),
+      body_(body),
+      context_(context),
+      remaining_(chunkCount_)
+{
+}
+
+void ChunkLoop::work() noexcept
+{
+    while (true) {
+        const auto chunk = next_.fetch_add(1);
+        if (chunk >= chunkCount_) {
+            return;
+        }
+
+        if (!failed_.load()) {
+            const auto first = begin_ + chunk * grain_;
+            const auto last = std::min(end_, first + grain_);
+            try {
+                body_(context_, first, last);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!error_) {
+                    error_ = std::current_exception();
+                }
+                failed_.store(true);
+            }
+        }
+
+        if (remaining_.fetch_sub(1) == 1U) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            done_.notify_all();
+        }
+    }
+}
+
+void ChunkLoop::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this]() { return remaining_.load() == 0U; });
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+}
+
+} // namespace gesa::concurrency
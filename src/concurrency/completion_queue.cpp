@@ -0,0 +1,65 @@
+#include "concurrency/completion_queue.hpp"
+
+#include <utility>
+
+namespace gesa::concurrency {
+
+CompletionQueue::~CompletionQueue()
+{
+    wait();
+}
+
+void CompletionQueue::expect(std::size_t count)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ += count;
+    undelivered_ += count;
+}
+
+void CompletionQueue::complete(std::size_t key, std::exception_ptr error)
+{
+    // Notified under the lock: once running_ drops to zero the queue may be destroyed.
+    std::lock_guard<std::mutex> lock(mutex_);
+    finished_.push_back(Completion {key, std::move(error)});
+    --running_;
+    ready_.notify_all();
+}
+
+std::optional<Completion> CompletionQueue::tryNext()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (finished_.empty()) {
+        return std::nullopt;
+    }
+    auto completion = std::move(finished_.front());
+    finished_.pop_front();
+    --undelivered_;
+    return completion;
+}
+
+std::optional<Completion> CompletionQueue::next()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    ready_.wait(lock, [this]() { return !finished_.empty() || undelivered_ == 0U; });
+    if (finished_.empty()) {
+        return std::nullopt;
+    }
+    auto completion = std::move(finished_.front());
+    finished_.pop_front();
+    --undelivered_;
+    return completion;
+}
+
+void CompletionQueue::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    ready_.wait(lock, [this]() { return running_ == 0U; });
+}
+
+std::size_t CompletionQueue::outstanding() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return undelivered_;
+}
+
+} // namespace gesa::concurrency
@@ -0,0 +1,213 @@
+#include "concurrency/memory_budget.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include <unistd.h>
+
+namespace gesa::concurrency {
+
+namespace {
+
+struct SharedBudgetState {
+    std::mutex mutex;
+    std::optional<std::uint64_t> configured;
+    std::unique_ptr<MemoryBudget> budget;
+};
+
+SharedBudgetState& sharedBudgetState()
+{
+    static SharedBudgetState state;
+    return state;
+}
+
+std::uint64_t defaultLimit()
+{
+    const long pages = ::sysconf(_SC_PHYS_PAGES);
+    const long pageSize = ::sysconf(_SC_PAGESIZE);
+    if (pages <= 0 || pageSize <= 0) {
+        return 0;
+    }
+    return static_cast<std::uint64_t>(pages) * static_cast<std::uint64_t>(pageSize) / 2U;
+}
+
+std::uint64_t resolveLimit(const std::optional<std::uint64_t>& configured)
+{
+    if (configured) {
+        return *configured;
+    }
+    if (const char* value = std::getenv(kMemoryLimitVariable); value != nullptr && *value != '\0') {
+        try {
+            return parseByteSize(value);
+        } catch (const std::invalid_argument&) {
+        }
+    }
+    return defaultLimit();
+}
+
+} // namespace
+
+MemoryReservation::MemoryReservation(MemoryBudget* budget, std::uint64_t bytes) noexcept
+    : budget_(budget), bytes_(bytes)
+{
+}
+
+MemoryReservation::~MemoryReservation()
+{
+    release();
+}
+
+MemoryReservation::MemoryReservation(MemoryReservation&& other) noexcept
+    : budget_(std::exchange(other.budget_, nullptr)), bytes_(std::exchange(other.bytes_, 0))
+{
+}
+
+MemoryReservation& MemoryReservation::operator=(MemoryReservation&& other) noexcept
+{
+    if (this != &other) {
+        release();
+        budget_ = std::exchange(other.budget_, nullptr);
+        bytes_ = std::exchange(other.bytes_, 0);
+    }
+    return *this;
+}
+
+void MemoryReservation::merge(MemoryReservation&& other)
+{
+    if (other.budget_ == nullptr) {
+        return;
+    }
+    if (budget_ != nullptr && budget_ != other.budget_) {
+        throw std::invalid_argument("Cannot merge reservations of different memory budgets");
+    }
+    budget_ = std::exchange(other.budget_, nullptr);
+    bytes_ += std::exchange(other.bytes_, 0);
+}
+
+void MemoryReservation::shrinkTo(std::uint64_t bytes) noexcept
+{
+    if (budget_ != nullptr && bytes < bytes_) {
+        budget_->release(bytes_ - bytes);
+        bytes_ = bytes;
+    }
+}
+
+void MemoryReservation::release() noexcept
+{
+    if (budget_ != nullptr) {
+        budget_->release(bytes_);
+    }
+    budget_ = nullptr;
+    bytes_ = 0;
+}
+
+MemoryBudget::MemoryBudget(std::uint64_t capacity)
+    : capacity_(capacity)
+{
+}
+
+std::uint64_t MemoryBudget::inUse() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return used_;
+}
+
+std::uint64_t MemoryBudget::clamp(std::uint64_t bytes) const noexcept
+{
+    return capacity_ == 0U ? bytes : std::min(bytes, capacity_);
+}
+
+MemoryReservation MemoryBudget::reserve(std::uint64_t bytes)
+{
+    bytes = clamp(bytes);
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (capacity_ != 0U) {
+        released_.wait(lock, [this, bytes]() { return used_ + bytes <= capacity_; });
+    }
+    used_ += bytes;
+    return MemoryReservation(this, bytes);
+}
+
+std::optional<MemoryReservation> MemoryBudget::tryReserve(std::uint64_t bytes)
+{
+    bytes = clamp(bytes);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (capacity_ != 0U && used_ + bytes > capacity_) {
+        return std::nullopt;
+    }
+    used_ += bytes;
+    return MemoryReservation(this, bytes);
+}
+
+void MemoryBudget::release(std::uint64_t bytes) noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        used_ -= bytes;
+    }
+    released_.notify_all();
+}
+
+std::uint64_t parseByteSize(const std::string& text)
+{
+    std::size_t consumed = 0;
+    std::uint64_t value = 0;
+    try {
+        value = std::stoull(text, &consumed);
+    } catch (const std::exception&) {
+        throw std::invalid_argument("Invalid byte size: " + text);
+    }
+    if (!text.empty() && text[0] == '-') {
+        throw std::invalid_argument("Invalid byte size: " + text);
+    }
+
+    auto suffix = text.substr(consumed);
+    if (suffix.size() == 2U && std::toupper(static_cast<unsigned char>(suffix[1])) == 'B') {
+        suffix.pop_back();
+    }
+    if (suffix.empty()) {
+        return value;
+    }
+    if (suffix.size() != 1U) {
+        throw std::invalid_argument("Invalid byte size: " + text);
+    }
+
+    unsigned shift = 0;
+    switch (std::toupper(static_cast<unsigned char>(suffix[0]))) {
+    case 'K': shift = 10; break;
+    case 'M': shift = 20; break;
+    case 'G': shift = 30; break;
+    case 'T': shift = 40; break;
+    default: throw std::invalid_argument("Invalid byte size: " + text);
+    }
+    if (value > (UINT64_MAX >> shift)) {
+        throw std::invalid_argument("Byte size out of range: " + text);
+    }
+    return value << shift;
+}
+
+void configureMemoryLimit(std::uint64_t bytes)
+{
+    auto& state = sharedBudgetState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (state.budget && state.budget->capacity() != bytes) {
+        throw std::logic_error("Shared memory budget is already in use with a different limit");
+    }
+    state.configured = bytes;
+}
+
+MemoryBudget& sharedMemoryBudget()
+{
+    auto& state = sharedBudgetState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (!state.budget) {
+        state.budget = std::make_unique<MemoryBudget>(resolveLimit(state.configured));
+    }
+    return *state.budget;
+}
+
+} // namespace gesa::concurrency
@@ -0,0 +1,184 @@
+#include "concurrency/pool_statistics.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <numeric>
+
+namespace gesa::concurrency {
+
+namespace {
+
+void bump(std::atomic<std::uint64_t>& counter, std::uint64_t amount) noexcept
+{
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+double toMicroseconds(double nanos)
+{
+    return nanos / 1000.0;
+}
+
+double toMilliseconds(std::chrono::nanoseconds nanos)
+{
+    return static_cast<double>(nanos.count()) / 1e6;
+}
+
+void printLatency(std::ostream& output, const char* label, const Histogram& histogram)
+{
+    output << label << "mean " << toMicroseconds(histogram.mean())
+           << " us, p50 <= " << toMicroseconds(static_cast<double>(histogram.quantile(0.5)))
+           << " us, p99 <= " << toMicroseconds(static_cast<double>(histogram.quantile(0.99))) << " us\n";
+}
+
+} // namespace
+
+std::size_t Histogram::bucketOf(std::uint64_t value) noexcept
+{
+    std::size_t bucket = 0;
+    while (value != 0U && bucket + 1U < kBuckets) {
+        value >>= 1U;
+        ++bucket;
+    }
+    return bucket;
+}
+
+std::uint64_t Histogram::upperBound(std::size_t bucket) noexcept
+{
+    return bucket == 0U ? 0U : (std::uint64_t {1} << bucket) - 1U;
+}
+
+void Histogram::add(std::size_t bucket, std::uint64_t count, std::uint64_t sum) noexcept
+{
+    buckets_[std::min(bucket, kBuckets - 1U)] += count;
+    sum_ += sum;
+}
+
+void Histogram::merge(const Histogram& other) noexcept
+{
+    for (std::size_t bucket = 0; bucket < kBuckets; ++bucket) {
+        buckets_[bucket] += other.buckets_[bucket];
+    }
+    sum_ += other.sum_;
+}
+
+std::uint64_t Histogram::count() const noexcept
+{
+    return std::accumulate(buckets_.begin(), buckets_.end(), std::uint64_t {0});
+}
+
+double Histogram::mean() const noexcept
+{
+    const auto total = count();
+    return total == 0U ? 0.0 : static_cast<double>(sum_) / static_cast<double>(total);
+}
+
+std::uint64_t Histogram::quantile(double q) const noexcept
+{
+    const auto total = count();
+    if (total == 0U) {
+        return 0;
+    }
+    const auto rank = static_cast<std::uint64_t>(std::clamp(q, 0.0, 1.0) * static_cast<double>(total - 1U)) + 1U;
+    std::uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < kBuckets; ++bucket) {
+        seen += buckets_[bucket];
+        if (seen >= rank) {
+            return upperBound(bucket);
+        }
+    }
+    return upperBound(kBuckets - 1U);
+}
+
+double WorkerStatistics::utilization() const noexcept
+{
+    const auto total = busy + idle;
+    return total.count() == 0 ? 0.0 : static_cast<double>(busy.count()) / static_cast<double>(total.count());
+}
+
+std::uint64_t PoolStatistics::tasks() const noexcept
+{
+    std::uint64_t total = 0;
+    for (const auto& worker : workers) {
+        total += worker.tasks;
+    }
+    return total;
+}
+
+double PoolStatistics::utilization() const noexcept
+{
+    std::chrono::nanoseconds busy {0};
+    for (const auto& worker : workers) {
+        busy += worker.busy;
+    }
+    const auto capacity = uptime.count() * static_cast<std::int64_t>(workers.size());
+    return capacity == 0 ? 0.0 : std::min(1.0, static_cast<double>(busy.count()) / static_cast<double>(capacity));
+}
+
+void printStatistics(std::ostream& output, const PoolStatistics& statistics)
+{
+    const auto flags = output.flags();
+    const auto precision = output.precision();
+    output << std::fixed << std::setprecision(1);
+
+    output << "Pool workers       : " << statistics.workers.size() << " (" << 100.0 * statistics.utilization()
+           << "% busy over " << toMilliseconds(statistics.uptime) << " ms)\n"
+           << "Pool tasks         : " << statistics.tasks() << "\n";
+    printLatency(output, "Queue wait         : ", statistics.queueWait);
+    printLatency(output, "Run time           : ", statistics.runTime);
+    output << "Queue depth        : mean " << statistics.queueDepth.mean() << ", p99 <= "
+           << statistics.queueDepth.quantile(0.99) << "\n";
+
+    output << std::setw(8) << "worker" << std::setw(10) << "tasks" << std::setw(12) << "busy ms" << std::setw(12)
+           << "idle ms" << std::setw(8) << "busy" << "\n";
+    for (std::size_t index = 0; index < statistics.workers.size(); ++index) {
+        const auto& worker = statistics.workers[index];
+        output << std::setw(8) << index << std::setw(10) << worker.tasks << std::setw(12) << toMilliseconds(worker.busy)
+               << std::setw(12) << toMilliseconds(worker.idle) << std::setw(7) << 100.0 * worker.utilization() << "%\n";
+    }
+
+    output.flags(flags);
+    output.precision(precision);
+}
+
+namespace detail {
+
+void WorkerCounters::Series::add(std::uint64_t value) noexcept
+{
+    bump(buckets[Histogram::bucketOf(value)], 1);
+    bump(sum, value);
+}
+
+void WorkerCounters::Series::mergeInto(Histogram& histogram) const noexcept
+{
+    for (std::size_t bucket = 0; bucket < Histogram::kBuckets; ++bucket) {
+        histogram.add(bucket, buckets[bucket].load(std::memory_order_relaxed), 0);
+    }
+    histogram.add(0, 0, sum.load(std::memory_order_relaxed));
+}
+
+void WorkerCounters::record(std::uint64_t waitNanos, std::uint64_t runNanos, std::uint64_t depth) noexcept
+{
+    wait_.add(waitNanos);
+    run_.add(runNanos);
+    depth_.add(depth);
+}
+
+void WorkerCounters::collect(PoolStatistics& statistics) const
+{
+    Histogram runTime;
+    run_.mergeInto(runTime);
+
+    WorkerStatistics worker;
+    worker.tasks = runTime.count();
+    worker.busy = std::min(statistics.uptime, std::chrono::nanoseconds(static_cast<std::int64_t>(runTime.sum())));
+    worker.idle = statistics.uptime - worker.busy;
+    statistics.workers.push_back(worker);
+
+    statistics.runTime.merge(runTime);
+    wait_.mergeInto(statistics.queueWait);
+    depth_.mergeInto(statistics.queueDepth);
+}
+
+} // namespace detail
+
+} // namespace gesa::concurrency
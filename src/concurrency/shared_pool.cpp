@@ -0,0 +1,119 @@
+#include "concurrency/shared_pool.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace gesa::concurrency {
+
+namespace {
+
+struct SharedPoolState {
+    std::mutex mutex;
+    std::size_t configured {0};
+    std::optional<Placement> placement;
+    std::unique_ptr<ThreadPool> pool;
+};
+
+SharedPoolState& sharedState()
+{
+    static SharedPoolState state;
+    return state;
+}
+
+std::size_t environmentThreadCount()
+{
+    const char* value = std::getenv(kThreadCountVariable);
+    if (value == nullptr || *value == '\0') {
+        return 0;
+    }
+    try {
+        std::size_t consumed = 0;
+        const auto count = std::stoul(value, &consumed);
+        return consumed == std::char_traits<char>::length(value) ? count : 0U;
+    } catch (const std::exception&) {
+        return 0;
+    }
+}
+
+std::size_t resolveSize(std::size_t configured)
+{
+    if (configured > 0U) {
+        return configured;
+    }
+    if (const auto fromEnvironment = environmentThreadCount(); fromEnvironment > 0U) {
+        return fromEnvironment;
+    }
+    return std::max<std::size_t>(1, std::thread::hardware_concurrency());
+}
+
+Placement resolvePlacement(const std::optional<Placement>& configured)
+{
+    if (configured) {
+        return *configured;
+    }
+    const char* value = std::getenv(kAffinityVariable);
+    if (value == nullptr || *value == '\0') {
+        return Placement::None;
+    }
+    try {
+        return parsePlacement(value);
+    } catch (const std::invalid_argument&) {
+        return Placement::None;
+    }
+}
+
+} // namespace
+
+void configureSharedPool(std::size_t threadCount)
+{
+    auto& state = sharedState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (state.pool && state.pool->size() != resolveSize(threadCount)) {
+        throw std::logic_error("Shared thread pool is already running with " + std::to_string(state.pool->size()) + " threads");
+    }
+    state.configured = threadCount;
+}
+
+void configureSharedPlacement(Placement placement)
+{
+    auto& state = sharedState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (state.pool && state.pool->placement() != placement) {
+        throw std::logic_error("Shared thread pool is already running with a different placement");
+    }
+    state.placement = placement;
+}
+
+std::size_t sharedPoolSize()
+{
+    auto& state = sharedState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.pool ? state.pool->size() : resolveSize(state.configured);
+}
+
+ThreadPool& sharedPool()
+{
+    auto& state = sharedState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (!state.pool) {
+        state.pool = std::make_unique<ThreadPool>(resolveSize(state.configured), resolvePlacement(state.placement));
+    }
+    return *state.pool;
+}
+
+PoolLease::PoolLease(std::size_t threadCount)
+{
+    if (threadCount == 0) {
+        pool_ = &sharedPool();
+    } else {
+        owned_ = std::make_unique<ThreadPool>(threadCount);
+        pool_ = owned_.get();
+    }
+}
+
+} // namespace gesa::concurrency
@@ -1,19 +1,57 @@
 #include "concurrency/thread_pool.hpp"
 
 #include <algorithm>
+#include <exception>
+#include <memory>
 #include <stdexcept>
 
 namespace gesa::concurrency {
 
-ThreadPool::ThreadPool(std::size_t threadCount)
+namespace {
+
+struct WorkerIdentity {
+    const ThreadPool* pool {nullptr};
+    std::size_t index {0};
+};
+
+thread_local WorkerIdentity currentWorker;
+
+std::uint64_t nextRandom(std::uint64_t& state) noexcept
+{
+    state ^= state << 13U;
+    state ^= state >> 7U;
+    state ^= state << 17U;
+    return state;
+}
+
+std::uint64_t elapsedNanos(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) noexcept
+{
+    const auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count();
+    return nanos > 0 ? static_cast<std::uint64_t>(nanos) : 0U;
+}
+
+} // namespace
+
+ThreadPool::ThreadPool(std::size_t threadCount, Placement placement)
+    : placement_(placement)
 {
     if (threadCount == 0) {
         threadCount = std::max<std::size_t>(1, std::thread::hardware_concurrency());
     }
 
+    const auto slots = planPlacement(systemTopology(), threadCount, placement);
+    nodeAware_ = placement != Placement::None && systemTopology().nodes.size() > 1U;
+
+    queues_.reserve(threadCount);
+    for (std::size_t i = 0; i < threadCount; ++i) {
+        queues_.push_back(std::make_unique<Worker>());
+        queues_.back()->seed = 0x9E3779B97F4A7C15ULL * (i + 1U);
+        queues_.back()->slot = slots[i];
+    }
+
     workers_.reserve(threadCount);
     for (std::size_t i = 0; i < threadCount; ++i) {
-        workers_.emplace_back([this]() { workerLoop(); });
+        workers_.emplace_back([this, i]() { workerLoop(i); });
     }
 }
 
@@ -21,7 +59,7 @@ ThreadPool::~ThreadPool()
 {
     {
         std::lock_guard<std::mutex> lock(mutex_);
-        stop_ = true;
+        stop_.store(true);
     }
 
     cv_.notify_all();
@@ -38,24 +76,200 @@ std::size_t ThreadPool::size() const noexcept
     return workers_.size();
 }
 
-void ThreadPool::workerLoop()
+PoolStatistics ThreadPool::statistics() const
 {
-    while (true) {
-        Task task;
+    PoolStatistics statistics;
+    statistics.uptime = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - startedAt_);
+    statistics.workers.reserve(queues_.size());
+    for (const auto& queue : queues_) {
+        queue->counters.collect(statistics);
+    }
+    return statistics;
+}
 
-        {
-            std::unique_lock<std::mutex> lock(mutex_);
-            cv_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+void ThreadPool::submit(Task task)
+{
+    if (stop_.load()) {
+        throw std::runtime_error("ThreadPool is stopped");
+    }
+
+    // Counted before it becomes visible so a worker that takes it never sees zero.
+    auto* node = task.release();
+    node->queuedAt = Clock::now();
+    pending_.fetch_add(1);
+    try {
+        if (currentWorker.pool == this) {
+            queues_[currentWorker.index]->deque.push(node);
+        } else {
+            std::lock_guard<std::mutex> lock(injectMutex_);
+            injected_.push_back(node);
+        }
+    } catch (...) {
+        pending_.fetch_sub(1);
+        node->discard();
+        throw;
+    }
+
+    // Pairs with the sleepers_ increment in workerLoop: either the sleeper sees the new
+    // task in its wait predicate or this thread sees the sleeper and wakes it.
+    if (sleepers_.load() > 0U) {
+        { std::lock_guard<std::mutex> lock(mutex_); }
+        cv_.notify_one();
+    }
+}
+
+void ThreadPool::submitAll(std::vector<Task> tasks)
+{
+    if (tasks.empty()) {
+        return;
+    }
+    if (stop_.load()) {
+        throw std::runtime_error("ThreadPool is stopped");
+    }
+
+    const auto queuedAt = Clock::now();
+    for (auto& task : tasks) {
+        task.get()->queuedAt = queuedAt;
+    }
 
-            if (stop_ && tasks_.empty()) {
-                return;
+    pending_.fetch_add(tasks.size());
+    std::size_t pushed = 0;
+    try {
+        if (currentWorker.pool == this) {
+            auto& deque = queues_[currentWorker.index]->deque;
+            for (; pushed < tasks.size(); ++pushed) {
+                deque.push(tasks[pushed].get());
+                tasks[pushed].release();
             }
+        } else {
+            std::lock_guard<std::mutex> lock(injectMutex_);
+            for (; pushed < tasks.size(); ++pushed) {
+                injected_.push_back(tasks[pushed].get());
+                tasks[pushed].release();
+            }
+        }
+    } catch (...) {
+        pending_.fetch_sub(tasks.size() - pushed);
+        throw;
+    }
+
+    if (sleepers_.load() > 0U) {
+        { std::lock_guard<std::mutex> lock(mutex_); }
+        cv_.notify_all();
+    }
+}
+
+void ThreadPool::runChunks(std::size_t begin, std::size_t end, std::size_t grain, ChunkLoop::Body body, void* context)
+{
+    if (end <= begin) {
+        return;
+    }
+    if (grain == 0) {
+        const auto targetChunks = 4U * (size() + 1U);
+        grain = std::max<std::size_t>(1, (end - begin + targetChunks - 1U) / targetChunks);
+    }
+
+    auto loop = std::make_shared<ChunkLoop>(begin, end, grain, body, context);
+    const auto helpers = std::min(loop->chunkCount() - 1U, size());
+
+    std::exception_ptr submitError;
+    try {
+        std::vector<Task> tasks;
+        tasks.reserve(helpers);
+        for (std::size_t helper = 0; helper < helpers; ++helper) {
+            tasks.emplace_back([loop]() { loop->work(); });
+        }
+        submitAll(std::move(tasks));
+    } catch (...) {
+        // Helpers that did get queued may still claim chunks, so finish the loop first.
+        submitError = std::current_exception();
+    }
+
+    loop->work();
+    loop->wait();
+    if (submitError) {
+        std::rethrow_exception(submitError);
+    }
+}
+
+ThreadPool::TaskNode* ThreadPool::findTask(std::size_t index)
+{
+    if (auto* task = queues_[index]->deque.pop()) {
+        return task;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(injectMutex_);
+        if (!injected_.empty()) {
+            auto* task = injected_.front();
+            injected_.pop_front();
+            return task;
+        }
+    }
+
+    return stealTask(index);
+}
+
+ThreadPool::TaskNode* ThreadPool::stealTask(std::size_t index)
+{
+    if (queues_.size() < 2U) {
+        return nullptr;
+    }
+    if (nodeAware_) {
+        if (auto* task = stealFrom(index, true)) {
+            return task;
+        }
+    }
+    return stealFrom(index, false);
+}
+
+// With sameNode set only victims on the thief's node are tried; otherwise, on a
+// node-aware pool, only victims on other nodes.
+ThreadPool::TaskNode* ThreadPool::stealFrom(std::size_t index, bool sameNode)
+{
+    const auto count = queues_.size();
+    const auto node = queues_[index]->slot.node;
+    const auto start = static_cast<std::size_t>(nextRandom(queues_[index]->seed) % count);
+    for (std::size_t offset = 0; offset < count; ++offset) {
+        const auto victim = (start + offset) % count;
+        if (victim == index || (nodeAware_ && (queues_[victim]->slot.node == node) != sameNode)) {
+            continue;
+        }
+        if (auto* task = queues_[victim]->deque.steal()) {
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+void ThreadPool::workerLoop(std::size_t index)
+{
+    currentWorker = WorkerIdentity {this, index};
+    if (queues_[index]->slot.cpu >= 0) {
+        pinCurrentThread(queues_[index]->slot.cpu);
+    }
+
+    while (true) {
+        if (auto* task = findTask(index)) {
+            const auto depth = pending_.fetch_sub(1) - 1U;
+            const auto queuedAt = task->queuedAt;
+            const auto started = Clock::now();
+            task->run();
+            const auto finished = Clock::now();
+            queues_[index]->counters.record(elapsedNanos(queuedAt, started), elapsedNanos(started, finished), depth);
+            continue;
+        }
 
-            task = std::move(tasks_.front());
-            tasks_.pop();
+        sleepers_.fetch_add(1);
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() { return stop_.load() || pending_.load() > 0U; });
         }
+        sleepers_.fetch_sub(1);
 
-        task();
+        if (stop_.load() && pending_.load() == 0U) {
+            return;
+        }
     }
 }
 
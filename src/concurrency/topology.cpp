@@ -0,0 +1,207 @@
+#include "concurrency/topology.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace gesa::concurrency {
+
+namespace {
+
+std::vector<unsigned> allowedCpus()
+{
+    std::vector<unsigned> cpus;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (::sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (unsigned cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#endif
+    if (cpus.empty()) {
+        const auto count = std::max(1U, std::thread::hardware_concurrency());
+        for (unsigned cpu = 0; cpu < count; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+bool parseNodeId(const std::string& name, std::size_t& id)
+{
+    if (name.size() <= 4U || name.compare(0, 4, "node") != 0) {
+        return false;
+    }
+    const auto digits = name.substr(4);
+    if (!std::all_of(digits.begin(), digits.end(), [](unsigned char c) { return std::isdigit(c) != 0; })) {
+        return false;
+    }
+    id = static_cast<std::size_t>(std::stoul(digits));
+    return true;
+}
+
+} // namespace
+
+std::size_t CpuTopology::cpuCount() const noexcept
+{
+    std::size_t count = 0;
+    for (const auto& node : nodes) {
+        count += node.cpus.size();
+    }
+    return count;
+}
+
+std::vector<unsigned> parseCpuList(const std::string& text)
+{
+    std::vector<unsigned> cpus;
+    std::stringstream stream(text);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        range.erase(std::remove_if(range.begin(), range.end(), [](unsigned char c) { return std::isspace(c) != 0; }),
+                    range.end());
+        if (range.empty()) {
+            continue;
+        }
+        try {
+            const auto dash = range.find('-');
+            const auto first = static_cast<unsigned>(std::stoul(range.substr(0, dash)));
+            const auto last = dash == std::string::npos ? first : static_cast<unsigned>(std::stoul(range.substr(dash + 1U)));
+            if (last < first) {
+                throw std::invalid_argument(range);
+            }
+            for (auto cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        } catch (const std::exception&) {
+            throw std::invalid_argument("Invalid CPU list: " + text);
+        }
+    }
+    return cpus;
+}
+
+CpuTopology readTopology(const std::filesystem::path& nodeRoot, const std::vector<unsigned>& allowedCpus)
+{
+    const auto allowed = [&allowedCpus](unsigned cpu) {
+        return allowedCpus.empty() || std::find(allowedCpus.begin(), allowedCpus.end(), cpu) != allowedCpus.end();
+    };
+
+    CpuTopology topology;
+    std::error_code error;
+    for (std::filesystem::directory_iterator it(nodeRoot, error), end; !error && it != end; it.increment(error)) {
+        NumaNode node;
+        if (!parseNodeId(it->path().filename().string(), node.id)) {
+            continue;
+        }
+        std::ifstream input(it->path() / "cpulist");
+        const std::string text((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+        if (!input && text.empty()) {
+            continue;
+        }
+        for (const auto cpu : parseCpuList(text)) {
+            if (allowed(cpu)) {
+                node.cpus.push_back(cpu);
+            }
+        }
+        if (!node.cpus.empty()) {
+            topology.nodes.push_back(std::move(node));
+        }
+    }
+
+    std::sort(topology.nodes.begin(), topology.nodes.end(),
+              [](const NumaNode& left, const NumaNode& right) { return left.id < right.id; });
+    if (topology.nodes.empty()) {
+        topology.nodes.push_back(NumaNode {0, allowedCpus});
+    }
+    return topology;
+}
+
+const CpuTopology& systemTopology()
+{
+    static const CpuTopology topology = []() {
+        try {
+            return readTopology(kSysfsNodeRoot, allowedCpus());
+        } catch (const std::exception&) {
+            return CpuTopology {{NumaNode {0, allowedCpus()}}};
+        }
+    }();
+    return topology;
+}
+
+Placement parsePlacement(const std::string& name)
+{
+    if (name == "none") {
+        return Placement::None;
+    }
+    if (name == "compact") {
+        return Placement::Compact;
+    }
+    if (name == "scatter") {
+        return Placement::Scatter;
+    }
+    throw std::invalid_argument("Unknown placement: " + name + " (expected none, compact or scatter)");
+}
+
+std::vector<WorkerSlot> planPlacement(const CpuTopology& topology, std::size_t workerCount, Placement placement)
+{
+    std::vector<WorkerSlot> slots(workerCount);
+    if (placement == Placement::None || topology.cpuCount() == 0U) {
+        return slots;
+    }
+
+    if (placement == Placement::Compact) {
+        std::vector<WorkerSlot> order;
+        for (std::size_t node = 0; node < topology.nodes.size(); ++node) {
+            for (const auto cpu : topology.nodes[node].cpus) {
+                order.push_back(WorkerSlot {static_cast<int>(cpu), node});
+            }
+        }
+        for (std::size_t worker = 0; worker < workerCount; ++worker) {
+            slots[worker] = order[worker % order.size()];
+        }
+        return slots;
+    }
+
+    std::vector<std::size_t> used(topology.nodes.size(), 0);
+    std::size_t node = 0;
+    for (auto& slot : slots) {
+        while (topology.nodes[node].cpus.empty()) {
+            node = (node + 1U) % topology.nodes.size();
+        }
+        const auto& cpus = topology.nodes[node].cpus;
+        slot = WorkerSlot {static_cast<int>(cpus[used[node]++ % cpus.size()]), node};
+        node = (node + 1U) % topology.nodes.size();
+    }
+    return slots;
+}
+
+bool pinCurrentThread(int cpu) noexcept
+{
+#ifdef __linux__
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+} // namespace gesa::concurrency
@@ -1,10 +1,10 @@
 #include "RSA.h"
+#include "concurrency/shared_pool.hpp"
 #include <numeric>
 #include <chrono>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
-#ifdef _OPENMP
-#include <omp.h>
-#endif
 
 Rsa::Rsa(int p, int q) : p(p), q(q), publicKey(nullptr), privateKey(nullptr)
 {
@@ -28,6 +28,63 @@ Rsa::~Rsa()
     freeKeys();
 }
 
+const std::array<uint32_t, 256> &Rsa::encryptionTable(int e, int n)
+{
+    /**
+     * Function to get the encryption table for a public key, building it on first use
+     *
+     * @param e: The public exponent
+     * @param n: The modulus
+     *
+     * @return: The 4 ciphertext bytes of every plaintext byte, packed as they are stored
+     */
+    if (tableE == e && tableN == n)
+    {
+        return encryptTable;
+    }
+
+    for (int byte = 0; byte < 256; byte++)
+    {
+        int encrypted = Utils::powerModulus(byte, e, n);
+        if (encrypted >= n)
+        {
+            throw std::runtime_error(" Error: Encrypted value exceeds modulus n");
+        }
+        const uint8_t word[4] = {static_cast<uint8_t>(encrypted >> 24), static_cast<uint8_t>(encrypted >> 16),
+                                 static_cast<uint8_t>(encrypted >> 8), static_cast<uint8_t>(encrypted & 0xFF)};
+        std::memcpy(&encryptTable[byte], word, sizeof(word));
+    }
+    tableE = e;
+    tableN = n;
+    return encryptTable;
+}
+
+const std::vector<uint16_t> &Rsa::decryptionTable(int d, int n)
+{
+    /**
+     * Function to get the decryption table for a private key, building it on first use
+     *
+     * @param d: The private exponent
+     * @param n: The modulus, at most kRsaDecryptTableLimit
+     *
+     * @return: The decrypted value of every ciphertext word below n
+     */
+    if (tableD == d && tableDN == n)
+    {
+        return decryptTable;
+    }
+
+    decryptTable.resize(static_cast<size_t>(n));
+    auto &pool = gesa::concurrency::sharedPool();
+    pool.parallelFor(0, decryptTable.size(), 0, [&](size_t word)
+    {
+        decryptTable[word] = static_cast<uint16_t>(Utils::powerModulus(static_cast<int>(word), d, n));
+    });
+    tableD = d;
+    tableDN = n;
+    return decryptTable;
+}
+
 ResultGenerateKeys Rsa::generateKeys()
 {
     /**
@@ -92,32 +149,16 @@ std::vector<uint8_t> Rsa::encrypt(const std::vector<uint8_t> &data, const std::s
     auto start = std::chrono::high_resolution_clock::now();
     std::vector<uint8_t> encryptedValues(data.size() * 4); // Pre-allocate the vector
 
-#ifdef _OPENMP
-    omp_set_num_threads(omp_get_max_threads());
-#pragma omp parallel for
-#endif
-    for (size_t i = 0; i < data.size(); i++)
+    // Only 256 plaintexts exist per key, so each byte is one table load and one 4-byte store
+    const auto &table = encryptionTable(e, n);
+    auto &pool = gesa::concurrency::sharedPool();
+    fprintf(stderr, "\033[1;36m [Thread pool (RSA)] Threads used for encryption: %zu\033[0m\n", pool.size());
+    pool.parallelFor(0, data.size(), 0, [&](size_t i)
     {
-#ifdef _OPENMP
-        if (i == 0)
-        {
-            printf("\033[1;36m [OpenMP (RSA)] Threads used for encryption: %d\033[0m\n", omp_get_num_threads());
-        }
-#endif
-        uint8_t byte = data[i];
-        int encrypted = Utils::powerModulus(static_cast<int>(byte), e, n);
-        if (encrypted >= n)
-        {
-            throw std::runtime_error(" Error: Encrypted value exceeds modulus n");
-        }
-        size_t baseIndex = i * 4;
-        encryptedValues[baseIndex] = static_cast<uint8_t>(encrypted >> 24);
-        encryptedValues[baseIndex + 1] = static_cast<uint8_t>(encrypted >> 16);
-        encryptedValues[baseIndex + 2] = static_cast<uint8_t>(encrypted >> 8);
-        encryptedValues[baseIndex + 3] = static_cast<uint8_t>(encrypted & 0xFF);
-    }
+        std::memcpy(encryptedValues.data() + i * 4, &table[data[i]], sizeof(uint32_t));
+    });
     auto end = std::chrono::high_resolution_clock::now();
-    printf("\033[1;32m [Timing] Encryption time: %lld ms\033[0m\n", std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
+    fprintf(stderr, "\033[1;32m [Timing] Encryption time: %lld ms\033[0m\n", std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
     return encryptedValues;
 }
 
@@ -152,33 +193,29 @@ std::vector<uint8_t> Rsa::decrypt(const std::vector<uint8_t> &data, const std::s
     auto start = std::chrono::high_resolution_clock::now();
     std::vector<uint8_t> decryptedValues(data.size() / 4); // Pre-allocate the vector
 
-#ifdef _OPENMP
-    omp_set_num_threads(omp_get_max_threads());
-#pragma omp parallel for
-#endif
-    for (size_t i = 0; i < data.size(); i += 4)
+    // Small moduli have few enough ciphertext words to decrypt each of them once per key
+    const std::vector<uint16_t> *table = n > 0 && n <= kRsaDecryptTableLimit ? &decryptionTable(d, n) : nullptr;
+    auto &pool = gesa::concurrency::sharedPool();
+    fprintf(stderr, "\033[1;36m [Thread pool (RSA)] Threads used for decryption: %zu\033[0m\n", pool.size());
+    pool.parallelFor(0, decryptedValues.size(), 0, [&](size_t block)
     {
-#ifdef _OPENMP
-        if (i == 0)
-        {
-            printf("\033[1;36m [OpenMP (RSA)] Threads used for decryption: %d\033[0m\n", omp_get_num_threads());
-        }
-#endif
+        size_t i = block * 4;
         int encrypted = (static_cast<int>(data[i]) << 24) |
                         (static_cast<int>(data[i + 1]) << 16) |
                         (static_cast<int>(data[i + 2]) << 8) |
                         static_cast<int>(data[i + 3]);
-        int decrypted = Utils::powerModulus(encrypted, d, n);
+        int decrypted = table != nullptr && encrypted >= 0 && encrypted < n ? (*table)[encrypted]
+                                                                             : Utils::powerModulus(encrypted, d, n);
         if (decrypted > 255)
         {
             std::cerr << "⚠️  Warning: Decrypted value " << decrypted << " exceeds uint8_t range for n=" << n << "\n"
                       << std::endl;
             decrypted = decrypted % 256;
         }
-        decryptedValues[i / 4] = static_cast<uint8_t>(decrypted);
-    }
+        decryptedValues[block] = static_cast<uint8_t>(decrypted);
+    });
     auto end = std::chrono::high_resolution_clock::now();
-    printf("\033[1;32m [Timing] Decryption time: %lld ms\033[0m\n", std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
+    fprintf(stderr, "\033[1;32m [Timing] Decryption time: %lld ms\033[0m\n", std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
     return decryptedValues;
 }
 
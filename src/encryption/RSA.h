@@ -12,6 +12,7 @@
 #include <stdexcept>
 #include <cstdint>
 #include <numeric>
+#include <array>
 
 
 using std::__gcd;
@@ -19,6 +20,9 @@ using std::cout;
 using std::endl;
 using std::vector;
 
+// Moduli up to this size get a full ciphertext-to-plaintext table on decryption.
+constexpr int kRsaDecryptTableLimit = 1 << 16;
+
 struct ResultGenerateKeys {
     char* publicKey;
     char* privateKey;
@@ -30,6 +34,17 @@ private:
     int q;
     char* publicKey;  // Public key in String format
     char* privateKey;  // Private key in String format
+
+    // Per-key lookup tables, rebuilt only when a different key is used
+    int tableE = 0;
+    int tableN = 0;
+    std::array<uint32_t, 256> encryptTable {};  // Big-endian ciphertext word per byte, as stored
+    int tableD = 0;
+    int tableDN = 0;
+    std::vector<uint16_t> decryptTable;  // Plaintext per ciphertext word below n
+
+    const std::array<uint32_t, 256>& encryptionTable(int e, int n);
+    const std::vector<uint16_t>& decryptionTable(int d, int n);
 public:
     Rsa(int p, int q);
     ~Rsa();
@@ -0,0 +1,568 @@
+#include "filesystem/batch_io.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <initializer_list>
+#include <limits>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if GESA_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
+
+namespace gesa::filesystem {
+
+namespace {
+
+constexpr mode_t kCreateMode = 0666;
+
+void createParentDirectories(const std::vector<WriteRequest>& requests)
+{
+    std::set<std::filesystem::path> parents;
+    for (const auto& request : requests) {
+        auto parent = request.path.parent_path();
+        if (!parent.empty()) {
+            parents.insert(std::move(parent));
+        }
+    }
+
+    for (const auto& parent : parents) {
+        std::error_code ec;
+        std::filesystem::create_directories(parent, ec);
+        if (ec) {
+            throw std::filesystem::filesystem_error("create_directories", parent, ec);
+        }
+    }
+}
+
+std::system_error fileError(int error, const char* action, const std::filesystem::path& path)
+{
+    return std::system_error(error, std::generic_category(), std::string(action) + ": " + path.string());
+}
+
+std::vector<std::uint8_t> readWholeFile(const std::filesystem::path& path)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw fileError(errno, "Failed to open file for reading", path);
+    }
+
+    std::vector<std::uint8_t> buffer;
+    int error = 0;
+    struct stat status {};
+    if (::fstat(fd, &status) != 0) {
+        error = errno;
+    } else {
+        buffer.resize(static_cast<std::size_t>(status.st_size));
+        std::size_t total = 0;
+        while (total < buffer.size()) {
+            const auto count = ::pread(fd, buffer.data() + total, buffer.size() - total, static_cast<off_t>(total));
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count < 0) {
+                error = errno;
+                break;
+            }
+            if (count == 0) {
+                break;
+            }
+            total += static_cast<std::size_t>(count);
+        }
+        buffer.resize(total);
+    }
+
+    ::close(fd);
+    if (error != 0) {
+        throw fileError(error, "Failed to read file", path);
+    }
+    return buffer;
+}
+
+void writeWholeFile(const std::filesystem::path& path, gesa::utils::ByteView data)
+{
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, kCreateMode);
+    if (fd < 0) {
+        throw fileError(errno, "Failed to open file for writing", path);
+    }
+
+    int error = 0;
+    std::size_t total = 0;
+    while (total < data.size) {
+        const auto count = ::write(fd, data.data + total, data.size - total);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0) {
+            error = errno;
+            break;
+        }
+        total += static_cast<std::size_t>(count);
+    }
+
+    if (::close(fd) != 0 && error == 0) {
+        error = errno;
+    }
+    if (error != 0) {
+        throw fileError(error, "Failed to write file", path);
+    }
+}
+
+class BlockingBatchIo final : public BatchIo {
+public:
+    const char* name() const noexcept override { return "blocking"; }
+
+    std::vector<std::vector<std::uint8_t>> readFiles(const std::vector<ReadRequest>& requests) override
+    {
+        std::vector<std::vector<std::uint8_t>> contents;
+        contents.reserve(requests.size());
+        for (const auto& request : requests) {
+            contents.emplace_back(readWholeFile(request.path));
+        }
+        return contents;
+    }
+
+    void writeFiles(const std::vector<WriteRequest>& requests) override
+    {
+        createParentDirectories(requests);
+        for (const auto& request : requests) {
+            writeWholeFile(request.path, request.data);
+        }
+    }
+};
+
+#if GESA_HAVE_IO_URING
+
+constexpr unsigned kRingEntries = 256;
+
+class Ring {
+public:
+    explicit Ring(unsigned entries)
+    {
+        io_uring_params params {};
+        fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+        if (fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), "io_uring_setup");
+        }
+
+        sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool singleMapping = (params.features & IORING_FEAT_SINGLE_MMAP) != 0U;
+        if (singleMapping) {
+            sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+        }
+
+        sqRing_ = map(sqRingSize_, IORING_OFF_SQ_RING);
+        cqRing_ = singleMapping ? sqRing_ : map(cqRingSize_, IORING_OFF_CQ_RING);
+        sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(map(sqesSize_, IORING_OFF_SQES));
+
+        auto* sq = static_cast<char*>(sqRing_);
+        sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        capacity_ = params.sq_entries;
+
+        auto* cq = static_cast<char*>(cqRing_);
+        cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    }
+
+    Ring(const Ring&) = delete;
+    Ring& operator=(const Ring&) = delete;
+
+    ~Ring()
+    {
+        release();
+    }
+
+    unsigned capacity() const noexcept { return capacity_; }
+
+    void requireOperations(std::initializer_list<int> operations) const
+    {
+        std::vector<std::uint8_t> storage(sizeof(io_uring_probe) + 256U * sizeof(io_uring_probe_op));
+        auto* probe = reinterpret_cast<io_uring_probe*>(storage.data());
+        if (::syscall(__NR_io_uring_register, fd_, IORING_REGISTER_PROBE, probe, 256) < 0) {
+            throw std::system_error(errno, std::generic_category(), "io_uring probe");
+        }
+        for (const auto operation : operations) {
+            if (operation > probe->last_op || (probe->ops[operation].flags & IO_URING_OP_SUPPORTED) == 0U) {
+                throw std::system_error(ENOSYS, std::generic_category(), "io_uring operation unsupported");
+            }
+        }
+    }
+
+    io_uring_sqe& next()
+    {
+        const auto tail = *sqTail_ + queued_;
+        const auto slot = tail & sqMask_;
+        sqArray_[slot] = slot;
+        auto& sqe = sqes_[slot];
+        std::memset(&sqe, 0, sizeof(sqe));
+        ++queued_;
+        return sqe;
+    }
+
+    // Submits every queued entry and waits until the same number of completions were reaped.
+    template <class OnCompletion>
+    void submitAndWait(OnCompletion&& onCompletion)
+    {
+        const auto expected = queued_;
+        __atomic_store_n(sqTail_, *sqTail_ + queued_, __ATOMIC_RELEASE);
+
+        unsigned toSubmit = queued_;
+        queued_ = 0;
+        unsigned reaped = 0;
+        while (toSubmit > 0U || reaped < expected) {
+            const auto result = ::syscall(__NR_io_uring_enter, fd_, toSubmit, expected - reaped,
+                                          IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (result < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(), "io_uring_enter");
+            }
+            toSubmit -= static_cast<unsigned>(result);
+            reaped += reap(onCompletion);
+        }
+    }
+
+private:
+    void* map(std::size_t size, off_t offset)
+    {
+        void* mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, offset);
+        if (mapping == MAP_FAILED) {
+            const auto error = errno;
+            release();
+            throw std::system_error(error, std::generic_category(), "io_uring mmap");
+        }
+        return mapping;
+    }
+
+    template <class OnCompletion>
+    unsigned reap(OnCompletion& onCompletion)
+    {
+        unsigned head = *cqHead_;
+        const unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+        unsigned count = 0;
+        while (head != tail) {
+            const auto& cqe = cqes_[head & cqMask_];
+            onCompletion(static_cast<std::size_t>(cqe.user_data), cqe.res);
+            ++head;
+            ++count;
+        }
+        __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+        return count;
+    }
+
+    void release() noexcept
+    {
+        if (sqes_ != nullptr) {
+            ::munmap(sqes_, sqesSize_);
+            sqes_ = nullptr;
+        }
+        if (cqRing_ != nullptr && cqRing_ != sqRing_) {
+            ::munmap(cqRing_, cqRingSize_);
+        }
+        cqRing_ = nullptr;
+        if (sqRing_ != nullptr) {
+            ::munmap(sqRing_, sqRingSize_);
+            sqRing_ = nullptr;
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    int fd_ {-1};
+    void* sqRing_ {nullptr};
+    void* cqRing_ {nullptr};
+    io_uring_sqe* sqes_ {nullptr};
+    std::size_t sqRingSize_ {0};
+    std::size_t cqRingSize_ {0};
+    std::size_t sqesSize_ {0};
+    unsigned* sqTail_ {nullptr};
+    unsigned* sqArray_ {nullptr};
+    unsigned sqMask_ {0};
+    unsigned* cqHead_ {nullptr};
+    unsigned* cqTail_ {nullptr};
+    unsigned cqMask_ {0};
+    io_uring_cqe* cqes_ {nullptr};
+    unsigned capacity_ {0};
+    unsigned queued_ {0};
+};
+
+// Runs one operation per pending index through the ring; complete() returns true to resubmit.
+template <class Prepare, class Complete>
+void runPhase(Ring& ring, std::vector<std::size_t> pending, Prepare&& prepare, Complete&& complete)
+{
+    while (!pending.empty()) {
+        std::vector<std::size_t> retry;
+        for (std::size_t start = 0; start < pending.size(); start += ring.capacity()) {
+            const auto end = std::min<std::size_t>(pending.size(), start + ring.capacity());
+            for (std::size_t position = start; position < end; ++position) {
+                auto& sqe = ring.next();
+                prepare(sqe, pending[position]);
+                sqe.user_data = static_cast<__u64>(pending[position]);
+            }
+            ring.submitAndWait([&](std::size_t index, int result) {
+                if (complete(index, result)) {
+                    retry.push_back(index);
+                }
+            });
+        }
+        pending = std::move(retry);
+    }
+}
+
+// Closes whatever a batch still holds open when it unwinds early, e.g. because
+// io_uring_enter failed; the ring may be unusable by then, so it closes directly.
+class OpenFiles {
+public:
+    explicit OpenFiles(std::size_t count)
+        : fds_(count, -1)
+    {
+    }
+    OpenFiles(const OpenFiles&) = delete;
+    OpenFiles& operator=(const OpenFiles&) = delete;
+    ~OpenFiles()
+    {
+        for (const auto fd : fds_) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+    }
+
+    std::vector<int>& fds() noexcept { return fds_; }
+
+private:
+    std::vector<int> fds_;
+};
+
+unsigned chunkLength(std::size_t remaining)
+{
+    return static_cast<unsigned>(std::min<std::size_t>(remaining, std::numeric_limits<int>::max()));
+}
+
+class UringBatchIo final : public BatchIo {
+public:
+    UringBatchIo()
+        : ring_(kRingEntries)
+    {
+        ring_.requireOperations({IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_WRITE, IORING_OP_CLOSE});
+    }
+
+    const char* name() const noexcept override { return "io_uring"; }
+
+    std::vector<std::vector<std::uint8_t>> readFiles(const std::vector<ReadRequest>& requests) override
+    {
+        const auto count = requests.size();
+        std::vector<std::string> paths(count);
+        OpenFiles files(count);
+        auto& fds = files.fds();
+        std::vector<int> errors(count, 0);
+        std::vector<std::size_t> filled(count, 0);
+        std::vector<std::vector<std::uint8_t>> contents(count);
+        for (std::size_t index = 0; index < count; ++index) {
+            paths[index] = requests[index].path.string();
+            contents[index].resize(static_cast<std::size_t>(requests[index].sizeHint) + 1U);
+        }
+
+        openAll(paths, O_RDONLY | O_CLOEXEC, fds, errors);
+
+        runPhase(ring_, openedIndices(fds, errors),
+            [&](io_uring_sqe& sqe, std::size_t index) {
+                sqe.opcode = IORING_OP_READ;
+                sqe.fd = fds[index];
+                sqe.addr = reinterpret_cast<__u64>(contents[index].data() + filled[index]);
+                sqe.len = chunkLength(contents[index].size() - filled[index]);
+                sqe.off = filled[index];
+            },
+            [&](std::size_t index, int result) {
+                if (result == -EINTR || result == -EAGAIN) {
+                    return true;
+                }
+                if (result < 0) {
+                    errors[index] = -result;
+                    return false;
+                }
+                filled[index] += static_cast<std::size_t>(result);
+                return result > 0 && filled[index] < contents[index].size();
+            });
+
+        // Like the blocking backend, a failed close after a complete read is not an error.
+        closeAll(fds, nullptr);
+        throwFirstError(requests, errors, "Failed to read file");
+
+        for (std::size_t index = 0; index < count; ++index) {
+            if (filled[index] > requests[index].sizeHint) {
+                contents[index] = readWholeFile(requests[index].path);
+            } else {
+                contents[index].resize(filled[index]);
+            }
+        }
+        return contents;
+    }
+
+    void writeFiles(const std::vector<WriteRequest>& requests) override
+    {
+        createParentDirectories(requests);
+
+        const auto count = requests.size();
+        std::vector<std::string> paths(count);
+        OpenFiles files(count);
+        auto& fds = files.fds();
+        std::vector<int> errors(count, 0);
+        std::vector<std::size_t> written(count, 0);
+        for (std::size_t index = 0; index < count; ++index) {
+            paths[index] = requests[index].path.string();
+        }
+
+        openAll(paths, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, fds, errors);
+
+        std::vector<std::size_t> nonEmpty;
+        for (const auto index : openedIndices(fds, errors)) {
+            if (!requests[index].data.empty()) {
+                nonEmpty.push_back(index);
+            }
+        }
+
+        runPhase(ring_, std::move(nonEmpty),
+            [&](io_uring_sqe& sqe, std::size_t index) {
+                sqe.opcode = IORING_OP_WRITE;
+                sqe.fd = fds[index];
+                sqe.addr = reinterpret_cast<__u64>(requests[index].data.data + written[index]);
+                sqe.len = chunkLength(requests[index].data.size - written[index]);
+                sqe.off = written[index];
+            },
+            [&](std::size_t index, int result) {
+                if (result == -EINTR || result == -EAGAIN) {
+                    return true;
+                }
+                if (result <= 0) {
+                    errors[index] = result == 0 ? EIO : -result;
+                    return false;
+                }
+                written[index] += static_cast<std::size_t>(result);
+                return written[index] < requests[index].data.size;
+            });
+
+        // Delayed write-back errors surface at close, so they fail the write as well.
+        closeAll(fds, &errors);
+        throwFirstError(requests, errors, "Failed to write file");
+    }
+
+private:
+    void openAll(const std::vector<std::string>& paths, int flags, std::vector<int>& fds, std::vector<int>& errors)
+    {
+        std::vector<std::size_t> all(paths.size());
+        for (std::size_t index = 0; index < all.size(); ++index) {
+            all[index] = index;
+        }
+
+        runPhase(ring_, std::move(all),
+            [&](io_uring_sqe& sqe, std::size_t index) {
+                sqe.opcode = IORING_OP_OPENAT;
+                sqe.fd = AT_FDCWD;
+                sqe.addr = reinterpret_cast<__u64>(paths[index].c_str());
+                sqe.open_flags = static_cast<__u32>(flags);
+                sqe.len = kCreateMode;
+            },
+            [&](std::size_t index, int result) {
+                if (result == -EINTR || result == -EAGAIN) {
+                    return true;
+                }
+                if (result < 0) {
+                    errors[index] = -result;
+                } else {
+                    fds[index] = result;
+                }
+                return false;
+            });
+    }
+
+    // Records close failures in errors when given. A descriptor is given up as soon as
+    // its CLOSE is queued: should the ring fail, leaking it beats closing a number that
+    // another thread may have been handed in the meantime.
+    void closeAll(std::vector<int>& fds, std::vector<int>* errors)
+    {
+        std::vector<std::size_t> open;
+        for (std::size_t index = 0; index < fds.size(); ++index) {
+            if (fds[index] >= 0) {
+                open.push_back(index);
+            }
+        }
+
+        runPhase(ring_, std::move(open),
+            [&](io_uring_sqe& sqe, std::size_t index) {
+                sqe.opcode = IORING_OP_CLOSE;
+                sqe.fd = fds[index];
+                fds[index] = -1;
+            },
+            [&](std::size_t index, int result) {
+                if (result < 0 && errors != nullptr && (*errors)[index] == 0) {
+                    (*errors)[index] = -result;
+                }
+                return false;
+            });
+    }
+
+    static std::vector<std::size_t> openedIndices(const std::vector<int>& fds, const std::vector<int>& errors)
+    {
+        std::vector<std::size_t> opened;
+        for (std::size_t index = 0; index < fds.size(); ++index) {
+            if (fds[index] >= 0 && errors[index] == 0) {
+                opened.push_back(index);
+            }
+        }
+        return opened;
+    }
+
+    template <class Request>
+    static void throwFirstError(const std::vector<Request>& requests, const std::vector<int>& errors, const char* action)
+    {
+        for (std::size_t index = 0; index < errors.size(); ++index) {
+            if (errors[index] != 0) {
+                throw fileError(errors[index], action, requests[index].path);
+            }
+        }
+    }
+
+    Ring ring_;
+};
+
+#endif
+
+} // namespace
+
+std::unique_ptr<BatchIo> makeBlockingBatchIo()
+{
+    return std::make_unique<BlockingBatchIo>();
+}
+
+std::unique_ptr<BatchIo> makeBatchIo()
+{
+#if GESA_HAVE_IO_URING
+    try {
+        return std::make_unique<UringBatchIo>();
+    } catch (const std::system_error&) {
+    }
+#endif
+    return makeBlockingBatchIo();
+}
+
+} // namespace gesa::filesystem
@@ -0,0 +1,338 @@
+#include "filesystem/positional_file.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace gesa::filesystem {
+
+namespace {
+
+constexpr std::size_t kCopyBufferSize = 256U * 1024U;
+
+std::system_error fileError(int error, const char* action, const std::filesystem::path& path)
+{
+    return std::system_error(error, std::generic_category(), std::string(action) + ": " + path.string());
+}
+
+// The replaced file's permissions, or what creating it afresh would have given it.
+mode_t replacementMode(const std::filesystem::path& path)
+{
+    struct stat existing {};
+    if (::stat(path.c_str(), &existing) == 0) {
+        return existing.st_mode & 07777;
+    }
+
+    // /proc reports the umask without briefly changing it for every other thread.
+    mode_t mask = 022;
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("Umask:", 0) == 0) {
+            mask = static_cast<mode_t>(std::stoul(line.substr(6), nullptr, 8));
+            break;
+        }
+    }
+    return 0666 & ~mask;
+}
+
+// The file close() renames the temporary over: path itself when it is new, the file behind
+// any symlinks when it is a regular one. Anything else, such as a pipe or an in-memory
+// file named through /proc/self/fd, cannot be swapped by name and yields an empty path.
+std::filesystem::path replacementTarget(const std::filesystem::path& path)
+{
+    std::error_code error;
+    if (!std::filesystem::exists(path, error)) {
+        return error ? std::filesystem::path() : path;
+    }
+    auto target = std::filesystem::canonical(path, error);
+    if (error || !std::filesystem::is_regular_file(target, error)) {
+        return {};
+    }
+    return target;
+}
+
+int createTemporary(const std::filesystem::path& path, std::filesystem::path& temporary)
+{
+    const auto directory = path.has_parent_path() ? path.parent_path() : std::filesystem::path(".");
+    auto name = (directory / ("." + path.filename().string() + ".XXXXXX")).string();
+    const int fd = ::mkostemp(name.data(), O_CLOEXEC);
+    if (fd < 0) {
+        throw fileError(errno, "Failed to create a temporary file for", path);
+    }
+    temporary = name;
+    if (::fchmod(fd, replacementMode(path)) != 0) {
+        const int error = errno;
+        ::close(fd);
+        ::unlink(name.c_str());
+        throw fileError(error, "Failed to set permissions of", temporary);
+    }
+    return fd;
+}
+
+// O_TMPFILE where the filesystem has it, else a mkstemp file unlinked right away.
+int openUnnamed(const std::filesystem::path& directory)
+{
+#ifdef O_TMPFILE
+    const int fd = ::open(directory.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+    if (fd >= 0 || (errno != EOPNOTSUPP && errno != EISDIR && errno != EINVAL)) {
+        return fd;
+    }
+#endif
+    auto name = (directory / ".gsea-scratch.XXXXXX").string();
+    const int named = ::mkostemp(name.data(), O_CLOEXEC);
+    if (named >= 0) {
+        ::unlink(name.c_str());
+    }
+    return named;
+}
+
+int openScratch(const std::filesystem::path& directory, std::filesystem::path& path)
+{
+    path = directory.empty() ? std::filesystem::path(".") : directory;
+    int fd = openUnnamed(path);
+    if (fd < 0) {
+        path = std::filesystem::temp_directory_path();
+        fd = openUnnamed(path);
+    }
+    if (fd < 0) {
+        throw fileError(errno, "Failed to create a scratch file in", path);
+    }
+    return fd;
+}
+
+int allocateSpace(int fd, std::int64_t size)
+{
+#ifdef __linux__
+    return ::fallocate(fd, 0, 0, static_cast<off_t>(size));
+#else
+    (void)fd;
+    (void)size;
+    errno = EOPNOTSUPP;
+    return -1;
+#endif
+}
+
+#ifdef __linux__
+// Copies through copy_file_range and returns how many bytes it moved before the kernel
+// declined, e.g. across filesystems on older kernels or for special files.
+std::uint64_t copyInKernel(int from, std::uint64_t fromOffset, int to, std::uint64_t toOffset, std::uint64_t size,
+                           const std::filesystem::path& source, const std::filesystem::path& destination)
+{
+    std::uint64_t copied = 0;
+    while (copied < size) {
+        auto in = static_cast<off_t>(fromOffset + copied);
+        auto out = static_cast<off_t>(toOffset + copied);
+        const auto count = ::copy_file_range(from, &in, to, &out, static_cast<std::size_t>(size - copied), 0U);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0 && (errno == EXDEV || errno == ENOSYS || errno == EOPNOTSUPP || errno == EINVAL)) {
+            break;
+        }
+        if (count < 0) {
+            throw fileError(errno, "Failed to copy into", destination);
+        }
+        if (count == 0) {
+            throw std::runtime_error("Unexpected end of file while copying from: " + source.string());
+        }
+        copied += static_cast<std::uint64_t>(count);
+    }
+    return copied;
+}
+#endif
+
+} // namespace
+
+namespace detail {
+
+void reserveSpace(int fd, std::uint64_t size, const std::filesystem::path& path,
+                  int (*allocate)(int fd, std::int64_t size))
+{
+    if (size == 0U) {
+        return;
+    }
+
+    if (allocate(fd, static_cast<std::int64_t>(size)) == 0) {
+        return;
+    }
+    if (errno != EOPNOTSUPP && errno != ENOSYS) {
+        throw fileError(errno, "Failed to reserve space for", path);
+    }
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        throw fileError(errno, "Failed to size", path);
+    }
+}
+
+} // namespace detail
+
+SourceFile::SourceFile(std::filesystem::path path)
+    : path_(std::move(path))
+    , fd_(::open(path_.c_str(), O_RDONLY | O_CLOEXEC))
+{
+    if (fd_ < 0) {
+        throw fileError(errno, "Failed to open file for reading", path_);
+    }
+}
+
+SourceFile::SourceFile(std::filesystem::path path, int fd) noexcept
+    : path_(std::move(path)), fd_(fd)
+{
+}
+
+SourceFile::~SourceFile()
+{
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+std::vector<std::uint8_t> SourceFile::read(std::uint64_t offset, std::uint64_t size) const
+{
+    std::vector<std::uint8_t> bytes(static_cast<std::size_t>(size));
+    std::size_t done = 0;
+    while (done < bytes.size()) {
+        const auto count = ::pread(fd_, bytes.data() + done, bytes.size() - done, static_cast<off_t>(offset + done));
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0) {
+            throw fileError(errno, "Failed to read", path_);
+        }
+        if (count == 0) {
+            throw std::runtime_error("Unexpected end of file while reading: " + path_.string());
+        }
+        done += static_cast<std::size_t>(count);
+    }
+    return bytes;
+}
+
+ScratchFile::ScratchFile(const std::filesystem::path& directory)
+    : source_([&]() {
+        std::filesystem::path path;
+        const int fd = openScratch(directory, path);
+        return SourceFile(std::move(path), fd);
+    }())
+{
+}
+
+std::uint64_t ScratchFile::append(gesa::utils::ByteView data)
+{
+    const auto offset = size_;
+    std::size_t written = 0;
+    while (written < data.size) {
+        const auto count = ::pwrite(source_.fd_, data.data + written, data.size - written,
+                                    static_cast<off_t>(offset + written));
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0) {
+            throw fileError(errno, "Failed to write scratch file in", source_.path_);
+        }
+        written += static_cast<std::size_t>(count);
+    }
+    size_ += data.size;
+    return offset;
+}
+
+PositionalFile::PositionalFile(std::filesystem::path path, std::uint64_t size)
+    : path_(std::move(path))
+    , target_(replacementTarget(path_))
+{
+    if (target_.empty()) {
+        fd_ = ::open(path_.c_str(), O_WRONLY | O_TRUNC | O_CLOEXEC);
+        if (fd_ < 0) {
+            throw fileError(errno, "Failed to open file for writing", path_);
+        }
+    } else {
+        fd_ = createTemporary(target_, temporary_);
+    }
+
+    try {
+        detail::reserveSpace(fd_, size, path_, allocateSpace);
+    } catch (...) {
+        ::close(fd_);
+        if (!temporary_.empty()) {
+            ::unlink(temporary_.c_str());
+        }
+        throw;
+    }
+}
+
+PositionalFile::~PositionalFile()
+{
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+    if (!temporary_.empty() && !committed_) {
+        ::unlink(temporary_.c_str());
+    }
+}
+
+void PositionalFile::write(std::uint64_t offset, gesa::utils::ByteView data) const
+{
+    std::size_t written = 0;
+    while (written < data.size) {
+        const auto count = ::pwrite(fd_, data.data + written, data.size - written, static_cast<off_t>(offset + written));
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0) {
+            throw fileError(errno, "Failed to write", path_);
+        }
+        written += static_cast<std::size_t>(count);
+    }
+}
+
+void PositionalFile::copyFrom(std::uint64_t offset, const SourceFile& source, std::uint64_t sourceOffset,
+                              std::uint64_t size) const
+{
+    std::uint64_t copied = 0;
+#ifdef __linux__
+    copied = copyInKernel(source.fd_, sourceOffset, fd_, offset, size, source.path_, path_);
+#endif
+    if (copied == size) {
+        return;
+    }
+
+    std::vector<std::uint8_t> buffer(static_cast<std::size_t>(std::min<std::uint64_t>(size - copied, kCopyBufferSize)));
+    while (copied < size) {
+        const auto wanted = static_cast<std::size_t>(std::min<std::uint64_t>(size - copied, buffer.size()));
+        const auto count = ::pread(source.fd_, buffer.data(), wanted, static_cast<off_t>(sourceOffset + copied));
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0) {
+            throw fileError(errno, "Failed to read", source.path_);
+        }
+        if (count == 0) {
+            throw std::runtime_error("Unexpected end of file while copying from: " + source.path_.string());
+        }
+        write(offset + copied, gesa::utils::ByteView(buffer.data(), static_cast<std::size_t>(count)));
+        copied += static_cast<std::uint64_t>(count);
+    }
+}
+
+void PositionalFile::close()
+{
+    const int fd = fd_;
+    fd_ = -1;
+    if (fd >= 0 && ::close(fd) != 0) {
+        throw fileError(errno, "Failed to close", path_);
+    }
+    if (!temporary_.empty() && ::rename(temporary_.c_str(), target_.c_str()) != 0) {
+        throw fileError(errno, "Failed to replace", path_);
+    }
+    committed_ = true;
+}
+
+} // namespace gesa::filesystem
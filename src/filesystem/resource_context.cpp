@@ -1,11 +1,23 @@
 #include "filesystem/resource_context.hpp"
 
 #include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
 #include <fstream>
 #include <iterator>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <system_error>
 
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 namespace gesa::filesystem {
 
 namespace {
@@ -26,50 +38,255 @@ std::filesystem::path makeAbsolute(const std::filesystem::path& path)
     return path;
 }
 
-EntryType resolveType(const std::filesystem::directory_entry& entry)
+class ReadHandle {
+public:
+    explicit ReadHandle(const std::filesystem::path& path)
+        : fd_(::open(path.c_str(), O_RDONLY | O_CLOEXEC))
+    {
+        if (fd_ < 0) {
+            throw std::runtime_error("Failed to open file for reading: " + path.string());
+        }
+    }
+    ReadHandle(const ReadHandle&) = delete;
+    ReadHandle& operator=(const ReadHandle&) = delete;
+    ~ReadHandle()
+    {
+        ::close(fd_);
+    }
+
+    int get() const noexcept { return fd_; }
+
+private:
+    int fd_;
+};
+
+std::uintmax_t openFileSize(const ReadHandle& fd, const std::filesystem::path& path)
 {
-    std::error_code ec;
-    if (entry.is_directory(ec)) {
-        return EntryType::Directory;
+    struct stat status {};
+    if (::fstat(fd.get(), &status) != 0) {
+        throw std::runtime_error("Failed to determine file size: " + path.string());
     }
+    return static_cast<std::uintmax_t>(status.st_size);
+}
 
-    return EntryType::File;
+std::size_t preadFully(const ReadHandle& fd, const std::filesystem::path& path,
+                       std::uint8_t* buffer, std::size_t length, std::uintmax_t offset)
+{
+    std::size_t total = 0;
+    while (total < length) {
+        const auto count = ::pread(fd.get(), buffer + total, length - total, static_cast<off_t>(offset + total));
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "Failed to read file: " + path.string());
+        }
+        if (count == 0) {
+            break;
+        }
+        total += static_cast<std::size_t>(count);
+    }
+    return total;
 }
 
-EntryType resolveType(const std::filesystem::path& path)
+struct EntryStatus {
+    mode_t mode {0};
+    std::uint64_t size {0};
+    struct timespec lastWrite {};
+};
+
+// One metadata syscall per entry; statx lets us ask only for the fields we use.
+bool statEntry(int directoryFd, const char* name, bool followSymlinks, EntryStatus& status)
 {
-    std::error_code ec;
-    if (std::filesystem::is_directory(path, ec)) {
-        return EntryType::Directory;
+#ifdef STATX_TYPE
+    struct statx extended {};
+    const int flags = AT_NO_AUTOMOUNT | (followSymlinks ? 0 : AT_SYMLINK_NOFOLLOW);
+    if (::statx(directoryFd, name, flags, STATX_TYPE | STATX_SIZE | STATX_MTIME, &extended) == 0) {
+        status.mode = extended.stx_mode;
+        status.size = extended.stx_size;
+        status.lastWrite.tv_sec = static_cast<time_t>(extended.stx_mtime.tv_sec);
+        status.lastWrite.tv_nsec = static_cast<long>(extended.stx_mtime.tv_nsec);
+        return true;
     }
+    if (errno != ENOSYS) {
+        return false;
+    }
+#endif
+    struct stat basic {};
+    if (::fstatat(directoryFd, name, &basic, followSymlinks ? 0 : AT_SYMLINK_NOFOLLOW) != 0) {
+        return false;
+    }
+    status.mode = basic.st_mode;
+    status.size = static_cast<std::uint64_t>(basic.st_size);
+    status.lastWrite = basic.st_mtim;
+    return true;
+}
 
-    return EntryType::File;
+// file_time_type's epoch is implementation-defined in C++17, so the offset to the
+// POSIX epoch is measured once against a path whose timestamp is read both ways.
+std::filesystem::file_time_type::duration fileClockOffset()
+{
+    using Duration = std::filesystem::file_time_type::duration;
+    static const Duration offset = []() {
+        const std::filesystem::path reference("/");
+        for (;;) {
+            EntryStatus before {};
+            EntryStatus after {};
+            if (!statEntry(AT_FDCWD, reference.c_str(), true, before)) {
+                throw std::filesystem::filesystem_error("stat", reference, std::error_code(errno, std::generic_category()));
+            }
+            const auto fileTime = std::filesystem::last_write_time(reference);
+            if (!statEntry(AT_FDCWD, reference.c_str(), true, after)) {
+                throw std::filesystem::filesystem_error("stat", reference, std::error_code(errno, std::generic_category()));
+            }
+            if (before.lastWrite.tv_sec == after.lastWrite.tv_sec && before.lastWrite.tv_nsec == after.lastWrite.tv_nsec) {
+                const auto posix = std::chrono::duration_cast<Duration>(
+                    std::chrono::seconds(before.lastWrite.tv_sec) + std::chrono::nanoseconds(before.lastWrite.tv_nsec));
+                return fileTime.time_since_epoch() - posix;
+            }
+        }
+    }();
+    return offset;
 }
 
-std::filesystem::file_time_type safeLastWriteTime(const std::filesystem::path& path)
+std::filesystem::file_time_type toFileTime(const struct timespec& time)
 {
-    std::error_code ec;
-    const auto time = std::filesystem::last_write_time(path, ec);
-    if (ec) {
-        return std::filesystem::file_time_type {};
+    using Duration = std::filesystem::file_time_type::duration;
+    const auto posix = std::chrono::duration_cast<Duration>(std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec));
+    return std::filesystem::file_time_type(posix + fileClockOffset());
+}
+
+// Fills type, size and timestamp from at most two stats: the link itself, then its
+// target only when the entry is a symlink. Returns false for special files.
+bool describeEntry(int directoryFd, const char* name, FileDescriptor& descriptor, bool& isDirectory)
+{
+    EntryStatus status {};
+    if (!statEntry(directoryFd, name, false, status)) {
+        return false;
+    }
+
+    descriptor.isSymlink = S_ISLNK(status.mode);
+    if (descriptor.isSymlink && !statEntry(directoryFd, name, true, status)) {
+        descriptor.type = EntryType::File;
+        descriptor.size = 0;
+        descriptor.lastWriteTime = std::filesystem::file_time_type {};
+        isDirectory = false;
+        return true;
+    }
+
+    isDirectory = S_ISDIR(status.mode);
+    if (!isDirectory && !S_ISREG(status.mode)) {
+        return false;
     }
-    return time;
+    descriptor.type = isDirectory ? EntryType::Directory : EntryType::File;
+    descriptor.size = isDirectory ? 0U : static_cast<std::uintmax_t>(status.size);
+    descriptor.lastWriteTime = toFileTime(status.lastWrite);
+    return true;
 }
 
-std::uintmax_t safeFileSize(const std::filesystem::path& path)
+struct WalkState {
+    std::filesystem::path root;
+    bool recursive {true};
+    bool includeDirectories {true};
+    bool followSymlinks {false};
+    const DirectoryContext::EntryCallback* onEntry {nullptr};
+
+    std::mutex mutex;
+    std::condition_variable done;
+    std::size_t pending {0};
+    std::exception_ptr error;
+};
+
+void scanDirectory(gesa::concurrency::ThreadPool& pool, WalkState& state, const std::filesystem::path& relative);
+
+void scheduleDirectory(gesa::concurrency::ThreadPool& pool, WalkState& state, std::filesystem::path relative)
 {
-    std::error_code ec;
-    const auto size = std::filesystem::file_size(path, ec);
-    if (ec) {
-        return 0;
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (state.error) {
+            return;
+        }
+        ++state.pending;
     }
-    return size;
+
+    pool.post([&pool, &state, relative = std::move(relative)]() {
+        try {
+            scanDirectory(pool, state, relative);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if (!state.error) {
+                state.error = std::current_exception();
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (--state.pending == 0U) {
+            state.done.notify_all();
+        }
+    });
 }
 
-bool safeIsSymlink(const std::filesystem::path& path)
+void scanDirectory(gesa::concurrency::ThreadPool& pool, WalkState& state, const std::filesystem::path& relative)
 {
-    std::error_code ec;
-    return std::filesystem::is_symlink(path, ec);
+    const auto directoryPath = relative.empty() ? state.root : state.root / relative;
+    const int fd = ::open(directoryPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::filesystem::filesystem_error("open directory", directoryPath, std::error_code(errno, std::generic_category()));
+    }
+    std::unique_ptr<DIR, int (*)(DIR*)> directory(::fdopendir(fd), &::closedir);
+    if (!directory) {
+        const auto error = errno;
+        ::close(fd);
+        throw std::filesystem::filesystem_error("fdopendir", directoryPath, std::error_code(error, std::generic_category()));
+    }
+
+    const int directoryFd = ::dirfd(directory.get());
+    for (;;) {
+        errno = 0;
+        const auto* record = ::readdir(directory.get());
+        if (record == nullptr) {
+            if (errno != 0) {
+                throw std::filesystem::filesystem_error("readdir", directoryPath, std::error_code(errno, std::generic_category()));
+            }
+            break;
+        }
+
+        const std::string name(record->d_name);
+        if (name == "." || name == "..") {
+            continue;
+        }
+
+        const auto kind = record->d_type;
+        if (kind != DT_REG && kind != DT_DIR && kind != DT_LNK && kind != DT_UNKNOWN) {
+            continue;
+        }
+
+        // Directories that are neither reported nor symlinks need no metadata at all.
+        auto childRelative = relative / name;
+        if (kind == DT_DIR && !state.includeDirectories) {
+            if (state.recursive) {
+                scheduleDirectory(pool, state, std::move(childRelative));
+            }
+            continue;
+        }
+
+        FileDescriptor descriptor {};
+        bool isDirectory = false;
+        if (!describeEntry(directoryFd, name.c_str(), descriptor, isDirectory)) {
+            continue;
+        }
+
+        if (isDirectory && state.recursive && (!descriptor.isSymlink || state.followSymlinks)) {
+            scheduleDirectory(pool, state, childRelative);
+        }
+        if (isDirectory && !state.includeDirectories) {
+            continue;
+        }
+
+        descriptor.absolutePath = state.root / childRelative;
+        descriptor.relativePath = std::move(childRelative);
+        (*state.onEntry)(descriptor);
+    }
 }
 
 } // namespace
@@ -83,23 +300,78 @@ FileDescriptor describePath(const std::filesystem::path& path)
     const auto absolute = makeAbsolute(path);
 
     FileDescriptor descriptor {};
+    bool isDirectory = false;
+    if (!describeEntry(AT_FDCWD, path.c_str(), descriptor, isDirectory)) {
+        descriptor.type = EntryType::File;
+    }
     descriptor.absolutePath = absolute;
     descriptor.relativePath = absolute.filename();
-    descriptor.type = resolveType(path);
-    descriptor.isSymlink = safeIsSymlink(path);
-    descriptor.lastWriteTime = safeLastWriteTime(path);
 
-    if (descriptor.type == EntryType::Directory) {
-        descriptor.size = 0;
-    } else {
-        descriptor.size = safeFileSize(path);
+    return descriptor;
+}
+
+FileView::FileView(FileView&& other) noexcept
+    : mapping_(other.mapping_)
+    , mappingSize_(other.mappingSize_)
+    , buffer_(std::move(other.buffer_))
+{
+    other.mapping_ = nullptr;
+    other.mappingSize_ = 0;
+}
+
+FileView& FileView::operator=(FileView&& other) noexcept
+{
+    if (this != &other) {
+        release();
+        mapping_ = other.mapping_;
+        mappingSize_ = other.mappingSize_;
+        buffer_ = std::move(other.buffer_);
+        other.mapping_ = nullptr;
+        other.mappingSize_ = 0;
     }
+    return *this;
+}
 
-    return descriptor;
+FileView::~FileView()
+{
+    release();
+}
+
+void FileView::release() noexcept
+{
+    if (mapping_ != nullptr) {
+        ::munmap(mapping_, mappingSize_);
+        mapping_ = nullptr;
+        mappingSize_ = 0;
+    }
+    buffer_.clear();
+}
+
+gesa::utils::ByteView FileView::bytes() const noexcept
+{
+    if (mapping_ != nullptr) {
+        return gesa::utils::ByteView(static_cast<const std::uint8_t*>(mapping_), mappingSize_);
+    }
+    return gesa::utils::ByteView(buffer_.data(), buffer_.size());
+}
+
+std::size_t FileView::size() const noexcept
+{
+    return mapping_ != nullptr ? mappingSize_ : buffer_.size();
+}
+
+bool FileView::mapped() const noexcept
+{
+    return mapping_ != nullptr;
 }
 
 FileContext::FileContext(std::filesystem::path sourcePath)
-    : descriptor_(describePath(std::move(sourcePath)))
+    : FileContext(describePath(std::move(sourcePath)))
+{
+}
+
+FileContext::FileContext(FileDescriptor descriptor)
+    : descriptor_(std::move(descriptor))
 {
     if (descriptor_.type != EntryType::File) {
         throw std::invalid_argument("FileContext requires a regular file");
@@ -113,25 +385,12 @@ const FileDescriptor& FileContext::descriptor() const noexcept
 
 std::vector<std::uint8_t> FileContext::readAll() const
 {
-    std::ifstream input(descriptor_.absolutePath, std::ios::binary);
-    if (!input) {
-        throw std::runtime_error("Failed to open file for reading: " + descriptor_.absolutePath.string());
-    }
-
-    input.seekg(0, std::ios::end);
-    const auto endPosition = input.tellg();
-    if (endPosition < 0) {
-        throw std::runtime_error("Failed to determine file size: " + descriptor_.absolutePath.string());
-    }
-    const auto size = static_cast<std::size_t>(endPosition);
-    input.seekg(0, std::ios::beg);
+    const ReadHandle fd(descriptor_.absolutePath);
+    const auto size = static_cast<std::size_t>(openFileSize(fd, descriptor_.absolutePath));
 
     std::vector<std::uint8_t> buffer(size);
-    if (!buffer.empty()) {
-        input.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
-        if (input.gcount() != static_cast<std::streamsize>(buffer.size())) {
-            throw std::runtime_error("Failed to read entire file: " + descriptor_.absolutePath.string());
-        }
+    if (preadFully(fd, descriptor_.absolutePath, buffer.data(), buffer.size(), 0) != buffer.size()) {
+        throw std::runtime_error("Failed to read entire file: " + descriptor_.absolutePath.string());
     }
 
     return buffer;
@@ -139,31 +398,57 @@ std::vector<std::uint8_t> FileContext::readAll() const
 
 std::vector<std::uint8_t> FileContext::readRange(std::uintmax_t offset, std::size_t length) const
 {
-    const auto fileSize = safeFileSize(descriptor_.absolutePath);
+    const ReadHandle fd(descriptor_.absolutePath);
+    const auto fileSize = openFileSize(fd, descriptor_.absolutePath);
     if (offset >= fileSize) {
         return {};
     }
 
-    const auto available = static_cast<std::size_t>(std::min<std::uintmax_t>(fileSize - offset, length));
+    std::vector<std::uint8_t> buffer(static_cast<std::size_t>(std::min<std::uintmax_t>(fileSize - offset, length)));
+    buffer.resize(preadFully(fd, descriptor_.absolutePath, buffer.data(), buffer.size(), offset));
+    return buffer;
+}
+
+FileView FileContext::view() const
+{
+    const ReadHandle fd(descriptor_.absolutePath);
+    const auto size = static_cast<std::size_t>(openFileSize(fd, descriptor_.absolutePath));
 
-    std::ifstream input(descriptor_.absolutePath, std::ios::binary);
-    if (!input) {
-        throw std::runtime_error("Failed to open file for reading: " + descriptor_.absolutePath.string());
+    FileView view;
+    if (size == 0U) {
+        return view;
     }
 
-    input.seekg(static_cast<std::streamoff>(offset));
-    if (!input) {
-        throw std::runtime_error("Failed to seek file: " + descriptor_.absolutePath.string());
+    if (size >= kMapThreshold) {
+        int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+        if (size <= kPopulateLimit) {
+            flags |= MAP_POPULATE;
+        }
+#endif
+        void* mapping = ::mmap(nullptr, size, PROT_READ, flags, fd.get(), 0);
+        if (mapping != MAP_FAILED) {
+            ::madvise(mapping, size, MADV_SEQUENTIAL);
+            if (size > kPopulateLimit) {
+                ::madvise(mapping, size, MADV_WILLNEED);
+            }
+            view.mapping_ = mapping;
+            view.mappingSize_ = size;
+            return view;
+        }
     }
 
-    std::vector<std::uint8_t> buffer(available);
-    if (!buffer.empty()) {
-        input.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
-        const auto readBytes = static_cast<std::size_t>(input.gcount());
-        buffer.resize(readBytes);
+    view.buffer_.resize(size);
+    if (preadFully(fd, descriptor_.absolutePath, view.buffer_.data(), size, 0) != size) {
+        throw std::runtime_error("Failed to read entire file: " + descriptor_.absolutePath.string());
     }
+    return view;
+}
 
-    return buffer;
+std::size_t FileContext::readInto(std::uintmax_t offset, std::uint8_t* buffer, std::size_t length) const
+{
+    const ReadHandle fd(descriptor_.absolutePath);
+    return preadFully(fd, descriptor_.absolutePath, buffer, length, offset);
 }
 
 void FileContext::writeAll(const std::filesystem::path& destinationPath, const std::vector<std::uint8_t>& data) const
@@ -230,7 +515,7 @@ DirectoryContext::DirectoryContext(std::filesystem::path rootPath, bool followSy
     , followSymlinks_(followSymlinks)
 {
     std::error_code ec;
-    if (!std::filesystem::exists(rootPath_, ec) || !std::filesystem::is_directory(rootPath_, ec)) {
+    if (!std::filesystem::is_directory(rootPath_, ec)) {
         throw std::invalid_argument("DirectoryContext requires an existing directory");
     }
 }
@@ -245,70 +530,50 @@ bool DirectoryContext::followsSymlinks() const noexcept
     return followSymlinks_;
 }
 
-std::vector<FileDescriptor> DirectoryContext::listEntries(bool recursive, bool includeDirectories) const
+std::vector<FileDescriptor> DirectoryContext::listEntries(bool recursive, bool includeDirectories,
+                                                        std::size_t threadCount) const
 {
-    std::vector<FileDescriptor> entries;
-
-    const auto options = followSymlinks_
-        ? std::filesystem::directory_options::follow_directory_symlink
-        : std::filesystem::directory_options::none;
-
-    std::error_code ec;
-
-    if (!recursive) {
-        std::filesystem::directory_iterator iterator(rootPath_, options, ec);
-        if (ec) {
-            throw std::filesystem::filesystem_error("directory_iterator", rootPath_, ec);
-        }
-
-        for (const auto& entry : iterator) {
-            const auto descriptor = buildDescriptor(entry);
-            if (!includeDirectories && descriptor.type == EntryType::Directory) {
-                continue;
-            }
-            entries.push_back(descriptor);
-        }
-    } else {
-        std::filesystem::recursive_directory_iterator iterator(rootPath_, options, ec);
-        if (ec) {
-            throw std::filesystem::filesystem_error("recursive_directory_iterator", rootPath_, ec);
-        }
+    const gesa::concurrency::PoolLease lease(threadCount);
+    return listEntries(lease.get(), recursive, includeDirectories);
+}
 
-        for (const auto& entry : iterator) {
-            const auto descriptor = buildDescriptor(entry);
-            if (!includeDirectories && descriptor.type == EntryType::Directory) {
-                continue;
-            }
+std::vector<FileDescriptor> DirectoryContext::listEntries(gesa::concurrency::ThreadPool& pool, bool recursive,
+                                                        bool includeDirectories) const
+{
+    std::mutex mutex;
+    std::vector<FileDescriptor> entries;
+    walk(
+        pool,
+        [&](const FileDescriptor& descriptor) {
+            std::lock_guard<std::mutex> lock(mutex);
             entries.push_back(descriptor);
-        }
-    }
+        },
+        recursive,
+        includeDirectories);
 
+    std::sort(entries.begin(), entries.end(), [](const FileDescriptor& left, const FileDescriptor& right) {
+        return left.relativePath.generic_string() < right.relativePath.generic_string();
+    });
     return entries;
 }
 
-FileDescriptor DirectoryContext::buildDescriptor(const std::filesystem::directory_entry& entry) const
+void DirectoryContext::walk(gesa::concurrency::ThreadPool& pool, const EntryCallback& onEntry,
+                            bool recursive, bool includeDirectories) const
 {
-    auto descriptor = describePath(entry.path());
-
-    std::error_code ec;
-    auto relative = std::filesystem::relative(descriptor.absolutePath, rootPath_, ec);
-    if (ec) {
-        relative = descriptor.absolutePath.lexically_relative(rootPath_);
-    }
-    if (relative.empty()) {
-        relative = descriptor.absolutePath.filename();
-    }
-    descriptor.relativePath = std::move(relative);
-
-    descriptor.type = resolveType(entry);
-    if (descriptor.type == EntryType::File) {
-        descriptor.size = safeFileSize(entry.path());
+    WalkState state;
+    state.root = rootPath_;
+    state.recursive = recursive;
+    state.includeDirectories = includeDirectories;
+    state.followSymlinks = followSymlinks_;
+    state.onEntry = &onEntry;
+
+    scheduleDirectory(pool, state, std::filesystem::path());
+
+    std::unique_lock<std::mutex> lock(state.mutex);
+    state.done.wait(lock, [&state]() { return state.pending == 0U; });
+    if (state.error) {
+        std::rethrow_exception(state.error);
     }
-
-    descriptor.lastWriteTime = safeLastWriteTime(entry.path());
-    descriptor.isSymlink = entry.is_symlink(ec);
-
-    return descriptor;
 }
 
 } // namespace gesa::filesystem
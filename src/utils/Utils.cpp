@@ -1,4 +1,5 @@
 #include "Utils.h"
+#include "concurrency/shared_pool.hpp"
 #include <unordered_map>
 #include <vector>
 #include <omp.h>
@@ -255,11 +256,12 @@ std::unordered_map<char, int> Utils::createFreqMap(const std::vector<char>& data
      * @return: The frequency map of characters in the input data
      */
     auto start = std::chrono::high_resolution_clock::now();
-    int numThreads = omp_get_max_threads();
+    // Capped to the shared pool so the OpenMP team does not oversubscribe it.
+    int numThreads = static_cast<int>(gesa::concurrency::sharedPoolSize());
     std::vector<std::unordered_map<char, int>> threadMaps(numThreads);
     printf("\033[1;36m Threads used for create frequency map of characters: %d\033[0m\n", numThreads);
 
-    #pragma omp parallel
+    #pragma omp parallel num_threads(numThreads)
     {
         int threadId = omp_get_thread_num();
         auto& localMap = threadMaps[threadId];
@@ -0,0 +1,167 @@
+#include "utils/binary_io.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace gesa::utils {
+
+void BinaryWriter::writeBytes(const void* data, std::size_t size)
+{
+    if (size == 0U) {
+        return;
+    }
+    const auto* bytes = static_cast<const std::uint8_t*>(data);
+    buffer_.insert(buffer_.end(), bytes, bytes + size);
+}
+
+void BinaryWriter::writeString(const std::string& text)
+{
+    writeBytes(text.data(), text.size());
+}
+
+void BinaryWriter::flush(std::ostream& output)
+{
+    if (!buffer_.empty()) {
+        output.write(reinterpret_cast<const char*>(buffer_.data()), static_cast<std::streamsize>(buffer_.size()));
+        if (!output) {
+            throw std::runtime_error("Failed to write binary record");
+        }
+    }
+    buffer_.clear();
+}
+
+std::vector<std::uint8_t> BinaryWriter::release()
+{
+    std::vector<std::uint8_t> buffer;
+    buffer.swap(buffer_);
+    return buffer;
+}
+
+ByteReader::ByteReader(const std::uint8_t* data, std::size_t size)
+    : data_(data), size_(size)
+{
+}
+
+const std::uint8_t* ByteReader::consume(std::size_t size)
+{
+    if (size > remaining()) {
+        throw std::runtime_error("Truncated binary record");
+    }
+    const auto* bytes = data_ + cursor_;
+    cursor_ += size;
+    return bytes;
+}
+
+void ByteReader::readBytes(void* out, std::size_t size)
+{
+    const auto* bytes = consume(size);
+    if (size > 0U) {
+        std::memcpy(out, bytes, size);
+    }
+}
+
+void ByteReader::skip(std::size_t size)
+{
+    consume(size);
+}
+
+BufferedReader::BufferedReader(std::istream& input, std::size_t windowSize)
+    : input_(input), window_(std::max<std::size_t>(windowSize, 1U))
+{
+    const auto start = input_.tellg();
+    input_.seekg(0, std::ios::end);
+    const auto end = input_.tellg();
+    input_.seekg(start);
+    if (start < 0 || end < 0) {
+        throw std::runtime_error("Stream is not seekable");
+    }
+    windowOffset_ = static_cast<std::uint64_t>(start);
+    streamSize_ = static_cast<std::uint64_t>(end);
+}
+
+void BufferedReader::refill(std::size_t size)
+{
+    const auto leftover = end_ - cursor_;
+    if (leftover > 0U && cursor_ > 0U) {
+        std::memmove(window_.data(), window_.data() + cursor_, leftover);
+    }
+    windowOffset_ += cursor_;
+    cursor_ = 0;
+    end_ = leftover;
+
+    if (window_.size() < size) {
+        window_.resize(size);
+    }
+
+    const auto filled = windowOffset_ + end_;
+    const auto available = filled < streamSize_ ? streamSize_ - filled : std::uint64_t {0};
+    const auto want = static_cast<std::size_t>(std::min<std::uint64_t>(window_.size() - end_, available));
+    if (end_ + want < size) {
+        throw std::runtime_error("Unexpected end of stream");
+    }
+
+    input_.clear();
+    input_.seekg(static_cast<std::streamoff>(filled));
+    input_.read(reinterpret_cast<char*>(window_.data() + end_), static_cast<std::streamsize>(want));
+    if (input_.gcount() != static_cast<std::streamsize>(want)) {
+        throw std::runtime_error("Failed to read from stream");
+    }
+    end_ += want;
+}
+
+ByteReader BufferedReader::take(std::size_t size)
+{
+    if (end_ - cursor_ < size) {
+        refill(size);
+    }
+    ByteReader reader(window_.data() + cursor_, size);
+    cursor_ += size;
+    return reader;
+}
+
+void BufferedReader::readBytes(void* out, std::size_t size)
+{
+    if (size <= window_.size()) {
+        take(size).readBytes(out, size);
+        return;
+    }
+
+    auto* bytes = static_cast<std::uint8_t*>(out);
+    const auto buffered = end_ - cursor_;
+    std::memcpy(bytes, window_.data() + cursor_, buffered);
+
+    const auto start = position() + buffered;
+    const auto rest = size - buffered;
+    if (rest > streamSize_ - start) {
+        throw std::runtime_error("Unexpected end of stream");
+    }
+    input_.clear();
+    input_.seekg(static_cast<std::streamoff>(start));
+    input_.read(reinterpret_cast<char*>(bytes + buffered), static_cast<std::streamsize>(rest));
+    if (input_.gcount() != static_cast<std::streamsize>(rest)) {
+        throw std::runtime_error("Failed to read from stream");
+    }
+
+    windowOffset_ = start + rest;
+    cursor_ = 0;
+    end_ = 0;
+}
+
+void BufferedReader::skip(std::uint64_t size)
+{
+    if (size <= end_ - cursor_) {
+        cursor_ += static_cast<std::size_t>(size);
+        return;
+    }
+
+    const auto current = position();
+    if (size > streamSize_ - current) {
+        throw std::runtime_error("Unexpected end of stream");
+    }
+    windowOffset_ = current + size;
+    cursor_ = 0;
+    end_ = 0;
+}
+
+} // namespace gesa::utils
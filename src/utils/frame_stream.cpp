@@ -0,0 +1,194 @@
+#include "utils/frame_stream.hpp"
+
+#include "utils/binary_io.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#include <unistd.h>
+
+namespace gesa::utils {
+
+namespace {
+
+constexpr std::size_t kPreambleSize = 4U + sizeof(std::uint8_t);
+constexpr std::size_t kFrameHeaderSize = sizeof(std::uint32_t);
+
+} // namespace
+
+OstreamSink::OstreamSink(std::ostream& output)
+    : output_(output)
+{
+}
+
+void OstreamSink::write(ByteView data)
+{
+    if (data.empty()) {
+        return;
+    }
+    output_.write(reinterpret_cast<const char*>(data.data), static_cast<std::streamsize>(data.size));
+    output_.flush();
+    if (!output_) {
+        throw std::runtime_error("Failed to write stream output");
+    }
+}
+
+void OstreamSink::finish()
+{
+    output_.flush();
+    if (!output_) {
+        throw std::runtime_error("Failed to flush stream output");
+    }
+}
+
+FrameEncoder::FrameEncoder(const char (&magic)[4], FrameTransform transform, ByteSink& output,
+                           std::size_t chunkSize)
+    : magic_(magic, sizeof(magic))
+    , transform_(std::move(transform))
+    , output_(output)
+    , chunkSize_(chunkSize == 0U ? kStreamChunkSize : std::min(chunkSize, kStreamChunkSize))
+{
+    pending_.reserve(chunkSize_);
+}
+
+void FrameEncoder::emit(ByteView chunk)
+{
+    BinaryWriter writer;
+    if (!started_) {
+        writer.writeString(magic_);
+        writer.write<std::uint8_t>(kFrameStreamVersion);
+        started_ = true;
+    }
+
+    if (!chunk.empty()) {
+        const auto frame = transform_(chunk);
+        if (frame.empty() || frame.size() > std::numeric_limits<std::uint32_t>::max()) {
+            throw std::runtime_error("Stream frame size is out of range");
+        }
+        writer.write<std::uint32_t>(static_cast<std::uint32_t>(frame.size()));
+        writer.writeBytes(frame.data(), frame.size());
+    }
+    output_.write(writer.data());
+}
+
+void FrameEncoder::write(ByteView data)
+{
+    while (!data.empty()) {
+        if (pending_.empty() && data.size >= chunkSize_) {
+            emit(data.subview(0, chunkSize_));
+            data = data.subview(chunkSize_, data.size - chunkSize_);
+            continue;
+        }
+
+        const auto take = std::min(chunkSize_ - pending_.size(), data.size);
+        pending_.insert(pending_.end(), data.begin(), data.begin() + take);
+        data = data.subview(take, data.size - take);
+        if (pending_.size() == chunkSize_) {
+            emit(pending_);
+            pending_.clear();
+        }
+    }
+}
+
+void FrameEncoder::finish()
+{
+    if (!pending_.empty()) {
+        emit(pending_);
+        pending_.clear();
+    }
+
+    BinaryWriter writer;
+    if (!started_) {
+        writer.writeString(magic_);
+        writer.write<std::uint8_t>(kFrameStreamVersion);
+        started_ = true;
+    }
+    writer.write<std::uint32_t>(0U);
+    output_.write(writer.data());
+    output_.finish();
+}
+
+FrameDecoder::FrameDecoder(const char (&magic)[4], FrameTransform transform, ByteSink& output,
+                           std::size_t maxFrameSize)
+    : magic_(magic, sizeof(magic))
+    , transform_(std::move(transform))
+    , output_(output)
+    , maxFrameSize_(maxFrameSize)
+{
+}
+
+void FrameDecoder::write(ByteView data)
+{
+    pending_.insert(pending_.end(), data.begin(), data.end());
+
+    std::size_t cursor = 0;
+    if (!started_) {
+        if (pending_.size() < kPreambleSize) {
+            return;
+        }
+        if (std::string(pending_.begin(), pending_.begin() + 4) != magic_) {
+            throw std::runtime_error("Unrecognized stream magic");
+        }
+        if (pending_[4] != kFrameStreamVersion) {
+            throw std::runtime_error("Unsupported stream version");
+        }
+        cursor = kPreambleSize;
+        started_ = true;
+    }
+
+    while (!ended_ && pending_.size() - cursor >= kFrameHeaderSize) {
+        const auto frameSize = loadLittleEndian<std::uint32_t>(pending_.data() + cursor);
+        if (frameSize == 0U) {
+            cursor += kFrameHeaderSize;
+            ended_ = true;
+            break;
+        }
+        if (frameSize > maxFrameSize_) {
+            throw std::runtime_error("Stream frame exceeds the maximum frame size");
+        }
+        if (pending_.size() - cursor - kFrameHeaderSize < frameSize) {
+            break;
+        }
+        output_.write(transform_(ByteView(pending_.data() + cursor + kFrameHeaderSize, frameSize)));
+        cursor += kFrameHeaderSize + frameSize;
+    }
+
+    if (ended_ && cursor < pending_.size()) {
+        throw std::runtime_error("Unexpected data after end of stream");
+    }
+    pending_.erase(pending_.begin(), pending_.begin() + static_cast<std::ptrdiff_t>(cursor));
+}
+
+void FrameDecoder::finish()
+{
+    if (!ended_) {
+        throw std::runtime_error("Truncated stream: missing end frame");
+    }
+    output_.finish();
+}
+
+void pumpDescriptor(int fd, ByteSink& sink, std::size_t readSize)
+{
+    std::vector<std::uint8_t> buffer(readSize == 0U ? kStreamReadSize : readSize);
+    for (;;) {
+        const auto count = ::read(fd, buffer.data(), buffer.size());
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "Failed to read stream input");
+        }
+        if (count == 0) {
+            break;
+        }
+        sink.write(ByteView(buffer.data(), static_cast<std::size_t>(count)));
+    }
+    sink.finish();
+}
+
+} // namespace gesa::utils
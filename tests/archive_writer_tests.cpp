@@ -0,0 +1,230 @@
+#include "compression/archive_writer.hpp"
+#include "filesystem/positional_file.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+using gesa::compression::ArchiveRecord;
+using gesa::compression::kArchiveWriteChunkSize;
+using gesa::compression::planArchiveRuns;
+
+class ScopedTempDir {
+public:
+    explicit ScopedTempDir(const std::string& prefix)
+    {
+        const auto unique = prefix + "_" + std::to_string(
+            std::chrono::steady_clock::now().time_since_epoch().count());
+        path_ = std::filesystem::temp_directory_path() / unique;
+        std::filesystem::create_directories(path_);
+    }
+
+    ~ScopedTempDir()
+    {
+        std::error_code ec;
+        std::filesystem::remove_all(path_, ec);
+    }
+
+    const std::filesystem::path& path() const noexcept { return path_; }
+
+private:
+    std::filesystem::path path_;
+};
+
+std::vector<std::uint8_t> readBinaryFile(const std::filesystem::path& path)
+{
+    std::ifstream input(path, std::ios::binary);
+    return std::vector<std::uint8_t>((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+}
+
+void writeBinaryFile(const std::filesystem::path& path, const std::vector<std::uint8_t>& content)
+{
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    output.write(reinterpret_cast<const char*>(content.data()), static_cast<std::streamsize>(content.size()));
+}
+
+// Record starts for records of the given sizes after a header of headerSize bytes,
+// followed by the archive end, as writeArchiveFile lays them out.
+std::vector<std::uint64_t> offsetsOf(std::uint64_t headerSize, const std::vector<std::uint64_t>& sizes)
+{
+    std::vector<std::uint64_t> offsets {headerSize};
+    for (const auto size : sizes) {
+        offsets.push_back(offsets.back() + size);
+    }
+    return offsets;
+}
+
+std::vector<std::uint8_t> pattern(std::size_t size, std::uint8_t seed)
+{
+    std::vector<std::uint8_t> bytes(size);
+    for (std::size_t index = 0; index < size; ++index) {
+        bytes[index] = static_cast<std::uint8_t>(seed + index * 31U);
+    }
+    return bytes;
+}
+
+int unsupportedAllocate(int, std::int64_t)
+{
+    errno = EOPNOTSUPP;
+    return -1;
+}
+
+int missingAllocate(int, std::int64_t)
+{
+    errno = ENOSYS;
+    return -1;
+}
+
+int failingAllocate(int, std::int64_t)
+{
+    errno = EIO;
+    return -1;
+}
+
+TEST(ArchiveWriterTest, CoalescesRunsUpToTheChunkSize)
+{
+    const auto quarter = kArchiveWriteChunkSize / 4U;
+    const auto half = kArchiveWriteChunkSize / 2U;
+
+    // Four quarters fill one chunk exactly and share a run; the fifth starts the next.
+    EXPECT_EQ(planArchiveRuns(offsetsOf(16, {quarter, quarter, quarter, quarter, quarter})),
+              (std::vector<std::size_t> {0, 4, 5}));
+    // One byte short of a chunk the run stays open, and the next record closes it at the limit.
+    EXPECT_EQ(planArchiveRuns(offsetsOf(16, {kArchiveWriteChunkSize - 1U, 1, 1})), (std::vector<std::size_t> {0, 2, 3}));
+    // One byte past the limit the run is still one run, written record by record.
+    EXPECT_EQ(planArchiveRuns(offsetsOf(16, {half, half + 1U, 1})), (std::vector<std::size_t> {0, 2, 3}));
+    // A record above the chunk size on its own is a run of one.
+    EXPECT_EQ(planArchiveRuns(offsetsOf(16, {kArchiveWriteChunkSize + 5U, 1})), (std::vector<std::size_t> {0, 1, 2}));
+    EXPECT_EQ(planArchiveRuns(offsetsOf(16, {})), (std::vector<std::size_t> {0}));
+}
+
+TEST(ArchiveWriterTest, WritesRunsOnBothSidesOfTheChunkSize)
+{
+    ScopedTempDir temp("archive_writer_runs");
+    const auto destination = temp.path() / "archive.bin";
+    const auto sourcePath = temp.path() / "previous.bin";
+    const auto half = static_cast<std::size_t>(kArchiveWriteChunkSize / 2U);
+
+    const auto previous = pattern(4096, 7);
+    writeBinaryFile(sourcePath, previous);
+    const gesa::filesystem::SourceFile source(sourcePath);
+
+    const std::vector<std::uint8_t> header(24, 0xA5);
+    std::vector<std::vector<std::uint8_t>> payloads {pattern(half, 3), pattern(half + 1U, 4), pattern(100, 1),
+                                                     pattern(200, 2), pattern(50, 5)};
+    std::vector<ArchiveRecord> records;
+    for (std::size_t index = 0; index < payloads.size(); ++index) {
+        records.push_back({std::vector<std::uint8_t>(8, static_cast<std::uint8_t>(index)), payloads[index], {}});
+    }
+    // A copied payload inside the coalesced run splits its buffer.
+    records.insert(records.begin() + 3, ArchiveRecord {std::vector<std::uint8_t>(8, 0xEE), {}, {&source, 1000, 1500}});
+
+    // The two halves overflow the chunk and go out record by record; the rest is one buffer.
+    std::vector<std::uint64_t> sizes;
+    for (const auto& record : records) {
+        sizes.push_back(record.header.size() + (record.copy.source != nullptr ? record.copy.size : record.payload.size));
+    }
+    ASSERT_EQ(planArchiveRuns(offsetsOf(header.size(), sizes)), (std::vector<std::size_t> {0, 2, 6}));
+
+    std::vector<std::uint8_t> expected = header;
+    for (const auto& record : records) {
+        expected.insert(expected.end(), record.header.begin(), record.header.end());
+        if (record.copy.source != nullptr) {
+            expected.insert(expected.end(), previous.begin() + 1000, previous.begin() + 2500);
+        } else {
+            expected.insert(expected.end(), record.payload.begin(), record.payload.end());
+        }
+    }
+
+    gesa::concurrency::ThreadPool pool(4);
+    gesa::compression::writeArchiveFile(destination, header, records, pool);
+    EXPECT_EQ(readBinaryFile(destination), expected);
+}
+
+TEST(ArchiveWriterTest, FailedWriteLeavesTheDestinationUntouched)
+{
+    ScopedTempDir temp("archive_writer_failure");
+    const auto destination = temp.path() / "archive.bin";
+    const auto sourcePath = temp.path() / "short.bin";
+    const auto previous = pattern(300, 4);
+    writeBinaryFile(destination, previous);
+    writeBinaryFile(sourcePath, pattern(10, 9));
+    const gesa::filesystem::SourceFile source(sourcePath);
+
+    const std::vector<std::uint8_t> header {'G', 'H', 'A', 'R'};
+    const auto payload = pattern(64, 1);
+    // The second record copies more than its source holds, so the records fail mid-write.
+    const std::vector<ArchiveRecord> records {{std::vector<std::uint8_t>(8, 0x11), payload, {}},
+                                              {std::vector<std::uint8_t>(8, 0x22), {}, {&source, 0, 100}}};
+
+    gesa::concurrency::ThreadPool pool(2);
+    EXPECT_THROW(gesa::compression::writeArchiveFile(destination, header, records, pool), std::runtime_error);
+
+    // The partial archive only ever existed under a temporary name, which is gone again.
+    EXPECT_EQ(readBinaryFile(destination), previous);
+    std::vector<std::filesystem::path> names;
+    for (const auto& entry : std::filesystem::directory_iterator(temp.path())) {
+        names.push_back(entry.path().filename());
+    }
+    std::sort(names.begin(), names.end());
+    EXPECT_EQ(names, (std::vector<std::filesystem::path> {"archive.bin", "short.bin"}));
+}
+
+TEST(ArchiveWriterTest, ReplacesTheDestinationKeepingItsPermissions)
+{
+    ScopedTempDir temp("archive_writer_replace");
+    const auto destination = temp.path() / "archive.bin";
+    writeBinaryFile(destination, pattern(300, 4));
+    std::filesystem::permissions(destination, std::filesystem::perms::owner_read | std::filesystem::perms::owner_write
+                                                  | std::filesystem::perms::group_read);
+
+    const std::vector<std::uint8_t> header {'G', 'H', 'A', 'R'};
+    const auto payload = pattern(64, 1);
+    gesa::concurrency::ThreadPool pool(2);
+    gesa::compression::writeArchiveFile(destination, header, {{std::vector<std::uint8_t>(8, 0x11), payload, {}}}, pool);
+
+    std::vector<std::uint8_t> expected = header;
+    expected.insert(expected.end(), 8U, 0x11);
+    expected.insert(expected.end(), payload.begin(), payload.end());
+    EXPECT_EQ(readBinaryFile(destination), expected);
+    EXPECT_EQ(std::filesystem::status(destination).permissions(),
+              std::filesystem::perms::owner_read | std::filesystem::perms::owner_write | std::filesystem::perms::group_read);
+}
+
+TEST(PositionalFileTest, SizesWithFtruncateWhenPreallocationIsUnsupported)
+{
+    ScopedTempDir temp("positional_file_reserve");
+    const auto path = temp.path() / "output.bin";
+
+    for (const auto allocate : {unsupportedAllocate, missingAllocate}) {
+        const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+        ASSERT_GE(fd, 0);
+        EXPECT_NO_THROW(gesa::filesystem::detail::reserveSpace(fd, 12345, path, allocate));
+        ::close(fd);
+        EXPECT_EQ(std::filesystem::file_size(path), 12345U);
+    }
+
+    // Any other failure is reported rather than papered over.
+    const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    ASSERT_GE(fd, 0);
+    EXPECT_THROW(gesa::filesystem::detail::reserveSpace(fd, 12345, path, failingAllocate), std::system_error);
+    ::close(fd);
+    EXPECT_EQ(std::filesystem::file_size(path), 0U);
+}
+
+} // namespace
@@ -0,0 +1,64 @@
+#include "utils/binary_io.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+using gesa::utils::BinaryWriter;
+using gesa::utils::BufferedReader;
+using gesa::utils::ByteReader;
+
+TEST(BinaryIoTest, EncodesLittleEndian)
+{
+    BinaryWriter writer;
+    writer.write(std::uint32_t {0x04030201U});
+    writer.write(std::int16_t {-2});
+
+    const auto& bytes = writer.data();
+    ASSERT_EQ(bytes.size(), 6U);
+    EXPECT_EQ(bytes[0], 0x01U);
+    EXPECT_EQ(bytes[3], 0x04U);
+    EXPECT_EQ(bytes[4], 0xFEU);
+    EXPECT_EQ(bytes[5], 0xFFU);
+
+    ByteReader reader(bytes.data(), bytes.size());
+    EXPECT_EQ(reader.read<std::uint32_t>(), 0x04030201U);
+    EXPECT_EQ(reader.read<std::int16_t>(), -2);
+    EXPECT_THROW(reader.read<std::uint8_t>(), std::runtime_error);
+}
+
+TEST(BinaryIoTest, BufferedReaderCrossesWindowsAndSkips)
+{
+    BinaryWriter writer;
+    for (std::uint32_t value = 0; value < 100; ++value) {
+        writer.write(value);
+    }
+    writer.writeString(std::string(40, 'x'));
+    writer.write(std::uint64_t {0xDEADBEEFULL});
+
+    std::stringstream stream;
+    writer.flush(stream);
+    EXPECT_EQ(writer.size(), 0U);
+
+    BufferedReader reader(stream, 16);
+    EXPECT_EQ(reader.size(), 400U + 40U + 8U);
+    for (std::uint32_t value = 0; value < 50; ++value) {
+        EXPECT_EQ(reader.read<std::uint32_t>(), value);
+    }
+    reader.skip(49U * sizeof(std::uint32_t));
+    EXPECT_EQ(reader.read<std::uint32_t>(), 99U);
+
+    std::string text(40, '\0');
+    reader.readBytes(text.data(), text.size());
+    EXPECT_EQ(text, std::string(40, 'x'));
+    EXPECT_EQ(reader.read<std::uint64_t>(), 0xDEADBEEFULL);
+    EXPECT_EQ(reader.position(), reader.size());
+    EXPECT_THROW(reader.read<std::uint8_t>(), std::runtime_error);
+}
+
+} // namespace
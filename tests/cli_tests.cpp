@@ -0,0 +1,172 @@
+#include "cli/application.hpp"
+#include "encryption/RSA.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+
+class ScopedTempDir {
+public:
+    explicit ScopedTempDir(const std::string& prefix)
+    {
+        const auto unique = prefix + "_" + std::to_string(
+            std::chrono::steady_clock::now().time_since_epoch().count());
+        path_ = std::filesystem::temp_directory_path() / unique;
+        std::filesystem::create_directories(path_);
+    }
+
+    ~ScopedTempDir()
+    {
+        std::error_code ec;
+        std::filesystem::remove_all(path_, ec);
+    }
+
+    const std::filesystem::path& path() const noexcept { return path_; }
+
+private:
+    std::filesystem::path path_;
+};
+
+// Points TMPDIR at a directory of the test, so scratch directories of a chain land there.
+class ScopedTmpdir {
+public:
+    explicit ScopedTmpdir(const std::filesystem::path& path)
+    {
+        if (const char* previous = std::getenv("TMPDIR")) {
+            previous_ = previous;
+        }
+        std::filesystem::create_directories(path);
+        ::setenv("TMPDIR", path.c_str(), 1);
+    }
+
+    ~ScopedTmpdir()
+    {
+        if (previous_) {
+            ::setenv("TMPDIR", previous_->c_str(), 1);
+        } else {
+            ::unsetenv("TMPDIR");
+        }
+    }
+
+private:
+    std::optional<std::string> previous_;
+};
+
+void writeBinaryFile(const std::filesystem::path& path, const std::string& content)
+{
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    output << content;
+}
+
+std::map<std::string, std::string> readTree(const std::filesystem::path& root)
+{
+    std::map<std::string, std::string> files;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(root)) {
+        if (entry.is_regular_file()) {
+            std::ifstream input(entry.path(), std::ios::binary);
+            files[std::filesystem::relative(entry.path(), root).generic_string()] =
+                std::string((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+        }
+    }
+    return files;
+}
+
+void writeSampleTree(const std::filesystem::path& root)
+{
+    writeBinaryFile(root / "a.txt", "alpha alpha alpha");
+    writeBinaryFile(root / "nested" / "b.txt", std::string(4096, 'b'));
+    writeBinaryFile(root / "nested" / "deeper" / "c.txt", "gamma");
+}
+
+int runCli(std::vector<std::string> arguments)
+{
+    arguments.insert(arguments.begin(), "gsea");
+    std::vector<char*> argv;
+    for (auto& argument : arguments) {
+        argv.push_back(argument.data());
+    }
+    return gesa::cli::run(static_cast<int>(argv.size()), argv.data());
+}
+
+struct DemoKeys {
+    std::string publicKey;
+    std::string privateKey;
+};
+
+DemoKeys demoKeys()
+{
+    Rsa rsa(61, 53);
+    const auto keys = rsa.generateKeys();
+    DemoKeys result {keys.publicKey, keys.privateKey};
+    Utils::freeCString(keys.publicKey);
+    Utils::freeCString(keys.privateKey);
+    return result;
+}
+
+} // namespace
+
+TEST(CliChainTest, CompressEncryptRoundTripsThroughDecryptDecompress)
+{
+    ScopedTempDir temp("cli_chain_roundtrip");
+    const auto input = temp.path() / "input";
+    writeSampleTree(input);
+    const auto keys = demoKeys();
+
+    for (const std::string algorithm : {"huffman", "lzw"}) {
+        const auto sealed = temp.path() / (algorithm + ".sealed");
+        const auto output = temp.path() / (algorithm + "-output");
+        ASSERT_EQ(runCli({"-ce", "--comp-alg", algorithm, "--enc-alg", "rsa", "-i", input.string(), "-o", sealed.string(),
+                          "-k", keys.publicKey}),
+                  0);
+        ASSERT_EQ(runCli({"-ud", "--comp-alg", algorithm, "--enc-alg", "rsa", "-i", sealed.string(), "-o", output.string(),
+                          "-k", keys.privateKey}),
+                  0);
+        EXPECT_EQ(readTree(output), readTree(input)) << algorithm;
+    }
+}
+
+TEST(CliChainTest, PassesMidChainArchivesThroughMemory)
+{
+    ScopedTempDir temp("cli_chain_memfd");
+    const auto input = temp.path() / "input";
+    const auto output = temp.path() / "output";
+    const auto scratch = temp.path() / "tmp";
+    writeSampleTree(input);
+    const ScopedTmpdir tmpdir(scratch);
+
+    // The archive made by -c only exists as an in-memory file that -d expands.
+    ASSERT_EQ(runCli({"-cd", "--comp-alg", "huffman", "-i", input.string(), "-o", output.string()}), 0);
+    EXPECT_EQ(readTree(output), readTree(input));
+    EXPECT_TRUE(std::filesystem::is_empty(scratch));
+}
+
+TEST(CliChainTest, FailingStageLeavesNoOutputOrScratchDirectory)
+{
+    ScopedTempDir temp("cli_chain_failure");
+    const auto input = temp.path() / "input";
+    const auto archive = temp.path() / "archive.ghar";
+    const auto output = temp.path() / "output.sealed";
+    const auto scratch = temp.path() / "tmp";
+    writeSampleTree(input);
+    ASSERT_EQ(runCli({"-c", "--comp-alg", "huffman", "-i", input.string(), "-o", archive.string()}), 0);
+
+    const ScopedTmpdir tmpdir(scratch);
+    const auto keys = demoKeys();
+    // -d expands the archive into a scratch directory, which -e then rejects.
+    EXPECT_NE(runCli({"-de", "--comp-alg", "huffman", "--enc-alg", "rsa", "-i", archive.string(), "-o", output.string(),
+                      "-k", keys.publicKey}),
+              0);
+    EXPECT_FALSE(std::filesystem::exists(output));
+    EXPECT_TRUE(std::filesystem::is_empty(scratch));
+}
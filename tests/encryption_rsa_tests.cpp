@@ -0,0 +1,117 @@
+#include "encryption/RSA.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Key {
+    int exponent;
+    int modulus;
+    std::string encoded;
+};
+
+struct KeyPair {
+    Key publicKey;
+    Key privateKey;
+};
+
+Key decodeKey(char* encoded)
+{
+    const auto numbers = Utils::base64ToNumbers(encoded);
+    Key key {numbers.at(0), numbers.at(1), encoded};
+    Utils::freeCString(encoded);
+    return key;
+}
+
+KeyPair makeKeys(int p, int q)
+{
+    Rsa rsa(p, q);
+    const auto keys = rsa.generateKeys();
+    return {decodeKey(keys.publicKey), decodeKey(keys.privateKey)};
+}
+
+std::vector<std::uint8_t> everyByte()
+{
+    std::vector<std::uint8_t> bytes(256);
+    for (int value = 0; value < 256; ++value) {
+        bytes[value] = static_cast<std::uint8_t>(value);
+    }
+    return bytes;
+}
+
+std::vector<std::uint8_t> bigEndianWord(int value)
+{
+    return {static_cast<std::uint8_t>(value >> 24), static_cast<std::uint8_t>(value >> 16),
+            static_cast<std::uint8_t>(value >> 8), static_cast<std::uint8_t>(value & 0xFF)};
+}
+
+// Compares every ciphertext word against the textbook computation for key.
+void expectMatchesPowerModulus(const std::vector<std::uint8_t>& encrypted, const Key& key)
+{
+    ASSERT_EQ(encrypted.size(), 256U * 4U);
+    for (int value = 0; value < 256; ++value) {
+        const std::vector<std::uint8_t> word(encrypted.begin() + value * 4, encrypted.begin() + value * 4 + 4);
+        EXPECT_EQ(word, bigEndianWord(Utils::powerModulus(value, key.exponent, key.modulus)))
+            << "byte " << value << " under n=" << key.modulus;
+    }
+}
+
+TEST(RsaTest, EncryptionTableMatchesPowerModulusForEveryByte)
+{
+    const auto keys = makeKeys(61, 53);
+    Rsa rsa(61, 53);
+    expectMatchesPowerModulus(rsa.encrypt(everyByte(), keys.publicKey.encoded), keys.publicKey);
+}
+
+TEST(RsaTest, DecryptionTableRoundTripsEveryByte)
+{
+    const auto keys = makeKeys(61, 53);
+    ASSERT_LE(keys.privateKey.modulus, kRsaDecryptTableLimit);
+    Rsa rsa(61, 53);
+    const auto encrypted = rsa.encrypt(everyByte(), keys.publicKey.encoded);
+    EXPECT_EQ(rsa.decrypt(encrypted, keys.privateKey.encoded), everyByte());
+}
+
+TEST(RsaTest, WordsAtOrAboveTheModulusTakeTheFallbackPath)
+{
+    const auto keys = makeKeys(61, 53);
+    const int n = keys.privateKey.modulus;
+    const int ciphertext = Utils::powerModulus('A', keys.publicKey.exponent, n);
+
+    // The table only covers words below n; these are reduced by powerModulus instead.
+    std::vector<std::uint8_t> data;
+    for (const int word : {ciphertext, n + ciphertext, 2 * n + ciphertext}) {
+        const auto bytes = bigEndianWord(word);
+        data.insert(data.end(), bytes.begin(), bytes.end());
+    }
+    Rsa rsa(61, 53);
+    EXPECT_EQ(rsa.decrypt(data, keys.privateKey.encoded), (std::vector<std::uint8_t> {'A', 'A', 'A'}));
+}
+
+TEST(RsaTest, KeyChangeRebuildsBothTables)
+{
+    // Both public keys share e = 7, so only the modulus tells the encryption tables apart.
+    const auto first = makeKeys(61, 53);
+    const auto second = makeKeys(31, 61);
+    ASSERT_EQ(first.publicKey.exponent, second.publicKey.exponent);
+    ASSERT_NE(first.publicKey.modulus, second.publicKey.modulus);
+
+    Rsa rsa(61, 53);
+    const auto bytes = everyByte();
+    const auto firstEncrypted = rsa.encrypt(bytes, first.publicKey.encoded);
+    EXPECT_EQ(rsa.decrypt(firstEncrypted, first.privateKey.encoded), bytes);
+
+    const auto secondEncrypted = rsa.encrypt(bytes, second.publicKey.encoded);
+    expectMatchesPowerModulus(secondEncrypted, second.publicKey);
+    EXPECT_EQ(rsa.decrypt(secondEncrypted, second.privateKey.encoded), bytes);
+
+    // Switching back must not keep serving the second key's tables either.
+    expectMatchesPowerModulus(rsa.encrypt(bytes, first.publicKey.encoded), first.publicKey);
+    EXPECT_EQ(rsa.decrypt(firstEncrypted, first.privateKey.encoded), bytes);
+}
+
+} // namespace
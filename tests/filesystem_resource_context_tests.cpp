@@ -1,3 +1,4 @@
+#include "filesystem/batch_io.hpp"
 #include "filesystem/resource_context.hpp"
 
 #include <gtest/gtest.h>
@@ -7,10 +8,12 @@
 #include <filesystem>
 #include <fstream>
 #include <iterator>
+#include <memory>
 #include <mutex>
 #include <set>
 #include <stdexcept>
 #include <string>
+#include <system_error>
 #include <vector>
 
 namespace {
@@ -87,6 +90,102 @@ TEST(FileContextTest, ReadWriteAndCopy)
     EXPECT_EQ(copiedContent, payload);
 }
 
+TEST(FileContextTest, DescribesSymlinksFromTheirTargets)
+{
+    ScopedTempDir temp("describe_path");
+    const auto target = temp.path() / "target.txt";
+    const auto link = temp.path() / "link.txt";
+    const auto dangling = temp.path() / "dangling.txt";
+    writeFile(target, "twelve bytes");
+    std::filesystem::create_symlink(target, link);
+    std::filesystem::create_symlink(temp.path() / "missing.txt", dangling);
+
+    const auto plain = gesa::filesystem::describePath(target);
+    EXPECT_FALSE(plain.isSymlink);
+    EXPECT_EQ(plain.size, 12U);
+    EXPECT_EQ(plain.lastWriteTime, std::filesystem::last_write_time(target));
+
+    const auto linked = gesa::filesystem::describePath(link);
+    EXPECT_TRUE(linked.isSymlink);
+    EXPECT_EQ(linked.type, gesa::filesystem::EntryType::File);
+    EXPECT_EQ(linked.size, 12U);
+    EXPECT_EQ(linked.lastWriteTime, plain.lastWriteTime);
+
+    const auto broken = gesa::filesystem::describePath(dangling);
+    EXPECT_TRUE(broken.isSymlink);
+    EXPECT_EQ(broken.size, 0U);
+
+    EXPECT_EQ(gesa::filesystem::describePath(temp.path()).type, gesa::filesystem::EntryType::Directory);
+    EXPECT_EQ(gesa::filesystem::FileContext(plain).readAll().size(), 12U);
+}
+
+TEST(FileContextTest, ViewsMapLargeFilesAndReadSmallOnes)
+{
+    ScopedTempDir temp("file_view");
+    const auto small = temp.path() / "small.bin";
+    const auto large = temp.path() / "large.bin";
+
+    const std::string smallPayload = "small payload";
+    std::string largePayload(static_cast<std::size_t>(gesa::filesystem::kMapThreshold) + 17U, '\0');
+    for (std::size_t index = 0; index < largePayload.size(); ++index) {
+        largePayload[index] = static_cast<char>(index % 251U);
+    }
+    writeFile(small, smallPayload);
+    writeFile(large, largePayload);
+
+    const auto smallView = gesa::filesystem::FileContext(small).view();
+    EXPECT_FALSE(smallView.mapped());
+    const auto smallBytes = smallView.bytes();
+    EXPECT_EQ(std::string(smallBytes.begin(), smallBytes.end()), smallPayload);
+
+    auto largeView = gesa::filesystem::FileContext(large).view();
+    EXPECT_TRUE(largeView.mapped());
+    const auto moved = std::move(largeView);
+    const auto largeBytes = moved.bytes();
+    EXPECT_EQ(std::string(largeBytes.begin(), largeBytes.end()), largePayload);
+
+    std::string slice(32, '\0');
+    EXPECT_EQ(gesa::filesystem::FileContext(small).readInto(6, reinterpret_cast<std::uint8_t*>(slice.data()), slice.size()), 7U);
+    EXPECT_EQ(slice.substr(0, 7), "payload");
+}
+
+TEST(BatchIoTest, BackendsWriteAndReadManyFiles)
+{
+    ScopedTempDir temp("batch_io");
+
+    std::vector<std::unique_ptr<gesa::filesystem::BatchIo>> backends;
+    backends.emplace_back(gesa::filesystem::makeBlockingBatchIo());
+    backends.emplace_back(gesa::filesystem::makeBatchIo());
+
+    for (const auto& io : backends) {
+        const auto root = temp.path() / io->name();
+
+        std::vector<std::string> payloads;
+        std::vector<gesa::filesystem::WriteRequest> writes;
+        for (std::size_t index = 0; index < 300; ++index) {
+            payloads.push_back(std::string(index, static_cast<char>('a' + index % 26U)));
+        }
+        for (std::size_t index = 0; index < payloads.size(); ++index) {
+            const auto* bytes = reinterpret_cast<const std::uint8_t*>(payloads[index].data());
+            writes.push_back({root / std::to_string(index % 7U) / (std::to_string(index) + ".bin"),
+                              gesa::utils::ByteView(bytes, payloads[index].size())});
+        }
+        io->writeFiles(writes);
+
+        std::vector<gesa::filesystem::ReadRequest> reads;
+        for (std::size_t index = 0; index < writes.size(); ++index) {
+            reads.push_back({writes[index].path, index % 2U == 0U ? payloads[index].size() : 0U});
+        }
+        const auto contents = io->readFiles(reads);
+        ASSERT_EQ(contents.size(), payloads.size());
+        for (std::size_t index = 0; index < payloads.size(); ++index) {
+            EXPECT_EQ(std::string(contents[index].begin(), contents[index].end()), payloads[index]) << io->name();
+        }
+
+        EXPECT_THROW(io->readFiles({{root / "missing.bin", 4U}}), std::system_error);
+    }
+}
+
 TEST(DirectoryContextTest, ListsEntries)
 {
     ScopedTempDir temp("dir_context");
@@ -140,3 +239,83 @@ TEST(DirectoryContextTest, ForEachFileRunsInParallel)
     std::sort(visited.begin(), visited.end());
     EXPECT_EQ(visited, (std::vector<std::string>{"a.txt", "sub/b.txt", "sub/c.txt"}));
 }
+
+TEST(DirectoryContextTest, ForEachFileStartsCallbacksBeforeTheWalkFinishes)
+{
+    ScopedTempDir temp("dir_context_streaming");
+    const auto root = temp.path();
+    constexpr int kDirectories = 16;
+    for (int index = 0; index < kDirectories; ++index) {
+        const auto subdir = root / ("d" + std::to_string(index));
+        std::filesystem::create_directories(subdir);
+        writeFile(subdir / "file.txt", "payload");
+    }
+
+    gesa::filesystem::DirectoryContext directory(root);
+
+    // A single worker scans a directory and then runs the callback it queued before the
+    // other directories are scanned. Files the first callback creates are only reported
+    // when the walk was still running at that point; a listing taken up front misses them.
+    bool seeded = false;
+    std::size_t visited = 0;
+    std::size_t late = 0;
+    directory.forEachFile(
+        [&](const gesa::filesystem::FileDescriptor& descriptor) {
+            ++visited;
+            if (descriptor.relativePath.filename() == "late.txt") {
+                ++late;
+            }
+            if (!seeded) {
+                seeded = true;
+                for (int index = 0; index < kDirectories; ++index) {
+                    writeFile(root / ("d" + std::to_string(index)) / "late.txt", "late");
+                }
+            }
+        },
+        true,
+        1);
+
+    EXPECT_GT(late, 0U);
+    EXPECT_EQ(visited, static_cast<std::size_t>(kDirectories) + late);
+}
+
+TEST(DirectoryContextTest, WalksNestedTreesWithMetadata)
+{
+    ScopedTempDir temp("dir_context_walk");
+    const auto root = temp.path();
+    std::set<std::string> expected;
+    for (int outer = 0; outer < 4; ++outer) {
+        for (int inner = 0; inner < 3; ++inner) {
+            const auto relative = "d" + std::to_string(outer) + "/e" + std::to_string(inner) + "/f.txt";
+            std::filesystem::create_directories((root / relative).parent_path());
+            writeFile(root / relative, relative);
+            expected.insert(relative);
+        }
+    }
+
+    gesa::filesystem::DirectoryContext directory(root);
+    gesa::concurrency::ThreadPool pool(3);
+
+    std::mutex mutex;
+    std::set<std::string> streamed;
+    directory.walk(
+        pool,
+        [&](const gesa::filesystem::FileDescriptor& descriptor) {
+            std::lock_guard<std::mutex> lock(mutex);
+            streamed.insert(descriptor.relativePath.generic_string());
+        },
+        true,
+        false);
+    EXPECT_EQ(streamed, expected);
+
+    const auto entries = directory.listEntries(pool, true, false);
+    ASSERT_EQ(entries.size(), expected.size());
+    EXPECT_TRUE(std::is_sorted(entries.begin(), entries.end(), [](const auto& left, const auto& right) {
+        return left.relativePath.generic_string() < right.relativePath.generic_string();
+    }));
+    for (const auto& entry : entries) {
+        EXPECT_EQ(entry.size, entry.relativePath.generic_string().size());
+        EXPECT_EQ(entry.lastWriteTime, std::filesystem::last_write_time(entry.absolutePath));
+        EXPECT_EQ(entry.absolutePath, root / entry.relativePath);
+    }
+}
@@ -1,15 +1,22 @@
 #include "compression/huffman.hpp"
+#include "compression/huffman/codec.hpp"
+#include "concurrency/memory_budget.hpp"
+#include "concurrency/thread_pool.hpp"
 
 #include <gtest/gtest.h>
 
 #include <chrono>
+#include <csignal>
 #include <filesystem>
 #include <fstream>
 #include <iterator>
+#include <random>
 #include <set>
 #include <string>
 #include <vector>
 
+#include <sys/resource.h>
+
 namespace {
 
 class ScopedTempDir {
@@ -61,6 +68,30 @@ std::set<std::filesystem::path> collectFiles(const std::filesystem::path& root)
     return files;
 }
 
+// Caps the size of files this process may write and makes going past it fail with
+// EFBIG instead of SIGXFSZ, so archive writes fail the way they would on a full disk.
+class ScopedFileSizeLimit {
+public:
+    explicit ScopedFileSizeLimit(rlim_t bytes)
+    {
+        ::getrlimit(RLIMIT_FSIZE, &previous_);
+        previousHandler_ = std::signal(SIGXFSZ, SIG_IGN);
+        rlimit limit = previous_;
+        limit.rlim_cur = bytes;
+        ::setrlimit(RLIMIT_FSIZE, &limit);
+    }
+
+    ~ScopedFileSizeLimit()
+    {
+        ::setrlimit(RLIMIT_FSIZE, &previous_);
+        std::signal(SIGXFSZ, previousHandler_);
+    }
+
+private:
+    rlimit previous_ {};
+    void (*previousHandler_)(int) {nullptr};
+};
+
 } // namespace
 
 TEST(HuffmanCompressionTest, CompressAndDecompressFile)
@@ -104,3 +135,329 @@ TEST(HuffmanCompressionTest, CompressAndDecompressDirectory)
         EXPECT_EQ(readBinaryFile(source), readBinaryFile(restored));
     }
 }
+
+TEST(HuffmanCompressionTest, StoresIdenticalFilesOnce)
+{
+    ScopedTempDir temp("huffman_dedup");
+    const auto singleDir = temp.path() / "single";
+    const auto duplicatedDir = temp.path() / "duplicated";
+    const auto outputDir = temp.path() / "output";
+    const auto singleArchive = temp.path() / "single.ghar";
+    const auto duplicatedArchive = temp.path() / "duplicated.ghar";
+
+    std::string payload;
+    for (int line = 0; line < 512; ++line) {
+        payload += "line " + std::to_string(line) + " of a vendored library\n";
+    }
+
+    writeBinaryFile(singleDir / "lib.txt", payload);
+    writeBinaryFile(duplicatedDir / "lib.txt", payload);
+    writeBinaryFile(duplicatedDir / "copy" / "lib.txt", payload);
+    writeBinaryFile(duplicatedDir / "other.txt", payload + "!");
+
+    gesa::compression::huffman::compressDirectory(singleDir, singleArchive, 2);
+    gesa::compression::huffman::compressDirectory(duplicatedDir, duplicatedArchive, 2);
+    gesa::compression::huffman::decompressDirectory(duplicatedArchive, outputDir, 2);
+
+    const auto singleSize = std::filesystem::file_size(singleArchive);
+    const auto duplicatedSize = std::filesystem::file_size(duplicatedArchive);
+    EXPECT_LT(duplicatedSize, 2U * singleSize + 64U);
+
+    EXPECT_EQ(collectFiles(duplicatedDir), collectFiles(outputDir));
+    for (const auto& relative : collectFiles(duplicatedDir)) {
+        EXPECT_EQ(readBinaryFile(duplicatedDir / relative), readBinaryFile(outputDir / relative));
+    }
+}
+
+TEST(HuffmanCompressionTest, SolidModeRoundTripsSmallFiles)
+{
+    ScopedTempDir temp("huffman_solid");
+    const auto inputDir = temp.path() / "input";
+    const auto outputDir = temp.path() / "output";
+    const auto archive = temp.path() / "archive.ghar";
+
+    for (int file = 0; file < 24; ++file) {
+        writeBinaryFile(inputDir / ("src" + std::to_string(file % 3)) / ("unit" + std::to_string(file) + ".cpp"),
+                        "int unit" + std::to_string(file) + "() { return " + std::to_string(file * 7) + "; }\n");
+    }
+    writeBinaryFile(inputDir / "copy.cpp", "int unit5() { return 35; }\n");
+    writeBinaryFile(inputDir / "large.bin", std::string(4096, 'L'));
+    writeBinaryFile(inputDir / "empty.txt", "");
+
+    gesa::compression::DirectoryOptions options {};
+    options.threadCount = 2;
+    options.solid = true;
+    options.solidFileThreshold = 1024;
+    options.solidBlockSize = 256;
+
+    gesa::compression::huffman::compressDirectory(inputDir, archive, options);
+    gesa::compression::huffman::decompressDirectory(archive, outputDir, 2);
+
+    const auto originalFiles = collectFiles(inputDir);
+    EXPECT_EQ(originalFiles, collectFiles(outputDir));
+    for (const auto& relative : originalFiles) {
+        EXPECT_EQ(readBinaryFile(inputDir / relative), readBinaryFile(outputDir / relative));
+    }
+}
+
+TEST(HuffmanCompressionTest, UpdateReusesUnchangedEntries)
+{
+    ScopedTempDir temp("huffman_update");
+    const auto inputDir = temp.path() / "input";
+    const auto outputDir = temp.path() / "output";
+    const auto previousArchive = temp.path() / "previous.ghar";
+    const auto updatedArchive = temp.path() / "updated.ghar";
+
+    writeBinaryFile(inputDir / "stable.txt", "stable contents");
+    writeBinaryFile(inputDir / "touched.txt", "original text");
+    writeBinaryFile(inputDir / "nested" / "edited.txt", "before edit");
+    gesa::compression::huffman::compressDirectory(inputDir, previousArchive, 2);
+
+    // Same size and mtime: the previous payload must be reused even though the bytes differ.
+    const auto stableTime = std::filesystem::last_write_time(inputDir / "stable.txt");
+    writeBinaryFile(inputDir / "stable.txt", "STABLE CONTENTS");
+    std::filesystem::last_write_time(inputDir / "stable.txt", stableTime);
+
+    writeBinaryFile(inputDir / "nested" / "edited.txt", "after the edit");
+    writeBinaryFile(inputDir / "added.txt", "new file");
+
+    gesa::compression::DirectoryOptions options {};
+    options.threadCount = 2;
+    options.previousArchive = previousArchive;
+    gesa::compression::huffman::compressDirectory(inputDir, updatedArchive, options);
+    gesa::compression::huffman::decompressDirectory(updatedArchive, outputDir, 2);
+
+    EXPECT_EQ(collectFiles(inputDir), collectFiles(outputDir));
+    EXPECT_EQ(readBinaryFile(outputDir / "stable.txt"), "stable contents");
+    EXPECT_EQ(readBinaryFile(outputDir / "touched.txt"), "original text");
+    EXPECT_EQ(readBinaryFile(outputDir / "nested" / "edited.txt"), "after the edit");
+    EXPECT_EQ(readBinaryFile(outputDir / "added.txt"), "new file");
+}
+
+TEST(HuffmanCompressionTest, UpdateReusesSolidBlocksAndDuplicatesInPlace)
+{
+    ScopedTempDir temp("huffman_update_solid");
+    const auto inputDir = temp.path() / "input";
+    const auto outputDir = temp.path() / "output";
+    const auto archive = temp.path() / "archive.ghar";
+
+    const std::string big(512, 'x');
+    writeBinaryFile(inputDir / "a" / "one.txt", "alpha");
+    writeBinaryFile(inputDir / "a" / "two.txt", "bravo");
+    writeBinaryFile(inputDir / "b" / "three.txt", "charlie");
+    writeBinaryFile(inputDir / "big.txt", big);
+    writeBinaryFile(inputDir / "copy.txt", big);
+
+    gesa::compression::DirectoryOptions options {};
+    options.threadCount = 2;
+    options.solid = true;
+    options.solidFileThreshold = 64;
+    options.solidBlockSize = 10;
+    gesa::compression::huffman::compressDirectory(inputDir, archive, options);
+
+    // Same size and mtime but different bytes: whatever is reused keeps its old contents.
+    const auto rewriteKeepingTime = [&](const std::filesystem::path& path, const std::string& contents) {
+        const auto time = std::filesystem::last_write_time(path);
+        writeBinaryFile(path, contents);
+        std::filesystem::last_write_time(path, time);
+    };
+    rewriteKeepingTime(inputDir / "a" / "one.txt", "ALPHA");
+    rewriteKeepingTime(inputDir / "a" / "two.txt", "BRAVO");
+    rewriteKeepingTime(inputDir / "big.txt", std::string(512, 'y'));
+    rewriteKeepingTime(inputDir / "copy.txt", std::string(512, 'z'));
+    writeBinaryFile(inputDir / "b" / "three.txt", "charlie!");
+
+    // Updating the archive in place copies out of the previous version while replacing it.
+    options.previousArchive = archive;
+    gesa::compression::huffman::compressDirectory(inputDir, archive, options);
+    gesa::compression::huffman::decompressDirectory(archive, outputDir, 2);
+
+    EXPECT_EQ(readBinaryFile(outputDir / "a" / "one.txt"), "alpha");
+    EXPECT_EQ(readBinaryFile(outputDir / "a" / "two.txt"), "bravo");
+    EXPECT_EQ(readBinaryFile(outputDir / "b" / "three.txt"), "charlie!");
+    EXPECT_EQ(readBinaryFile(outputDir / "big.txt"), big);
+    EXPECT_EQ(readBinaryFile(outputDir / "copy.txt"), big);
+
+    const auto summary = gesa::compression::huffman::summarizeArchive(archive);
+    ASSERT_EQ(summary.blocks.size(), 2U);
+    EXPECT_EQ(summary.blocks[0].originalSize, 10U);
+    EXPECT_EQ(summary.blocks[1].originalSize, 8U);
+    std::size_t duplicates = 0;
+    for (const auto& entry : summary.entries) {
+        if (entry.kind == gesa::compression::EntryKind::Duplicate) {
+            ++duplicates;
+            EXPECT_EQ(entry.relativePath, std::filesystem::path("copy.txt"));
+        }
+    }
+    EXPECT_EQ(duplicates, 1U);
+}
+
+TEST(HuffmanCompressionTest, FailedInPlaceUpdateKeepsThePreviousArchive)
+{
+    ScopedTempDir temp("huffman_update_failure");
+    const auto inputDir = temp.path() / "input";
+    const auto outputDir = temp.path() / "output";
+    const auto archive = temp.path() / "archive.ghar";
+
+    writeBinaryFile(inputDir / "a.txt", "alpha alpha alpha");
+    writeBinaryFile(inputDir / "b.txt", "bravo bravo bravo");
+    gesa::compression::huffman::compressDirectory(inputDir, archive, 2);
+    const auto before = readBinaryFile(archive);
+
+    // An incompressible new file makes the updated archive outgrow the size limit.
+    std::mt19937 generator(3U);
+    std::string noise(256U * 1024U, '\0');
+    for (auto& byte : noise) {
+        byte = static_cast<char>(generator() & 0xFFU);
+    }
+    writeBinaryFile(inputDir / "noise.bin", noise);
+
+    gesa::compression::DirectoryOptions options {};
+    options.threadCount = 2;
+    options.previousArchive = archive;
+    {
+        const ScopedFileSizeLimit limit(static_cast<rlim_t>(before.size() + 4096U));
+        EXPECT_THROW(gesa::compression::huffman::compressDirectory(inputDir, archive, options), std::exception);
+    }
+
+    EXPECT_EQ(readBinaryFile(archive), before);
+    EXPECT_EQ(collectFiles(temp.path()), (std::set<std::filesystem::path> {"archive.ghar", "input/a.txt", "input/b.txt",
+                                                                           "input/noise.bin"}));
+    gesa::compression::huffman::decompressDirectory(archive, outputDir, 2);
+    EXPECT_EQ(readBinaryFile(outputDir / "a.txt"), "alpha alpha alpha");
+    EXPECT_EQ(readBinaryFile(outputDir / "b.txt"), "bravo bravo bravo");
+}
+
+TEST(HuffmanCompressionTest, SummarizesArchiveFromHeaders)
+{
+    ScopedTempDir temp("huffman_summary");
+    const auto inputDir = temp.path() / "input";
+    const auto archive = temp.path() / "archive.ghar";
+
+    writeBinaryFile(inputDir / "a.txt", std::string(2048, 'a'));
+    writeBinaryFile(inputDir / "b.txt", std::string(2048, 'a'));
+    writeBinaryFile(inputDir / "small" / "c.txt", "tiny");
+    writeBinaryFile(inputDir / "small" / "d.txt", "also tiny");
+
+    gesa::compression::DirectoryOptions options {};
+    options.threadCount = 2;
+    options.solid = true;
+    options.solidFileThreshold = 64;
+    gesa::compression::huffman::compressDirectory(inputDir, archive, options);
+
+    const auto summary = gesa::compression::huffman::summarizeArchive(archive);
+    EXPECT_EQ(summary.codec, "huffman");
+    EXPECT_EQ(summary.archiveSize, std::filesystem::file_size(archive));
+    ASSERT_EQ(summary.entries.size(), 4U);
+    ASSERT_EQ(summary.blocks.size(), 1U);
+    EXPECT_EQ(summary.blocks[0].originalSize, 13U);
+
+    std::size_t payloads = 0;
+    std::size_t duplicates = 0;
+    std::size_t solids = 0;
+    for (const auto& entry : summary.entries) {
+        switch (entry.kind) {
+        case gesa::compression::EntryKind::Payload:
+            ++payloads;
+            EXPECT_EQ(entry.originalSize, 2048U);
+            EXPECT_GT(entry.compressedSize, 0U);
+            break;
+        case gesa::compression::EntryKind::Duplicate:
+            ++duplicates;
+            EXPECT_EQ(summary.entries[entry.reference].kind, gesa::compression::EntryKind::Payload);
+            break;
+        case gesa::compression::EntryKind::Solid:
+            ++solids;
+            break;
+        }
+    }
+    EXPECT_EQ(payloads, 1U);
+    EXPECT_EQ(duplicates, 1U);
+    EXPECT_EQ(solids, 2U);
+}
+
+TEST(HuffmanCompressionTest, StoresIncompressibleFilesVerbatim)
+{
+    ScopedTempDir temp("huffman_stored");
+    const auto inputDir = temp.path() / "input";
+    const auto archive = temp.path() / "archive.ghar";
+    const auto outputDir = temp.path() / "output";
+
+    std::mt19937 generator(42U);
+    std::string noise(200000, '\0');
+    for (auto& byte : noise) {
+        byte = static_cast<char>(generator() & 0xFFU);
+    }
+    writeBinaryFile(inputDir / "noise.bin", noise);
+    writeBinaryFile(inputDir / "text.txt", std::string(8192, 'x'));
+
+    gesa::compression::DirectoryOptions options {};
+    options.threadCount = 2;
+    gesa::compression::huffman::compressDirectory(inputDir, archive, options);
+
+    const auto summary = gesa::compression::huffman::summarizeArchive(archive);
+    ASSERT_EQ(summary.entries.size(), 2U);
+    for (const auto& entry : summary.entries) {
+        if (entry.relativePath == "noise.bin") {
+            EXPECT_EQ(entry.codec, gesa::compression::CodecId::Stored);
+            EXPECT_EQ(entry.compressedSize, entry.originalSize);
+        } else {
+            EXPECT_EQ(entry.codec, gesa::compression::CodecId::Huffman);
+            EXPECT_LT(entry.compressedSize, entry.originalSize);
+        }
+    }
+
+    gesa::compression::huffman::decompressDirectory(archive, outputDir);
+    EXPECT_EQ(readBinaryFile(outputDir / "noise.bin"), noise);
+    EXPECT_EQ(readBinaryFile(outputDir / "text.txt"), std::string(8192, 'x'));
+}
+
+TEST(HuffmanCompressionTest, ParallelEncoderMatchesSerialBitstream)
+{
+    std::mt19937 generator(7U);
+    std::geometric_distribution<int> skewed(0.08);
+    std::vector<std::uint8_t> input(100003);
+    for (auto& byte : input) {
+        byte = static_cast<std::uint8_t>(skewed(generator) & 0xFF);
+    }
+
+    gesa::concurrency::ThreadPool pool(3);
+    const auto serial = gesa::compression::huffman::encodeBuffer(input);
+    for (const std::size_t blockSize : {997U, 4096U, 1U << 20U}) {
+        const auto parallel = gesa::compression::huffman::ParallelEncoder(input, pool, blockSize).finish();
+        EXPECT_EQ(parallel.metadata.frequencies, serial.metadata.frequencies);
+        EXPECT_EQ(parallel.metadata.originalSize, serial.metadata.originalSize);
+        EXPECT_EQ(parallel.compressed, serial.compressed) << blockSize;
+    }
+}
+
+TEST(HuffmanCompressionTest, SplitsLargeFilesAcrossThePool)
+{
+    ScopedTempDir temp("huffman_split");
+    const auto inputDir = temp.path() / "input";
+    const auto archive = temp.path() / "archive.ghar";
+    const auto outputDir = temp.path() / "output";
+
+    std::string large;
+    large.reserve(2U * gesa::compression::huffman::kParallelBlockSize + 4096U);
+    while (large.size() < 2U * gesa::compression::huffman::kParallelBlockSize + 4096U) {
+        large += "line " + std::to_string(large.size() % 9973U) + " of a large log file\n";
+    }
+    writeBinaryFile(inputDir / "large.log", large);
+    for (int index = 0; index < 100; ++index) {
+        writeBinaryFile(inputDir / "small" / (std::to_string(index) + ".txt"), std::string(100U + index, 'a' + index % 26));
+    }
+
+    // Far below the working set: jobs are admitted a few at a time and the large file alone.
+    gesa::concurrency::MemoryBudget budget(16U * 1024U);
+    gesa::compression::DirectoryOptions options {};
+    options.threadCount = 4;
+    options.memoryBudget = &budget;
+    gesa::compression::huffman::compressDirectory(inputDir, archive, options);
+    gesa::compression::huffman::decompressDirectory(archive, outputDir);
+    EXPECT_EQ(budget.inUse(), 0U);
+
+    EXPECT_EQ(collectFiles(outputDir), collectFiles(inputDir));
+    EXPECT_EQ(readBinaryFile(outputDir / "large.log"), large);
+    EXPECT_EQ(readBinaryFile(outputDir / "small" / "42.txt"), std::string(142U, 'a' + 42 % 26));
+}
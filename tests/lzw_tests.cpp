@@ -1,4 +1,5 @@
 #include "compression/lzw.hpp"
+#include "concurrency/memory_budget.hpp"
 
 #include <gtest/gtest.h>
 
@@ -6,6 +7,7 @@
 #include <filesystem>
 #include <fstream>
 #include <iterator>
+#include <random>
 #include <set>
 #include <string>
 
@@ -103,3 +105,279 @@ TEST(LZWCompressionTest, CompressAndDecompressDirectory)
         EXPECT_EQ(readBinaryFile(source), readBinaryFile(restored));
     }
 }
+
+TEST(LZWCompressionTest, StoresIdenticalFilesOnce)
+{
+    ScopedTempDir temp("lzw_dedup");
+    const auto singleDir = temp.path() / "single";
+    const auto duplicatedDir = temp.path() / "duplicated";
+    const auto outputDir = temp.path() / "output";
+    const auto singleArchive = temp.path() / "single.glza";
+    const auto duplicatedArchive = temp.path() / "duplicated.glza";
+
+    std::string payload;
+    for (int line = 0; line < 512; ++line) {
+        payload += "line " + std::to_string(line) + " of a vendored library\n";
+    }
+
+    writeBinaryFile(singleDir / "lib.txt", payload);
+    writeBinaryFile(duplicatedDir / "lib.txt", payload);
+    writeBinaryFile(duplicatedDir / "copy" / "lib.txt", payload);
+    writeBinaryFile(duplicatedDir / "other.txt", payload + "!");
+
+    gesa::compression::lzw::compressDirectory(singleDir, singleArchive, 2);
+    gesa::compression::lzw::compressDirectory(duplicatedDir, duplicatedArchive, 2);
+    gesa::compression::lzw::decompressDirectory(duplicatedArchive, outputDir, 2);
+
+    const auto singleSize = std::filesystem::file_size(singleArchive);
+    const auto duplicatedSize = std::filesystem::file_size(duplicatedArchive);
+    EXPECT_LT(duplicatedSize, 2U * singleSize + 64U);
+
+    EXPECT_EQ(collectFiles(duplicatedDir), collectFiles(outputDir));
+    for (const auto& relative : collectFiles(duplicatedDir)) {
+        EXPECT_EQ(readBinaryFile(duplicatedDir / relative), readBinaryFile(outputDir / relative));
+    }
+}
+
+TEST(LZWCompressionTest, SolidModeRoundTripsSmallFiles)
+{
+    ScopedTempDir temp("lzw_solid");
+    const auto inputDir = temp.path() / "input";
+    const auto outputDir = temp.path() / "output";
+    const auto archive = temp.path() / "archive.glza";
+
+    for (int file = 0; file < 24; ++file) {
+        writeBinaryFile(inputDir / ("src" + std::to_string(file % 3)) / ("unit" + std::to_string(file) + ".cpp"),
+                        "int unit" + std::to_string(file) + "() { return " + std::to_string(file * 7) + "; }\n");
+    }
+    writeBinaryFile(inputDir / "copy.cpp", "int unit5() { return 35; }\n");
+    writeBinaryFile(inputDir / "large.bin", std::string(4096, 'L'));
+    writeBinaryFile(inputDir / "empty.txt", "");
+
+    gesa::compression::DirectoryOptions options {};
+    options.threadCount = 2;
+    options.solid = true;
+    options.solidFileThreshold = 1024;
+    options.solidBlockSize = 256;
+
+    gesa::compression::lzw::compressDirectory(inputDir, archive, options);
+    gesa::compression::lzw::decompressDirectory(archive, outputDir, 2);
+
+    const auto originalFiles = collectFiles(inputDir);
+    EXPECT_EQ(originalFiles, collectFiles(outputDir));
+    for (const auto& relative : originalFiles) {
+        EXPECT_EQ(readBinaryFile(inputDir / relative), readBinaryFile(outputDir / relative));
+    }
+}
+
+TEST(LZWCompressionTest, UpdateReusesUnchangedEntries)
+{
+    ScopedTempDir temp("lzw_update");
+    const auto inputDir = temp.path() / "input";
+    const auto outputDir = temp.path() / "output";
+    const auto previousArchive = temp.path() / "previous.glza";
+    const auto updatedArchive = temp.path() / "updated.glza";
+
+    writeBinaryFile(inputDir / "stable.txt", "stable contents");
+    writeBinaryFile(inputDir / "touched.txt", "original text");
+    writeBinaryFile(inputDir / "nested" / "edited.txt", "before edit");
+    gesa::compression::lzw::compressDirectory(inputDir, previousArchive, 2);
+
+    // Same size and mtime: the previous payload must be reused even though the bytes differ.
+    const auto stableTime = std::filesystem::last_write_time(inputDir / "stable.txt");
+    writeBinaryFile(inputDir / "stable.txt", "STABLE CONTENTS");
+    std::filesystem::last_write_time(inputDir / "stable.txt", stableTime);
+
+    writeBinaryFile(inputDir / "nested" / "edited.txt", "after the edit");
+    writeBinaryFile(inputDir / "added.txt", "new file");
+
+    gesa::compression::DirectoryOptions options {};
+    options.threadCount = 2;
+    options.previousArchive = previousArchive;
+    gesa::compression::lzw::compressDirectory(inputDir, updatedArchive, options);
+    gesa::compression::lzw::decompressDirectory(updatedArchive, outputDir, 2);
+
+    EXPECT_EQ(collectFiles(inputDir), collectFiles(outputDir));
+    EXPECT_EQ(readBinaryFile(outputDir / "stable.txt"), "stable contents");
+    EXPECT_EQ(readBinaryFile(outputDir / "touched.txt"), "original text");
+    EXPECT_EQ(readBinaryFile(outputDir / "nested" / "edited.txt"), "after the edit");
+    EXPECT_EQ(readBinaryFile(outputDir / "added.txt"), "new file");
+}
+
+TEST(LZWCompressionTest, UpdateReusesSolidBlocksAndDuplicatesInPlace)
+{
+    ScopedTempDir temp("lzw_update_solid");
+    const auto inputDir = temp.path() / "input";
+    const auto outputDir = temp.path() / "output";
+    const auto archive = temp.path() / "archive.glza";
+
+    const std::string big(512, 'x');
+    writeBinaryFile(inputDir / "a" / "one.txt", "alpha");
+    writeBinaryFile(inputDir / "a" / "two.txt", "bravo");
+    writeBinaryFile(inputDir / "b" / "three.txt", "charlie");
+    writeBinaryFile(inputDir / "big.txt", big);
+    writeBinaryFile(inputDir / "copy.txt", big);
+
+    gesa::compression::DirectoryOptions options {};
+    options.threadCount = 2;
+    options.solid = true;
+    options.solidFileThreshold = 64;
+    options.solidBlockSize = 10;
+    gesa::compression::lzw::compressDirectory(inputDir, archive, options);
+
+    // Same size and mtime but different bytes: whatever is reused keeps its old contents.
+    const auto rewriteKeepingTime = [&](const std::filesystem::path& path, const std::string& contents) {
+        const auto time = std::filesystem::last_write_time(path);
+        writeBinaryFile(path, contents);
+        std::filesystem::last_write_time(path, time);
+    };
+    rewriteKeepingTime(inputDir / "a" / "one.txt", "ALPHA");
+    rewriteKeepingTime(inputDir / "a" / "two.txt", "BRAVO");
+    rewriteKeepingTime(inputDir / "big.txt", std::string(512, 'y'));
+    rewriteKeepingTime(inputDir / "copy.txt", std::string(512, 'z'));
+    writeBinaryFile(inputDir / "b" / "three.txt", "charlie!");
+
+    // Updating the archive in place copies out of the previous version while replacing it.
+    options.previousArchive = archive;
+    gesa::compression::lzw::compressDirectory(inputDir, archive, options);
+    gesa::compression::lzw::decompressDirectory(archive, outputDir, 2);
+
+    EXPECT_EQ(readBinaryFile(outputDir / "a" / "one.txt"), "alpha");
+    EXPECT_EQ(readBinaryFile(outputDir / "a" / "two.txt"), "bravo");
+    EXPECT_EQ(readBinaryFile(outputDir / "b" / "three.txt"), "charlie!");
+    EXPECT_EQ(readBinaryFile(outputDir / "big.txt"), big);
+    EXPECT_EQ(readBinaryFile(outputDir / "copy.txt"), big);
+
+    const auto summary = gesa::compression::lzw::summarizeArchive(archive);
+    ASSERT_EQ(summary.blocks.size(), 2U);
+    EXPECT_EQ(summary.blocks[0].originalSize, 10U);
+    EXPECT_EQ(summary.blocks[1].originalSize, 8U);
+    std::size_t duplicates = 0;
+    for (const auto& entry : summary.entries) {
+        if (entry.kind == gesa::compression::EntryKind::Duplicate) {
+            ++duplicates;
+            EXPECT_EQ(entry.relativePath, std::filesystem::path("copy.txt"));
+        }
+    }
+    EXPECT_EQ(duplicates, 1U);
+}
+
+TEST(LZWCompressionTest, SummarizesArchiveFromHeaders)
+{
+    ScopedTempDir temp("lzw_summary");
+    const auto inputDir = temp.path() / "input";
+    const auto archive = temp.path() / "archive.glza";
+
+    writeBinaryFile(inputDir / "a.txt", std::string(2048, 'a'));
+    writeBinaryFile(inputDir / "b.txt", std::string(2048, 'a'));
+    writeBinaryFile(inputDir / "small" / "c.txt", "tiny");
+    writeBinaryFile(inputDir / "small" / "d.txt", "also tiny");
+
+    gesa::compression::DirectoryOptions options {};
+    options.threadCount = 2;
+    options.solid = true;
+    options.solidFileThreshold = 64;
+    gesa::compression::lzw::compressDirectory(inputDir, archive, options);
+
+    const auto summary = gesa::compression::lzw::summarizeArchive(archive);
+    EXPECT_EQ(summary.codec, "lzw");
+    EXPECT_EQ(summary.archiveSize, std::filesystem::file_size(archive));
+    ASSERT_EQ(summary.entries.size(), 4U);
+    ASSERT_EQ(summary.blocks.size(), 1U);
+    EXPECT_EQ(summary.blocks[0].originalSize, 13U);
+
+    std::size_t payloads = 0;
+    std::size_t duplicates = 0;
+    std::size_t solids = 0;
+    for (const auto& entry : summary.entries) {
+        switch (entry.kind) {
+        case gesa::compression::EntryKind::Payload:
+            ++payloads;
+            EXPECT_EQ(entry.originalSize, 2048U);
+            EXPECT_GT(entry.compressedSize, 0U);
+            break;
+        case gesa::compression::EntryKind::Duplicate:
+            ++duplicates;
+            EXPECT_EQ(summary.entries[entry.reference].kind, gesa::compression::EntryKind::Payload);
+            break;
+        case gesa::compression::EntryKind::Solid:
+            ++solids;
+            break;
+        }
+    }
+    EXPECT_EQ(payloads, 1U);
+    EXPECT_EQ(duplicates, 1U);
+    EXPECT_EQ(solids, 2U);
+}
+
+TEST(LZWCompressionTest, StoresIncompressibleFilesVerbatim)
+{
+    ScopedTempDir temp("lzw_stored");
+    const auto inputDir = temp.path() / "input";
+    const auto archive = temp.path() / "archive.glza";
+    const auto outputDir = temp.path() / "output";
+
+    std::mt19937 generator(42U);
+    std::string noise(200000, '\0');
+    for (auto& byte : noise) {
+        byte = static_cast<char>(generator() & 0xFFU);
+    }
+    writeBinaryFile(inputDir / "noise.bin", noise);
+    writeBinaryFile(inputDir / "text.txt", std::string(8192, 'x'));
+
+    gesa::compression::DirectoryOptions options {};
+    options.threadCount = 2;
+    gesa::compression::lzw::compressDirectory(inputDir, archive, options);
+
+    const auto summary = gesa::compression::lzw::summarizeArchive(archive);
+    ASSERT_EQ(summary.entries.size(), 2U);
+    for (const auto& entry : summary.entries) {
+        if (entry.relativePath == "noise.bin") {
+            EXPECT_EQ(entry.codec, gesa::compression::CodecId::Stored);
+            EXPECT_EQ(entry.compressedSize, entry.originalSize);
+        } else {
+            EXPECT_EQ(entry.codec, gesa::compression::CodecId::LZW);
+            EXPECT_LT(entry.compressedSize, entry.originalSize);
+        }
+    }
+
+    gesa::compression::lzw::decompressDirectory(archive, outputDir);
+    EXPECT_EQ(readBinaryFile(outputDir / "noise.bin"), noise);
+    EXPECT_EQ(readBinaryFile(outputDir / "text.txt"), std::string(8192, 'x'));
+}
+
+TEST(LZWCompressionTest, MovesFinishedPayloadsOutOfMemoryWhenTheBudgetRunsOut)
+{
+    ScopedTempDir temp("lzw_budget");
+    const auto inputDir = temp.path() / "input";
+    const auto archiveDir = temp.path() / "archive";
+    const auto archive = archiveDir / "archive.glza";
+    const auto outputDir = temp.path() / "output";
+    std::filesystem::create_directories(archiveDir);
+
+    std::mt19937 generator(7);
+    std::uniform_int_distribution<int> letter('a', 'h');
+    for (int index = 0; index < 64; ++index) {
+        std::string content;
+        while (content.size() < 6000U) {
+            content += std::string(4U, static_cast<char>(letter(generator))) + std::to_string(index);
+        }
+        writeBinaryFile(inputDir / (std::to_string(index) + ".txt"), content);
+    }
+
+    // The finished outputs alone outgrow the budget, so they cannot all stay in memory.
+    gesa::concurrency::MemoryBudget budget(32U * 1024U);
+    gesa::compression::DirectoryOptions options {};
+    options.threadCount = 2;
+    options.memoryBudget = &budget;
+    gesa::compression::lzw::compressDirectory(inputDir, archive, options);
+    EXPECT_EQ(budget.inUse(), 0U);
+    EXPECT_EQ(collectFiles(archiveDir), (std::set<std::filesystem::path> {"archive.glza"}));
+
+    gesa::compression::lzw::decompressDirectory(archive, outputDir);
+    EXPECT_EQ(collectFiles(outputDir), collectFiles(inputDir));
+    for (int index = 0; index < 64; index += 9) {
+        const auto name = std::to_string(index) + ".txt";
+        EXPECT_EQ(readBinaryFile(outputDir / name), readBinaryFile(inputDir / name)) << name;
+    }
+}
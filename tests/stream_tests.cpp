@@ -0,0 +1,105 @@
+#include "compression/stream.hpp"
+#include "utils/frame_stream.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+void runThrough(gesa::utils::ByteSink& sink, const std::string& input, std::size_t pieceSize)
+{
+    for (std::size_t offset = 0; offset < input.size(); offset += pieceSize) {
+        const auto length = std::min(pieceSize, input.size() - offset);
+        sink.write(gesa::utils::ByteView(reinterpret_cast<const std::uint8_t*>(input.data()) + offset, length));
+    }
+    sink.finish();
+}
+
+} // namespace
+
+TEST(StreamTest, FramedCodecsRoundTripArbitraryWriteSizes)
+{
+    std::mt19937 generator(11U);
+    std::string input;
+    while (input.size() < 50000U) {
+        input += (generator() % 4U == 0U) ? std::string(1, static_cast<char>(generator() & 0xFFU)) : "stream text ";
+    }
+
+    for (const auto codec : {gesa::compression::StreamCodec::Huffman, gesa::compression::StreamCodec::LZW}) {
+        std::ostringstream framed;
+        gesa::utils::OstreamSink framedSink(framed);
+        auto compressor = gesa::compression::makeCompressingSink(codec, framedSink, 4096U);
+        runThrough(*compressor, input, 1000U);
+        EXPECT_LT(framed.str().size(), input.size());
+
+        std::ostringstream restored;
+        gesa::utils::OstreamSink restoredSink(restored);
+        auto decompressor = gesa::compression::makeDecompressingSink(codec, restoredSink);
+        runThrough(*decompressor, framed.str(), 7U);
+        EXPECT_EQ(restored.str(), input);
+
+        std::ostringstream truncated;
+        gesa::utils::OstreamSink truncatedSink(truncated);
+        auto partial = gesa::compression::makeDecompressingSink(codec, truncatedSink);
+        EXPECT_THROW(runThrough(*partial, framed.str().substr(0, framed.str().size() - 2U), 64U), std::runtime_error);
+    }
+}
+
+TEST(StreamTest, EncoderEmitsFramesBeforeInputEnds)
+{
+    std::ostringstream framed;
+    gesa::utils::OstreamSink sink(framed);
+    gesa::utils::FrameEncoder encoder(
+        {'T', 'E', 'S', 'T'}, [](gesa::utils::ByteView chunk) { return chunk.copy(); }, sink, 16U);
+
+    const std::string first(20, 'a');
+    encoder.write(gesa::utils::ByteView(reinterpret_cast<const std::uint8_t*>(first.data()), first.size()));
+    EXPECT_EQ(framed.str().size(), 4U + 1U + 4U + 16U);
+
+    encoder.finish();
+    EXPECT_EQ(framed.str().size(), 4U + 1U + 2U * 4U + 16U + 4U + 4U);
+}
+
+TEST(StreamTest, DecoderRejectsOversizedFramesFromTheirLength)
+{
+    std::ostringstream framed;
+    gesa::utils::OstreamSink framedSink(framed);
+    auto compressor = gesa::compression::makeCompressingSink(gesa::compression::StreamCodec::Huffman, framedSink);
+    compressor->finish();
+    // Keep only the magic and version, then announce a frame of almost 4 GiB.
+    auto stream = framed.str().substr(0, 5U);
+    stream += std::string("\xFF\xFF\xFF\xFF", 4);
+
+    std::ostringstream restored;
+    gesa::utils::OstreamSink restoredSink(restored);
+    auto decompressor = gesa::compression::makeDecompressingSink(gesa::compression::StreamCodec::Huffman, restoredSink);
+    EXPECT_THROW(decompressor->write(gesa::utils::ByteView(reinterpret_cast<const std::uint8_t*>(stream.data()), stream.size())),
+                 std::runtime_error);
+}
+
+TEST(StreamTest, EncoderCapsChunksSoDecodersCanBoundFrames)
+{
+    std::ostringstream framed;
+    gesa::utils::OstreamSink framedSink(framed);
+    auto compressor = gesa::compression::makeCompressingSink(gesa::compression::StreamCodec::LZW, framedSink,
+                                                             4U * gesa::utils::kStreamChunkSize);
+    std::mt19937 generator(5U);
+    std::string input(2U * gesa::utils::kStreamChunkSize + 10U, '\0');
+    for (auto& byte : input) {
+        byte = static_cast<char>(generator() & 0xFFU);
+    }
+    runThrough(*compressor, input, input.size());
+
+    std::ostringstream restored;
+    gesa::utils::OstreamSink restoredSink(restored);
+    auto decompressor = gesa::compression::makeDecompressingSink(gesa::compression::StreamCodec::LZW, restoredSink);
+    runThrough(*decompressor, framed.str(), 65536U);
+    EXPECT_EQ(restored.str(), input);
+}
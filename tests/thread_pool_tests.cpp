@@ -1,10 +1,22 @@
+#include "concurrency/async.hpp"
+#include "concurrency/cancellation.hpp"
+#include "concurrency/memory_budget.hpp"
+#include "concurrency/pool_statistics.hpp"
+#include "concurrency/shared_pool.hpp"
 #include "concurrency/thread_pool.hpp"
+#include "concurrency/topology.hpp"
 
 #include <gtest/gtest.h>
 
+#include <atomic>
 #include <chrono>
+#include <filesystem>
+#include <fstream>
 #include <future>
+#include <memory>
+#include <numeric>
 #include <stdexcept>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -12,6 +24,15 @@ namespace {
 
 using gesa::concurrency::ThreadPool;
 
+// Runs every posted job on the spot, so a chain settles before the call returns.
+struct InlineScheduler {
+    template <class Callable>
+    void post(Callable&& callable)
+    {
+        callable();
+    }
+};
+
 TEST(ThreadPoolTest, ExecutesMultipleTasks)
 {
     ThreadPool pool(4);
@@ -46,4 +67,352 @@ TEST(ThreadPoolTest, HonorsThreadCount)
     EXPECT_EQ(pool.size(), static_cast<std::size_t>(3));
 }
 
+TEST(ThreadPoolTest, RunsTasksSubmittedFromWorkers)
+{
+    ThreadPool pool(4);
+    std::atomic<int> counter {0};
+
+    std::vector<std::future<std::vector<std::future<void>>>> parents;
+    for (int parent = 0; parent < 16; ++parent) {
+        parents.emplace_back(pool.enqueue([&pool, &counter]() {
+            std::vector<std::future<void>> children;
+            for (int child = 0; child < 500; ++child) {
+                children.emplace_back(pool.enqueue([&counter]() { counter.fetch_add(1); }));
+            }
+            return children;
+        }));
+    }
+
+    for (auto& parent : parents) {
+        for (auto& child : parent.get()) {
+            child.get();
+        }
+    }
+    EXPECT_EQ(counter.load(), 16 * 500);
+}
+
+TEST(ThreadPoolTest, PostsMoveOnlyTasksWithoutFutures)
+{
+    std::atomic<int> counter {0};
+    {
+        ThreadPool pool(3);
+        for (int i = 0; i < 1000; ++i) {
+            pool.post([&counter, value = std::make_unique<int>(i)]() { counter.fetch_add(*value >= 0 ? 1 : 0); });
+        }
+        auto moveOnly = pool.enqueue([value = std::make_unique<int>(6)](int factor) { return *value * factor; }, 7);
+        EXPECT_EQ(moveOnly.get(), 42);
+    }
+    EXPECT_EQ(counter.load(), 1000);
+}
+
+TEST(ThreadPoolTest, ParallelForVisitsEveryIndexOnce)
+{
+    ThreadPool pool(4);
+
+    for (const std::size_t grain : {std::size_t {0}, std::size_t {1}, std::size_t {7}, std::size_t {5000}}) {
+        std::vector<std::atomic<int>> visits(1000);
+        pool.parallelFor(0, visits.size(), grain, [&](std::size_t index) { visits[index].fetch_add(1); });
+        for (const auto& count : visits) {
+            ASSERT_EQ(count.load(), 1);
+        }
+    }
+
+    auto nested = pool.enqueue([&pool]() {
+        std::vector<int> inputs(100);
+        std::iota(inputs.begin(), inputs.end(), 0);
+        return pool.parallelTransform(inputs, 3, [](int value) { return value * 2; });
+    });
+    const auto doubled = nested.get();
+    ASSERT_EQ(doubled.size(), 100U);
+    for (int value = 0; value < 100; ++value) {
+        EXPECT_EQ(doubled[static_cast<std::size_t>(value)], value * 2);
+    }
+
+    EXPECT_THROW(pool.parallelFor(0, 64, 1, [](std::size_t index) {
+        if (index == 17) {
+            throw std::runtime_error("chunk failed");
+        }
+    }), std::runtime_error);
+}
+
+TEST(ThreadPoolTest, DeliversCompletionsInFinishingOrder)
+{
+    gesa::concurrency::ThreadPool pool(2);
+    gesa::concurrency::CompletionQueue completions;
+    std::promise<void> release;
+    auto released = release.get_future().share();
+
+    pool.submitTo(completions, 0, [released]() { released.wait(); });
+    pool.submitTo(completions, 1, []() { throw std::runtime_error("bad entry"); });
+
+    const auto first = completions.next();
+    ASSERT_TRUE(first.has_value());
+    EXPECT_EQ(first->key, 1U);
+    EXPECT_THROW(first->rethrow(), std::runtime_error);
+    EXPECT_FALSE(completions.tryNext().has_value());
+
+    release.set_value();
+    const auto second = completions.next();
+    ASSERT_TRUE(second.has_value());
+    EXPECT_EQ(second->key, 0U);
+    EXPECT_NO_THROW(second->rethrow());
+    EXPECT_FALSE(completions.next().has_value());
+    EXPECT_EQ(completions.outstanding(), 0U);
+}
+
+TEST(AsyncTest, ChainsStagesWithoutBlockingAndLimitsStageConcurrency)
+{
+    gesa::concurrency::ThreadPool pool(4);
+    gesa::concurrency::Stage narrow(pool, 2);
+    std::atomic<int> running {0};
+    std::atomic<int> peak {0};
+
+    std::vector<gesa::concurrency::Async<int>> files;
+    for (int file = 0; file < 8; ++file) {
+        files.push_back(gesa::concurrency::async(pool, [file]() { return file; })
+                            .then(narrow, [&](int value) {
+                                const auto now = running.fetch_add(1) + 1;
+                                auto seen = peak.load();
+                                while (seen < now && !peak.compare_exchange_weak(seen, now)) {
+                                }
+                                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                                running.fetch_sub(1);
+                                return value * 10;
+                            })
+                            .then(pool, [&pool](int value) {
+                                return gesa::concurrency::async(pool, [value]() { return value + 1; });
+                            }));
+    }
+    const auto results = gesa::concurrency::whenAll(std::move(files)).get();
+    EXPECT_EQ(results, (std::vector<int> {1, 11, 21, 31, 41, 51, 61, 71}));
+    EXPECT_GE(peak.load(), 1);
+    EXPECT_LE(peak.load(), 2);
+
+    std::atomic<bool> skipped {true};
+    auto failed = gesa::concurrency::async(pool, []() -> int { throw std::runtime_error("read failed"); })
+                      .then(pool, [&skipped](int) { skipped.store(false); });
+    EXPECT_THROW(failed.get(), std::runtime_error);
+    EXPECT_TRUE(skipped.load());
+}
+
+TEST(AsyncTest, InputsThatNeverCompleteAreReleased)
+{
+    using gesa::concurrency::detail::AsyncAccess;
+    using gesa::concurrency::detail::AsyncState;
+    InlineScheduler inlineScheduler;
+
+    std::weak_ptr<AsyncState<int>> flattened;
+    std::weak_ptr<AsyncState<int>> joined;
+    {
+        auto inner = std::make_shared<AsyncState<int>>();
+        flattened = inner;
+        auto outer = gesa::concurrency::async(inlineScheduler, [inner]() { return AsyncAccess::adopt(inner); });
+
+        auto input = std::make_shared<AsyncState<int>>();
+        joined = input;
+        std::vector<gesa::concurrency::Async<int>> inputs;
+        inputs.push_back(AsyncAccess::adopt(input));
+        inputs.push_back(gesa::concurrency::Async<int>::ready(1));
+        auto all = gesa::concurrency::whenAll(std::move(inputs));
+    }
+    EXPECT_TRUE(flattened.expired());
+    EXPECT_TRUE(joined.expired());
+}
+
+TEST(ThreadPoolTest, ReportsQueueWaitRunTimeAndUtilization)
+{
+    EXPECT_EQ(gesa::concurrency::Histogram::bucketOf(0), 0U);
+    EXPECT_EQ(gesa::concurrency::Histogram::bucketOf(1), 1U);
+    EXPECT_EQ(gesa::concurrency::Histogram::bucketOf(1023), 10U);
+    EXPECT_EQ(gesa::concurrency::Histogram::bucketOf(1024), 11U);
+
+    gesa::concurrency::ThreadPool pool(2);
+    std::vector<std::future<void>> futures;
+    for (int index = 0; index < 20; ++index) {
+        futures.push_back(pool.enqueue([]() { std::this_thread::sleep_for(std::chrono::milliseconds(1)); }));
+    }
+    for (auto& future : futures) {
+        future.get();
+    }
+
+    // A worker records a task just after completing its future.
+    auto statistics = pool.statistics();
+    for (int attempt = 0; attempt < 100 && statistics.tasks() < 20U; ++attempt) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        statistics = pool.statistics();
+    }
+
+    EXPECT_EQ(statistics.tasks(), 20U);
+    ASSERT_EQ(statistics.workers.size(), 2U);
+    EXPECT_EQ(statistics.queueWait.count(), 20U);
+    EXPECT_EQ(statistics.queueDepth.count(), 20U);
+    EXPECT_GE(statistics.runTime.quantile(0.5), 1000000U);
+    EXPECT_GE(statistics.runTime.sum(), 20000000U);
+    EXPECT_GT(statistics.utilization(), 0.0);
+    EXPECT_LE(statistics.utilization(), 1.0);
+    for (const auto& worker : statistics.workers) {
+        EXPECT_EQ((worker.busy + worker.idle).count(), statistics.uptime.count());
+    }
+}
+
+TEST(SharedPoolTest, LeasesTheSharedPoolUnlessAThreadCountIsGiven)
+{
+    auto& shared = gesa::concurrency::sharedPool();
+    EXPECT_EQ(&gesa::concurrency::sharedPool(), &shared);
+    EXPECT_EQ(gesa::concurrency::sharedPoolSize(), shared.size());
+
+    const gesa::concurrency::PoolLease sharedLease(0);
+    EXPECT_EQ(&sharedLease.get(), &shared);
+
+    const gesa::concurrency::PoolLease privateLease(2);
+    EXPECT_NE(&privateLease.get(), &shared);
+    EXPECT_EQ(privateLease.get().size(), 2U);
+
+    EXPECT_NO_THROW(gesa::concurrency::configureSharedPool(shared.size()));
+    EXPECT_THROW(gesa::concurrency::configureSharedPool(shared.size() + 1U), std::logic_error);
+}
+
+TEST(MemoryBudgetTest, AdmitsReservationsWithinCapacity)
+{
+    EXPECT_EQ(gesa::concurrency::parseByteSize("512"), 512U);
+    EXPECT_EQ(gesa::concurrency::parseByteSize("4K"), 4096U);
+    EXPECT_EQ(gesa::concurrency::parseByteSize("3GB"), 3ULL << 30U);
+    EXPECT_THROW(gesa::concurrency::parseByteSize("12Q"), std::invalid_argument);
+
+    gesa::concurrency::MemoryBudget budget(100);
+    auto first = budget.reserve(60);
+    EXPECT_FALSE(budget.tryReserve(50).has_value());
+
+    std::atomic<bool> admitted {false};
+    std::thread waiter([&]() {
+        const auto oversized = budget.reserve(1000);
+        EXPECT_EQ(oversized.bytes(), 100U);
+        admitted.store(true);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(admitted.load());
+
+    first.release();
+    waiter.join();
+    EXPECT_TRUE(admitted.load());
+    EXPECT_EQ(budget.inUse(), 0U);
+
+    // Shrinking returns only the excess and never grows the reservation.
+    auto job = budget.reserve(80);
+    job.shrinkTo(30);
+    EXPECT_EQ(job.bytes(), 30U);
+    EXPECT_EQ(budget.inUse(), 30U);
+    job.shrinkTo(50);
+    EXPECT_EQ(budget.inUse(), 30U);
+    EXPECT_TRUE(budget.tryReserve(70).has_value());
+    job.release();
+    EXPECT_EQ(budget.inUse(), 0U);
+}
+
+TEST(CancellationTokenTest, FirstFailureSkipsTheRestOfTheBatch)
+{
+    gesa::concurrency::CancellationToken token;
+    EXPECT_TRUE(token.run("a.txt", []() {}));
+    EXPECT_FALSE(token.run("b.txt", []() { throw std::runtime_error("disk full"); }));
+    EXPECT_FALSE(token.run("d.txt", []() { throw std::logic_error("never reported"); }));
+    EXPECT_FALSE(token.run("c.txt", [&token]() { token.throwIfCancelled(); }));
+    EXPECT_TRUE(token.cancelled());
+
+    try {
+        token.rethrowIfFailed();
+        FAIL() << "Expected BatchFailure";
+    } catch (const gesa::concurrency::BatchFailure& failure) {
+        EXPECT_EQ(failure.job(), "b.txt");
+        EXPECT_EQ(failure.skipped(), (std::vector<std::string> {"c.txt", "d.txt"}));
+        EXPECT_STREQ(failure.what(), "b.txt: disk full (2 skipped: c.txt, d.txt)");
+    }
+
+    gesa::concurrency::CancellationToken cancelled;
+    cancelled.cancel();
+    EXPECT_THROW(cancelled.rethrowIfFailed(), gesa::concurrency::OperationCancelled);
+}
+
+TEST(TopologyTest, ReadsNodesAndPlansCompactAndScatterPlacement)
+{
+    EXPECT_EQ(gesa::concurrency::parseCpuList("0-2,5,7-8\n"), (std::vector<unsigned> {0, 1, 2, 5, 7, 8}));
+    EXPECT_THROW(gesa::concurrency::parseCpuList("3-1"), std::invalid_argument);
+
+    const auto root = std::filesystem::temp_directory_path() /
+        ("topology_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    std::filesystem::create_directories(root / "node1");
+    std::filesystem::create_directories(root / "node0");
+    std::filesystem::create_directories(root / "power");
+    std::ofstream(root / "node0" / "cpulist") << "0-3\n";
+    std::ofstream(root / "node1" / "cpulist") << "4-7\n";
+
+    const auto topology = gesa::concurrency::readTopology(root, {0, 1, 4, 5, 6});
+    std::filesystem::remove_all(root);
+    ASSERT_EQ(topology.nodes.size(), 2U);
+    EXPECT_EQ(topology.nodes[0].cpus, (std::vector<unsigned> {0, 1}));
+    EXPECT_EQ(topology.nodes[1].cpus, (std::vector<unsigned> {4, 5, 6}));
+
+    using gesa::concurrency::Placement;
+    const auto compact = gesa::concurrency::planPlacement(topology, 4, Placement::Compact);
+    EXPECT_EQ(compact[0].cpu, 0);
+    EXPECT_EQ(compact[1].cpu, 1);
+    EXPECT_EQ(compact[2].cpu, 4);
+    EXPECT_EQ(compact[2].node, 1U);
+
+    const auto scatter = gesa::concurrency::planPlacement(topology, 4, Placement::Scatter);
+    EXPECT_EQ(scatter[0].cpu, 0);
+    EXPECT_EQ(scatter[1].cpu, 4);
+    EXPECT_EQ(scatter[2].cpu, 1);
+    EXPECT_EQ(scatter[3].cpu, 5);
+
+    ThreadPool pinned(3, Placement::Scatter);
+    std::atomic<int> counter {0};
+    pinned.parallelFor(0, 300, 1, [&counter](std::size_t) { counter.fetch_add(1); });
+    EXPECT_EQ(counter.load(), 300);
+}
+
+TEST(WorkStealingDequeTest, OwnerAndThievesSeeEveryItemOnce)
+{
+    constexpr int kItems = 20000;
+    std::vector<int> items(kItems);
+    gesa::concurrency::WorkStealingDeque<int> deque(2);
+    std::atomic<bool> done {false};
+    std::atomic<int> taken {0};
+    std::vector<std::atomic<int>> seen(kItems);
+
+    std::vector<std::thread> thieves;
+    for (int thief = 0; thief < 3; ++thief) {
+        thieves.emplace_back([&]() {
+            while (!done.load() || !deque.empty()) {
+                if (auto* item = deque.steal()) {
+                    seen[static_cast<std::size_t>(item - items.data())].fetch_add(1);
+                    taken.fetch_add(1);
+                }
+            }
+        });
+    }
+
+    for (int index = 0; index < kItems; ++index) {
+        deque.push(&items[static_cast<std::size_t>(index)]);
+        if (index % 3 == 0) {
+            if (auto* item = deque.pop()) {
+                seen[static_cast<std::size_t>(item - items.data())].fetch_add(1);
+                taken.fetch_add(1);
+            }
+        }
+    }
+    while (auto* item = deque.pop()) {
+        seen[static_cast<std::size_t>(item - items.data())].fetch_add(1);
+        taken.fetch_add(1);
+    }
+    done.store(true);
+    for (auto& thief : thieves) {
+        thief.join();
+    }
+
+    EXPECT_EQ(taken.load(), kItems);
+    for (const auto& count : seen) {
+        EXPECT_EQ(count.load(), 1);
+    }
+}
+
 } // namespace